@@ -0,0 +1,878 @@
+// Throughput benchmarks of the hot paths of cbin.
+//
+//   cbin_bench [--format text|json|csv] [--output FILE] [--filter TEXT]
+//              [--min-time SECONDS] [--baseline FILE] [--threshold PERCENT]
+//              [--list]
+//
+// Every benchmark is timed over a number of repetitions and the fastest one
+// is reported, in nanoseconds per operation and in GB/s of encoded bytes.
+// A run saved with --format csv can be given back with --baseline, each
+// result is then compared against it and the process exits with 1 when any
+// benchmark got slower by more than the threshold, 10% by default.
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#    define _POSIX_C_SOURCE 199309L
+#endif
+#include <cbin/channel.h>
+#include <cbin/checksum.h>
+#include <cbin/compress.h>
+#include <cbin/container.h>
+#include <cbin/packed.h>
+#include <cbin/reader.h>
+#include <cbin/series.h>
+#include <cbin/thread.h>
+#include <cbin/varint.h>
+#include <cbin/writer.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+
+// Values per unit of the primitive benchmarks, small enough for the buffers
+// to stay in L1.
+#define BLOCK 1024
+#define BUFFER_SIZE ((size_t)1 << 20)
+#define REPETITIONS 5
+#define MAX_RESULTS 64
+
+typedef struct bench_s {
+    const char *name;
+    // Encoded bytes per operation, 0 when GB/s is meaningless.
+    double bytes_per_op;
+    // Operations performed by each unit of run.
+    size_t ops_per_unit;
+    void (*run)(size_t units);
+} bench_t;
+
+typedef struct bench_result_s {
+    const char *name;
+    double ns_per_op;
+    double gb_per_s;
+    double bytes_per_op;
+    unsigned long long ops;
+    bool has_baseline;
+    double baseline_ns_per_op;
+    double change;
+} bench_result_t;
+
+static uint8_t *g_input;
+static uint8_t *g_output;
+static uint8_t *g_haystack;
+static uint8_t *g_records;
+static uint8_t *g_compressed;
+static size_t g_compressed_size;
+static cbin_compressor_t g_compressor;
+static cbin_writer_t g_container;
+
+// Results are stored here so that the compiler cannot drop the work.
+static volatile uint64_t g_sink;
+
+static void bench_keep(const void *value, size_t size) {
+    uint64_t bits = 0;
+    memcpy(&bits, value, size < sizeof(bits) ? size : sizeof(bits));
+    g_sink ^= bits;
+}
+
+static double bench_now(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+// Primitive writes and reads, one value per operation.
+
+#define BENCH_WRITE(name, type, fn)                                            \
+    static void bench_write_##name(size_t units) {                             \
+        cbin_writer_t writer;                                                  \
+        cbin_writer_init_fixed(&writer, g_output, BLOCK * sizeof(type));       \
+        for (size_t i = 0; i < units; i++) {                                   \
+            cbin_writer_reset(&writer);                                        \
+            for (size_t j = 0; j < BLOCK; j++)                                 \
+                fn(&writer, (type)(i + j));                                    \
+        }                                                                      \
+        bench_keep(g_output, sizeof(type));                                    \
+    }
+#define BENCH_READ(name, type, fn)                                             \
+    static void bench_read_##name(size_t units) {                              \
+        cbin_reader_t reader;                                                  \
+        type value = 0;                                                        \
+        cbin_reader_init(&reader, g_input, BLOCK * sizeof(type));              \
+        for (size_t i = 0; i < units; i++) {                                   \
+            cbin_reader_reset(&reader);                                        \
+            for (size_t j = 0; j < BLOCK; j++)                                 \
+                fn(&reader, &value);                                           \
+        }                                                                      \
+        bench_keep(&value, sizeof(value));                                     \
+    }
+#define BENCH_PRIMITIVE(name, type)                                            \
+    BENCH_WRITE(name, type, cbin_write_##name)                                 \
+    BENCH_READ(name, type, cbin_read_##name)
+
+BENCH_PRIMITIVE(u8, uint8_t)
+BENCH_PRIMITIVE(u16_le, uint16_t)
+BENCH_PRIMITIVE(u16_be, uint16_t)
+BENCH_PRIMITIVE(u32_le, uint32_t)
+BENCH_PRIMITIVE(u32_be, uint32_t)
+BENCH_PRIMITIVE(u64_le, uint64_t)
+BENCH_PRIMITIVE(u64_be, uint64_t)
+BENCH_PRIMITIVE(f32_le, float)
+BENCH_PRIMITIVE(f32_be, float)
+BENCH_PRIMITIVE(f64_le, double)
+BENCH_PRIMITIVE(f64_be, double)
+
+// Writer growth: a fresh dynamic writer grown from 16 bytes to 1 MiB,
+// against the same writes into a writer that already has the capacity.
+
+#define GROWTH_VALUES (BUFFER_SIZE / sizeof(uint64_t))
+
+static void bench_writer_growth(size_t units) {
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_t writer;
+        cbin_writer_init_dynamic(&writer, 16);
+        for (size_t j = 0; j < GROWTH_VALUES; j++)
+            cbin_write_u64_le(&writer, j);
+        g_sink ^= cbin_writer_position(&writer);
+        cbin_writer_destroy(&writer);
+    }
+}
+static void bench_writer_warm(size_t units) {
+    cbin_writer_t writer;
+    cbin_writer_init_dynamic(&writer, BUFFER_SIZE);
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_reset(&writer);
+        for (size_t j = 0; j < GROWTH_VALUES; j++)
+            cbin_write_u64_le(&writer, j);
+    }
+    g_sink ^= cbin_writer_position(&writer);
+    cbin_writer_destroy(&writer);
+}
+
+// A 128-byte message, the common case that an inline writer keeps off the
+// heap.
+#define SMALL_VALUES 16
+static void bench_writer_small_dynamic(size_t units) {
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_t writer;
+        cbin_writer_init_dynamic(&writer, 256);
+        for (size_t j = 0; j < SMALL_VALUES; j++)
+            cbin_write_u64_le(&writer, j);
+        g_sink ^= cbin_writer_position(&writer);
+        cbin_writer_destroy(&writer);
+    }
+}
+static void bench_writer_small_inline(size_t units) {
+    for (size_t i = 0; i < units; i++) {
+        uint8_t storage[256];
+        cbin_writer_t writer;
+        cbin_writer_init_inline(&writer, storage, sizeof(storage));
+        for (size_t j = 0; j < SMALL_VALUES; j++)
+            cbin_write_u64_le(&writer, j);
+        g_sink ^= cbin_writer_position(&writer);
+        cbin_writer_destroy(&writer);
+    }
+}
+
+// Scanning a whole buffer for a byte that only appears at its end.
+static void bench_find(size_t units) {
+    cbin_reader_t reader;
+    size_t position = 0;
+    cbin_reader_init(&reader, g_haystack, BUFFER_SIZE);
+    for (size_t i = 0; i < units; i++) {
+        cbin_reader_reset(&reader);
+        cbin_reader_find(&reader, 0xFF, &position);
+    }
+    g_sink ^= position;
+}
+
+// Mixed records of both endiannesses, 27 bytes each.
+
+#define RECORD_SIZE 27
+
+static void bench_record_encode(size_t units) {
+    cbin_writer_t writer;
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * RECORD_SIZE);
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_reset(&writer);
+        for (size_t j = 0; j < BLOCK; j++) {
+            cbin_write_u32_le(&writer, (uint32_t)j);
+            cbin_write_u64_le(&writer, i * BLOCK + j);
+            cbin_write_f64_le(&writer, (double)j * 0.5);
+            cbin_write_u16_be(&writer, (uint16_t)j);
+            cbin_write_u8(&writer, (uint8_t)j);
+            cbin_write_i32_be(&writer, -(int32_t)j);
+        }
+    }
+    bench_keep(g_output, RECORD_SIZE);
+}
+static void bench_record_decode(size_t units) {
+    cbin_reader_t reader;
+    uint32_t id = 0;
+    uint64_t timestamp = 0;
+    double value = 0;
+    uint16_t flags = 0;
+    uint8_t kind = 0;
+    int32_t delta = 0;
+    cbin_reader_init(&reader, g_input, BLOCK * RECORD_SIZE);
+    for (size_t i = 0; i < units; i++) {
+        cbin_reader_reset(&reader);
+        for (size_t j = 0; j < BLOCK; j++) {
+            cbin_read_u32_le(&reader, &id);
+            cbin_read_u64_le(&reader, &timestamp);
+            cbin_read_f64_le(&reader, &value);
+            cbin_read_u16_be(&reader, &flags);
+            cbin_read_u8(&reader, &kind);
+            cbin_read_i32_be(&reader, &delta);
+        }
+    }
+    g_sink ^= id + timestamp + flags + kind + (uint64_t)delta;
+    bench_keep(&value, sizeof(value));
+}
+
+// The same records behind a single bounds check per block.
+static void bench_record_encode_unchecked(size_t units) {
+    cbin_writer_t writer;
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * RECORD_SIZE);
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_reset(&writer);
+        if (cbin_writer_ensure(&writer, BLOCK * RECORD_SIZE))
+            return;
+        for (size_t j = 0; j < BLOCK; j++) {
+            cbin_write_u32_le_unchecked(&writer, (uint32_t)j);
+            cbin_write_u64_le_unchecked(&writer, i * BLOCK + j);
+            cbin_write_f64_le_unchecked(&writer, (double)j * 0.5);
+            cbin_write_u16_be_unchecked(&writer, (uint16_t)j);
+            cbin_write_u8_unchecked(&writer, (uint8_t)j);
+            cbin_write_i32_be_unchecked(&writer, -(int32_t)j);
+        }
+    }
+    bench_keep(g_output, RECORD_SIZE);
+}
+static void bench_record_decode_unchecked(size_t units) {
+    cbin_reader_t reader;
+    uint32_t id = 0;
+    uint64_t timestamp = 0;
+    double value = 0;
+    uint16_t flags = 0;
+    uint8_t kind = 0;
+    int32_t delta = 0;
+    cbin_reader_init(&reader, g_input, BLOCK * RECORD_SIZE);
+    for (size_t i = 0; i < units; i++) {
+        cbin_reader_reset(&reader);
+        if (cbin_reader_ensure(&reader, BLOCK * RECORD_SIZE))
+            return;
+        for (size_t j = 0; j < BLOCK; j++) {
+            id = cbin_read_u32_le_unchecked(&reader);
+            timestamp = cbin_read_u64_le_unchecked(&reader);
+            value = cbin_read_f64_le_unchecked(&reader);
+            flags = cbin_read_u16_be_unchecked(&reader);
+            kind = cbin_read_u8_unchecked(&reader);
+            delta = cbin_read_i32_be_unchecked(&reader);
+        }
+    }
+    g_sink ^= id + timestamp + flags + kind + (uint64_t)delta;
+    bench_keep(&value, sizeof(value));
+}
+
+// Varints of 1 to 5 bytes.
+
+static void bench_varint_write(size_t units) {
+    cbin_writer_t writer;
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * 10);
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_reset(&writer);
+        for (size_t j = 0; j < BLOCK; j++)
+            cbin_write_varu64(&writer, (uint64_t)j << (j % 5 * 7));
+    }
+    g_sink ^= cbin_writer_position(&writer);
+}
+static void bench_varint_read(size_t units) {
+    cbin_writer_t writer;
+    cbin_reader_t reader;
+    uint64_t value = 0;
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * 10);
+    for (size_t j = 0; j < BLOCK; j++)
+        cbin_write_varu64(&writer, (uint64_t)j << (j % 5 * 7));
+    cbin_reader_init(&reader, g_output, cbin_writer_position(&writer));
+    for (size_t i = 0; i < units; i++) {
+        cbin_reader_reset(&reader);
+        for (size_t j = 0; j < BLOCK; j++)
+            cbin_read_varu64(&reader, &value);
+    }
+    g_sink ^= value;
+}
+
+// A slowly changing sensor series sampled every second.
+
+static double g_samples[BLOCK];
+static int64_t g_timestamps[BLOCK];
+
+static void bench_series_fill(void) {
+    double value = 20.0;
+    for (size_t j = 0; j < BLOCK; j++) {
+        if (j % 4 == 0)
+            value += (double)((int)(j * 7 % 11) - 5) * 0.25;
+        g_samples[j] = value;
+        g_timestamps[j] = 1700000000000ll + (int64_t)j * 1000 + (j % 16 == 0);
+    }
+}
+static void bench_series_write(size_t units) {
+    cbin_writer_t writer;
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * 20);
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_reset(&writer);
+        cbin_write_xor_f64_array(&writer, g_samples, BLOCK);
+        cbin_write_dod_i64_array(&writer, g_timestamps, BLOCK);
+    }
+    g_sink ^= cbin_writer_position(&writer);
+}
+static void bench_series_read(size_t units) {
+    cbin_writer_t writer;
+    cbin_reader_t reader;
+    static double samples[BLOCK];
+    static int64_t timestamps[BLOCK];
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * 20);
+    cbin_write_xor_f64_array(&writer, g_samples, BLOCK);
+    cbin_write_dod_i64_array(&writer, g_timestamps, BLOCK);
+    cbin_reader_init(&reader, g_output, cbin_writer_position(&writer));
+    for (size_t i = 0; i < units; i++) {
+        cbin_reader_reset(&reader);
+        cbin_read_xor_f64_array(&reader, samples, BLOCK);
+        cbin_read_dod_i64_array(&reader, timestamps, BLOCK);
+    }
+    g_sink ^= (uint64_t)timestamps[BLOCK - 1];
+}
+
+// Sorted IDs with small random gaps, bit-packed as deltas.
+
+static uint32_t g_ids[BLOCK];
+
+static void bench_packed_fill(void) {
+    uint32_t id = 1000;
+    for (size_t j = 0; j < BLOCK; j++) {
+        id += 1 + g_input[j] % 64;
+        g_ids[j] = id;
+    }
+}
+static void bench_packed_write(size_t units) {
+    cbin_writer_t writer;
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * 8);
+    for (size_t i = 0; i < units; i++) {
+        cbin_writer_reset(&writer);
+        cbin_write_u32_delta_packed_array(&writer, g_ids, BLOCK);
+    }
+    g_sink ^= cbin_writer_position(&writer);
+}
+static void bench_packed_read(size_t units) {
+    cbin_writer_t writer;
+    cbin_reader_t reader;
+    static uint32_t ids[BLOCK];
+    cbin_writer_init_fixed(&writer, g_output, BLOCK * 8);
+    cbin_write_u32_delta_packed_array(&writer, g_ids, BLOCK);
+    cbin_reader_init(&reader, g_output, cbin_writer_position(&writer));
+    for (size_t i = 0; i < units; i++) {
+        cbin_reader_reset(&reader);
+        cbin_read_u32_delta_packed_array(&reader, ids, BLOCK);
+    }
+    g_sink ^= ids[BLOCK - 1];
+}
+
+// Checksums and compression over 64 KiB.
+
+#define CHUNK_SIZE ((size_t)64 << 10)
+
+static void bench_crc32c(size_t units) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < units; i++)
+        crc = cbin_crc32c(crc, g_input, CHUNK_SIZE);
+    g_sink ^= crc;
+}
+static void bench_xxh64(size_t units) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < units; i++)
+        hash ^= cbin_xxh64(g_input, CHUNK_SIZE, i);
+    g_sink ^= hash;
+}
+static void bench_compress(size_t units) {
+    size_t size = 0;
+    for (size_t i = 0; i < units; i++) {
+        cbin_compress(&g_compressor, g_records, CHUNK_SIZE, g_output,
+                      BUFFER_SIZE, &size);
+    }
+    g_sink ^= size;
+}
+static void bench_decompress(size_t units) {
+    size_t size = 0;
+    for (size_t i = 0; i < units; i++) {
+        cbin_decompress(g_compressed, g_compressed_size, g_output, BUFFER_SIZE,
+                        &size);
+    }
+    g_sink ^= size;
+}
+
+// The encoded records split into frames of a container, decoded on a
+// growing number of threads to check how decoding scales.
+
+#define FRAME_RECORDS 150
+#define FRAME_SIZE (FRAME_RECORDS * RECORD_SIZE)
+#define CONTAINER_SIZE (BUFFER_SIZE / FRAME_SIZE * FRAME_SIZE)
+
+static volatile size_t g_decoded;
+
+static cbin_err_t bench_decode_frame(void *user_data, size_t index,
+                                     cbin_reader_t *reader) {
+    (void)user_data;
+    (void)index;
+    uint64_t sum = 0;
+    for (size_t j = 0; j < FRAME_RECORDS; j++) {
+        uint32_t id = 0;
+        uint64_t timestamp = 0;
+        double value = 0;
+        uint16_t flags = 0;
+        uint8_t kind = 0;
+        int32_t delta = 0;
+        cbin_read_u32_le(reader, &id);
+        cbin_read_u64_le(reader, &timestamp);
+        cbin_read_f64_le(reader, &value);
+        cbin_read_u16_be(reader, &flags);
+        cbin_read_u8(reader, &kind);
+        cbin_read_i32_be(reader, &delta);
+        sum += id + timestamp + (uint64_t)value + flags + kind +
+               (uint64_t)delta;
+    }
+    cbin_atomic_fetch_add(&g_decoded, (size_t)sum);
+    return cbin_reader_error(reader);
+}
+
+static bool bench_container_fill(void) {
+    if (cbin_writer_init_dynamic(&g_container, BUFFER_SIZE + BUFFER_SIZE / 8))
+        return false;
+    cbin_container_writer_t container;
+    if (cbin_container_writer_init(&container, &g_container))
+        return false;
+    for (size_t start = 0; start < CONTAINER_SIZE; start += FRAME_SIZE)
+        cbin_container_write_frame(&container, g_records + start, FRAME_SIZE);
+    cbin_err_t err = cbin_container_finish(&container);
+    cbin_container_writer_destroy(&container);
+    return err == CBIN_ERR_OK;
+}
+
+static void bench_container_decode(size_t units, size_t threads) {
+    cbin_container_t container;
+    if (cbin_container_open(&container, cbin_writer_buffer(&g_container),
+                            cbin_writer_position(&g_container)))
+        return;
+    for (size_t i = 0; i < units; i++) {
+        cbin_container_decode_parallel(&container, threads,
+                                       bench_decode_frame, NULL);
+    }
+    g_sink ^= g_decoded;
+}
+
+#define BENCH_CONTAINER_DECODE(threads)                                        \
+    static void bench_container_decode_##threads(size_t units) {               \
+        bench_container_decode(units, threads);                                \
+    }
+
+BENCH_CONTAINER_DECODE(1)
+BENCH_CONTAINER_DECODE(2)
+BENCH_CONTAINER_DECODE(4)
+BENCH_CONTAINER_DECODE(8)
+
+// Messages of two u64 passed through a channel, in the same thread to time
+// the bookkeeping alone and between two threads for the hand-over.
+
+#define CHANNEL_SIZE ((size_t)64 << 10)
+#define CHANNEL_MESSAGE (2 * sizeof(uint64_t))
+
+static void bench_channel_send(cbin_channel_t *channel, uint64_t value) {
+    cbin_writer_t writer;
+    while (cbin_channel_reserve(channel, &writer, CHANNEL_MESSAGE))
+        cbin_thread_yield();
+    cbin_write_u64_le(&writer, value);
+    cbin_write_u64_le(&writer, ~value);
+    cbin_channel_publish(channel, &writer);
+}
+static uint64_t bench_channel_receive(cbin_channel_t *channel) {
+    cbin_reader_t reader;
+    uint64_t a = 0, b = 0;
+    while (cbin_channel_receive(channel, &reader))
+        cbin_thread_yield();
+    cbin_read_u64_le(&reader, &a);
+    cbin_read_u64_le(&reader, &b);
+    cbin_channel_release(channel, &reader);
+    return a ^ b;
+}
+static void bench_channel(size_t units, unsigned flags) {
+    cbin_channel_t channel;
+    if (cbin_channel_init(&channel, CHANNEL_SIZE, flags))
+        return;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < units; i++) {
+        for (size_t j = 0; j < BLOCK; j++)
+            bench_channel_send(&channel, j);
+        for (size_t j = 0; j < BLOCK; j++)
+            sum += bench_channel_receive(&channel);
+    }
+    cbin_channel_destroy(&channel);
+    g_sink ^= sum;
+}
+static void bench_channel_spsc(size_t units) { bench_channel(units, 0); }
+static void bench_channel_mpsc(size_t units) {
+    bench_channel(units, CBIN_CHANNEL_MPSC);
+}
+
+typedef struct bench_producer_s {
+    cbin_channel_t *channel;
+    size_t count;
+} bench_producer_t;
+
+static void bench_channel_producer(void *arg) {
+    bench_producer_t *producer = (bench_producer_t *)arg;
+    for (size_t j = 0; j < producer->count; j++)
+        bench_channel_send(producer->channel, j);
+}
+static void bench_channel_threads(size_t units) {
+    cbin_channel_t channel;
+    if (cbin_channel_init(&channel, CHANNEL_SIZE, 0))
+        return;
+    bench_producer_t producer = {&channel, units * BLOCK};
+    cbin_thread_t thread;
+    uint64_t sum = 0;
+    if (cbin_thread_create(&thread, bench_channel_producer, &producer)) {
+        for (size_t j = 0; j < producer.count; j++)
+            sum += bench_channel_receive(&channel);
+        cbin_thread_join(thread);
+    }
+    cbin_channel_destroy(&channel);
+    g_sink ^= sum;
+}
+
+#define PRIMITIVE(name, type)                                                  \
+    {"write_" #name, sizeof(type), BLOCK, bench_write_##name},                 \
+        {"read_" #name, sizeof(type), BLOCK, bench_read_##name}
+
+static const bench_t g_benches[] = {
+    PRIMITIVE(u8, uint8_t),
+    PRIMITIVE(u16_le, uint16_t),
+    PRIMITIVE(u16_be, uint16_t),
+    PRIMITIVE(u32_le, uint32_t),
+    PRIMITIVE(u32_be, uint32_t),
+    PRIMITIVE(u64_le, uint64_t),
+    PRIMITIVE(u64_be, uint64_t),
+    PRIMITIVE(f32_le, float),
+    PRIMITIVE(f32_be, float),
+    PRIMITIVE(f64_le, double),
+    PRIMITIVE(f64_be, double),
+    {"writer_growth_u64", sizeof(uint64_t), GROWTH_VALUES,
+     bench_writer_growth},
+    {"writer_warm_u64", sizeof(uint64_t), GROWTH_VALUES, bench_writer_warm},
+    {"writer_small_dynamic", sizeof(uint64_t) * SMALL_VALUES, 1,
+     bench_writer_small_dynamic},
+    {"writer_small_inline", sizeof(uint64_t) * SMALL_VALUES, 1,
+     bench_writer_small_inline},
+    {"reader_find_1mib", BUFFER_SIZE, 1, bench_find},
+    {"record_encode", RECORD_SIZE, BLOCK, bench_record_encode},
+    {"record_decode", RECORD_SIZE, BLOCK, bench_record_decode},
+    {"record_encode_unchecked", RECORD_SIZE, BLOCK,
+     bench_record_encode_unchecked},
+    {"record_decode_unchecked", RECORD_SIZE, BLOCK,
+     bench_record_decode_unchecked},
+    {"varint_write", 0, BLOCK, bench_varint_write},
+    {"varint_read", 0, BLOCK, bench_varint_read},
+    {"series_write", 0, BLOCK, bench_series_write},
+    {"series_read", 0, BLOCK, bench_series_read},
+    {"packed_write", sizeof(uint32_t), BLOCK, bench_packed_write},
+    {"packed_read", sizeof(uint32_t), BLOCK, bench_packed_read},
+    {"channel_spsc", CHANNEL_MESSAGE, BLOCK, bench_channel_spsc},
+    {"channel_mpsc", CHANNEL_MESSAGE, BLOCK, bench_channel_mpsc},
+    {"channel_spsc_threads", CHANNEL_MESSAGE, BLOCK, bench_channel_threads},
+    {"container_decode_parallel_1", CONTAINER_SIZE, 1,
+     bench_container_decode_1},
+    {"container_decode_parallel_2", CONTAINER_SIZE, 1,
+     bench_container_decode_2},
+    {"container_decode_parallel_4", CONTAINER_SIZE, 1,
+     bench_container_decode_4},
+    {"container_decode_parallel_8", CONTAINER_SIZE, 1,
+     bench_container_decode_8},
+    {"crc32c_64k", CHUNK_SIZE, 1, bench_crc32c},
+    {"xxh64_64k", CHUNK_SIZE, 1, bench_xxh64},
+    {"compress_64k", CHUNK_SIZE, 1, bench_compress},
+    {"decompress_64k", CHUNK_SIZE, 1, bench_decompress},
+};
+#define BENCH_COUNT (sizeof(g_benches) / sizeof(g_benches[0]))
+
+static bool bench_setup(void) {
+    g_input = (uint8_t *)malloc(BUFFER_SIZE);
+    g_output = (uint8_t *)malloc(BUFFER_SIZE);
+    g_haystack = (uint8_t *)malloc(BUFFER_SIZE);
+    g_records = (uint8_t *)malloc(BUFFER_SIZE);
+    g_compressed = (uint8_t *)malloc(cbin_compress_bound(CHUNK_SIZE));
+    if (!g_input || !g_output || !g_haystack || !g_records || !g_compressed ||
+        cbin_compressor_init(&g_compressor))
+        return false;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < BUFFER_SIZE; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        g_input[i] = (uint8_t)state;
+    }
+    // The scan target only appears in the last byte.
+    memset(g_haystack, 0, BUFFER_SIZE);
+    g_haystack[BUFFER_SIZE - 1] = 0xFF;
+    bench_series_fill();
+    bench_packed_fill();
+
+    // Encoded records, as a realistic input for the compressor.
+    cbin_writer_t writer;
+    cbin_writer_init_fixed(&writer, g_records, BUFFER_SIZE);
+    for (size_t j = 0; cbin_writer_position(&writer) + RECORD_SIZE <=
+                       BUFFER_SIZE;
+         j++) {
+        cbin_write_u32_le(&writer, (uint32_t)(j % 97));
+        cbin_write_u64_le(&writer, 1700000000000ull + j * 250);
+        cbin_write_f64_le(&writer, (double)(j % 13) * 0.25);
+        cbin_write_u16_be(&writer, (uint16_t)(j & 7));
+        cbin_write_u8(&writer, (uint8_t)(j % 3));
+        cbin_write_i32_be(&writer, (int32_t)(j % 17) - 8);
+    }
+    if (!bench_container_fill())
+        return false;
+    return cbin_compress(&g_compressor, g_records, CHUNK_SIZE, g_compressed,
+                         cbin_compress_bound(CHUNK_SIZE),
+                         &g_compressed_size) == CBIN_ERR_OK;
+}
+
+static void bench_teardown(void) {
+    cbin_compressor_destroy(&g_compressor);
+    cbin_writer_destroy(&g_container);
+    free(g_input);
+    free(g_output);
+    free(g_haystack);
+    free(g_records);
+    free(g_compressed);
+}
+
+// Doubles the number of units until a run is long enough to be timed, then
+// keeps the fastest of a few repetitions of about min_time in total.
+static void bench_run(const bench_t *bench, double min_time,
+                      bench_result_t *result) {
+    size_t units = 1;
+    double elapsed;
+    for (;;) {
+        double start = bench_now();
+        bench->run(units);
+        elapsed = bench_now() - start;
+        if (elapsed >= min_time / (REPETITIONS * 4) || units >= (1u << 30))
+            break;
+        units *= 2;
+    }
+    double target = min_time / REPETITIONS;
+    if (elapsed < target)
+        units = (size_t)((double)units * target / (elapsed > 0 ? elapsed
+                                                                : target));
+    if (units == 0)
+        units = 1;
+    double best = -1;
+    for (int i = 0; i < REPETITIONS; i++) {
+        double start = bench_now();
+        bench->run(units);
+        elapsed = bench_now() - start;
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+    }
+    double ops = (double)units * (double)bench->ops_per_unit;
+    result->name = bench->name;
+    result->ops = (unsigned long long)ops;
+    result->ns_per_op = best * 1e9 / ops;
+    result->bytes_per_op = bench->bytes_per_op;
+    result->gb_per_s =
+        bench->bytes_per_op ? bench->bytes_per_op / result->ns_per_op : 0;
+    result->has_baseline = false;
+}
+
+// Reads a baseline saved with --format csv and attaches it to the results.
+static bool bench_load_baseline(const char *path, bench_result_t *results,
+                                size_t count) {
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return false;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        char *comma = strchr(line, ',');
+        if (!comma)
+            continue;
+        *comma = '\0';
+        char *end;
+        double ns = strtod(comma + 1, &end);
+        if (end == comma + 1 || ns <= 0)
+            continue;
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(results[i].name, line) == 0) {
+                results[i].has_baseline = true;
+                results[i].baseline_ns_per_op = ns;
+                results[i].change = (results[i].ns_per_op - ns) / ns * 100;
+            }
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static void bench_print_text(FILE *out, const bench_result_t *results,
+                             size_t count, double threshold) {
+    fprintf(out, "%-28s %12s %10s\n", "benchmark", "ns/op", "GB/s");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "%-28s %12.3f %10.3f", r->name, r->ns_per_op,
+                r->gb_per_s);
+        if (r->has_baseline) {
+            fprintf(out, "  %+7.1f%% vs %.3f%s", r->change,
+                    r->baseline_ns_per_op,
+                    r->change > threshold ? "  REGRESSED" : "");
+        }
+        fputc('\n', out);
+    }
+}
+
+static void bench_print_csv(FILE *out, const bench_result_t *results,
+                            size_t count) {
+    fprintf(out, "name,ns_per_op,gb_per_s,bytes_per_op,ops,"
+                 "baseline_ns_per_op,change_percent\n");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "%s,%.6f,%.6f,%.0f,%llu,", r->name, r->ns_per_op,
+                r->gb_per_s, r->bytes_per_op, r->ops);
+        if (r->has_baseline)
+            fprintf(out, "%.6f,%.3f", r->baseline_ns_per_op, r->change);
+        else
+            fputc(',', out);
+        fputc('\n', out);
+    }
+}
+
+static void bench_print_json(FILE *out, const bench_result_t *results,
+                             size_t count, double threshold) {
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out,
+                "    {\"name\": \"%s\", \"ns_per_op\": %.6f, "
+                "\"gb_per_s\": %.6f, \"bytes_per_op\": %.0f, \"ops\": %llu",
+                r->name, r->ns_per_op, r->gb_per_s, r->bytes_per_op, r->ops);
+        if (r->has_baseline) {
+            fprintf(out,
+                    ", \"baseline_ns_per_op\": %.6f, "
+                    "\"change_percent\": %.3f, \"regressed\": %s",
+                    r->baseline_ns_per_op, r->change,
+                    r->change > threshold ? "true" : "false");
+        }
+        fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static int bench_usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [--format text|json|csv] [--output FILE] "
+            "[--filter TEXT]\n"
+            "          [--min-time SECONDS] [--baseline FILE] "
+            "[--threshold PERCENT] [--list]\n",
+            program);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *format = "text";
+    const char *output = NULL;
+    const char *filter = NULL;
+    const char *baseline = NULL;
+    double min_time = 0.5;
+    double threshold = 10;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--list") == 0) {
+            for (size_t j = 0; j < BENCH_COUNT; j++)
+                printf("%s\n", g_benches[j].name);
+            return 0;
+        }
+        if (!value)
+            return bench_usage(argv[0]);
+        if (strcmp(arg, "--format") == 0)
+            format = value;
+        else if (strcmp(arg, "--output") == 0)
+            output = value;
+        else if (strcmp(arg, "--filter") == 0)
+            filter = value;
+        else if (strcmp(arg, "--baseline") == 0)
+            baseline = value;
+        else if (strcmp(arg, "--min-time") == 0)
+            min_time = atof(value);
+        else if (strcmp(arg, "--threshold") == 0)
+            threshold = atof(value);
+        else
+            return bench_usage(argv[0]);
+        i++;
+    }
+    if (strcmp(format, "text") != 0 && strcmp(format, "json") != 0 &&
+        strcmp(format, "csv") != 0)
+        return bench_usage(argv[0]);
+    if (min_time <= 0)
+        min_time = 0.5;
+
+    if (!bench_setup()) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    bench_result_t results[MAX_RESULTS];
+    size_t count = 0;
+    for (size_t i = 0; i < BENCH_COUNT && count < MAX_RESULTS; i++) {
+        if (filter && !strstr(g_benches[i].name, filter))
+            continue;
+        bench_run(&g_benches[i], min_time, &results[count++]);
+    }
+    bench_teardown();
+
+    if (baseline && !bench_load_baseline(baseline, results, count)) {
+        fprintf(stderr, "cannot read baseline %s\n", baseline);
+        return 1;
+    }
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", output);
+        return 1;
+    }
+    if (strcmp(format, "json") == 0)
+        bench_print_json(out, results, count, threshold);
+    else if (strcmp(format, "csv") == 0)
+        bench_print_csv(out, results, count);
+    else
+        bench_print_text(out, results, count, threshold);
+    if (out != stdout)
+        fclose(out);
+
+    int regressed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].has_baseline && results[i].change > threshold) {
+            fprintf(stderr, "%s regressed by %.1f%%\n", results[i].name,
+                    results[i].change);
+            regressed = 1;
+        }
+    }
+    return regressed;
+}
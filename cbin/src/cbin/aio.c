@@ -0,0 +1,581 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE
+#endif
+#include "aio.h"
+#include "thread.h"
+#include <string.h>
+
+#if defined(_WIN32)
+#    include <io.h>
+#else
+#    include <errno.h>
+#    include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#    if __has_include(<linux/io_uring.h>)
+#        include <linux/io_uring.h>
+#        include <sys/mman.h>
+#        include <sys/syscall.h>
+#        include <sys/uio.h>
+#        if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#            define CBIN_HAVE_IO_URING
+#        endif
+#    endif
+#endif
+
+enum {
+    CBIN_AIO_FREE,
+    CBIN_AIO_PENDING,
+    CBIN_AIO_DONE,
+};
+
+typedef struct cbin_aio_buffer_s {
+    uint8_t *data;
+    // Bytes to transfer: the buffer size for reads, the bytes filled by the
+    // writer for writes.
+    size_t size;
+    size_t done;
+    // Bytes of a completed read handed to the reader.
+    size_t consumed;
+    uint64_t offset;
+    int state;
+    cbin_err_t error;
+    // The submission number of the pending transfer of the worker thread.
+    uint64_t ticket;
+} cbin_aio_buffer_t;
+
+static bool cbin_aio_transfer(cbin_aio_t *aio, cbin_aio_buffer_t *buffer,
+                              cbin_err_t *error);
+
+// The worker thread performs the transfers one after the other, in the
+// order they were submitted. Only the counters are shared, the state of the
+// buffers belongs to the calling thread.
+typedef struct cbin_aio_worker_s {
+    cbin_thread_t thread;
+    cbin_mutex_t lock;
+    cbin_cond_t submitted_cond;
+    cbin_cond_t completed_cond;
+    uint64_t submitted;
+    uint64_t completed;
+    bool stop;
+} cbin_aio_worker_t;
+
+static void cbin_aio_work(void *arg) {
+    cbin_aio_t *aio = (cbin_aio_t *)arg;
+    cbin_aio_worker_t *worker = aio->_worker;
+    cbin_mutex_lock(&worker->lock);
+    for (;;) {
+        if (worker->completed == worker->submitted) {
+            if (worker->stop)
+                break;
+            cbin_cond_wait(&worker->submitted_cond, &worker->lock);
+            continue;
+        }
+        cbin_aio_buffer_t *buffer =
+            &aio->_buffers[worker->completed % aio->_depth];
+        cbin_mutex_unlock(&worker->lock);
+        cbin_err_t error = CBIN_ERR_OK;
+        while (buffer->done < buffer->size &&
+               cbin_aio_transfer(aio, buffer, &error))
+            ;
+        buffer->error = error;
+        cbin_mutex_lock(&worker->lock);
+        worker->completed++;
+        cbin_cond_broadcast(&worker->completed_cond);
+    }
+    cbin_mutex_unlock(&worker->lock);
+}
+
+// Transfers the next part of a buffer synchronously, returning false once
+// nothing more can be transferred.
+static bool cbin_aio_transfer(cbin_aio_t *aio, cbin_aio_buffer_t *buffer,
+                              cbin_err_t *error) {
+    uint8_t *data = buffer->data + buffer->done;
+    size_t size = buffer->size - buffer->done;
+    uint64_t offset = buffer->offset + buffer->done;
+#if defined(_WIN32)
+    unsigned chunk = size > 0x40000000u ? 0x40000000u : (unsigned)size;
+    int n = -1;
+    if (_lseeki64(aio->_fd, (__int64)offset, SEEK_SET) >= 0)
+        n = aio->_sink ? _write(aio->_fd, data, chunk)
+                       : _read(aio->_fd, data, chunk);
+#else
+    ssize_t n;
+    do {
+        n = aio->_sink ? pwrite(aio->_fd, data, size, (off_t)offset)
+                       : pread(aio->_fd, data, size, (off_t)offset);
+    } while (n < 0 && errno == EINTR);
+#endif
+    if (n < 0 || (n == 0 && aio->_sink)) {
+        *error = CBIN_ERR_IO;
+        return false;
+    }
+    buffer->done += (size_t)n;
+    return n > 0;
+}
+
+#if defined(CBIN_HAVE_IO_URING)
+
+// A ring set up through the raw system calls, so that no liburing is
+// needed. Each buffer has at most one request in flight, a ring with one
+// entry per buffer never overflows.
+typedef struct cbin_aio_ring_s {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map;
+    size_t sq_map_size;
+    void *cq_map;
+    size_t cq_map_size;
+    size_t sqes_size;
+    struct iovec iov[CBIN_AIO_MAX_DEPTH];
+} cbin_aio_ring_t;
+
+static void cbin_aio_ring_close(cbin_aio_ring_t *ring) {
+    if (ring->sqes)
+        munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_map && ring->cq_map != ring->sq_map)
+        munmap(ring->cq_map, ring->cq_map_size);
+    if (ring->sq_map)
+        munmap(ring->sq_map, ring->sq_map_size);
+    close(ring->fd);
+    CBIN_FREE(ring);
+}
+
+static cbin_aio_ring_t *cbin_aio_ring_open(size_t depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, (unsigned)depth, &params);
+    if (fd < 0)
+        return NULL;
+    cbin_aio_ring_t *ring =
+        (cbin_aio_ring_t *)CBIN_REALLOC(NULL, sizeof(cbin_aio_ring_t));
+    if (!ring) {
+        close(fd);
+        return NULL;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = fd;
+    ring->sq_map_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes +
+                        params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = false;
+#    ifdef IORING_FEAT_SINGLE_MMAP
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        single = true;
+        if (ring->cq_map_size > ring->sq_map_size)
+            ring->sq_map_size = ring->cq_map_size;
+        ring->cq_map_size = ring->sq_map_size;
+    }
+#    endif
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) {
+        ring->sq_map = NULL;
+        cbin_aio_ring_close(ring);
+        return NULL;
+    }
+    ring->cq_map = single ? ring->sq_map
+                          : mmap(NULL, ring->cq_map_size,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd,
+                                 IORING_OFF_CQ_RING);
+    if (ring->cq_map == MAP_FAILED) {
+        ring->cq_map = NULL;
+        cbin_aio_ring_close(ring);
+        return NULL;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *)mmap(
+        NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        cbin_aio_ring_close(ring);
+        return NULL;
+    }
+    uint8_t *sq = (uint8_t *)ring->sq_map;
+    uint8_t *cq = (uint8_t *)ring->cq_map;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return ring;
+}
+
+static int cbin_aio_ring_enter(cbin_aio_ring_t *ring, unsigned submit,
+                               unsigned wait) {
+    long n;
+    do {
+        n = syscall(__NR_io_uring_enter, ring->fd, submit, wait,
+                    wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (n < 0 && errno == EINTR);
+    return n < 0 ? -1 : 0;
+}
+
+// Vectored requests rather than IORING_OP_READ and IORING_OP_WRITE, which
+// need a newer kernel.
+static bool cbin_aio_ring_submit(cbin_aio_t *aio, size_t index) {
+    cbin_aio_ring_t *ring = aio->_ring;
+    cbin_aio_buffer_t *buffer = &aio->_buffers[index];
+    ring->iov[index].iov_base = buffer->data + buffer->done;
+    ring->iov[index].iov_len = buffer->size - buffer->done;
+    unsigned tail = *ring->sq_tail;
+    unsigned slot = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = aio->_sink ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = aio->_fd;
+    sqe->addr = (uint64_t)(uintptr_t)&ring->iov[index];
+    sqe->len = 1;
+    sqe->off = buffer->offset + buffer->done;
+    sqe->user_data = index;
+    ring->sq_array[slot] = slot;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    if (cbin_aio_ring_enter(ring, 1, 0) == 0)
+        return true;
+    // Without a polling thread the kernel only takes entries during the
+    // call. One it took completes through the ring like any other, one it
+    // left is withdrawn so that no completion arrives for a failed buffer.
+    if (__atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) != tail)
+        return true;
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+    return false;
+}
+
+// Reaps one completion, waiting for it if none is ready. Short transfers
+// are resubmitted for the rest of the buffer, a read only completes once
+// it is full or reaches the end of the file.
+static void cbin_aio_ring_reap(cbin_aio_t *aio) {
+    cbin_aio_ring_t *ring = aio->_ring;
+    unsigned head = *ring->cq_head;
+    while (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        if (cbin_aio_ring_enter(ring, 0, 1)) {
+            // The ring is unusable, fail every request in flight.
+            for (size_t i = 0; i < aio->_depth; i++) {
+                if (aio->_buffers[i].state == CBIN_AIO_PENDING) {
+                    aio->_buffers[i].error = CBIN_ERR_IO;
+                    aio->_buffers[i].state = CBIN_AIO_DONE;
+                }
+            }
+            return;
+        }
+    }
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+    size_t index = (size_t)cqe->user_data;
+    int result = cqe->res;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+    cbin_aio_buffer_t *buffer = &aio->_buffers[index];
+    if (result == -EINTR || result == -EAGAIN) {
+        if (cbin_aio_ring_submit(aio, index))
+            return;
+    } else if (result > 0 || (result == 0 && !aio->_sink)) {
+        buffer->done += (size_t)result;
+        if (result == 0 || buffer->done == buffer->size ||
+            cbin_aio_ring_submit(aio, index)) {
+            if (result == 0 || buffer->done == buffer->size)
+                buffer->state = CBIN_AIO_DONE;
+            return;
+        }
+    }
+    buffer->error = CBIN_ERR_IO;
+    buffer->state = CBIN_AIO_DONE;
+}
+
+#endif
+
+static cbin_err_t cbin_aio_submit(cbin_aio_t *aio, size_t index) {
+    cbin_aio_buffer_t *buffer = &aio->_buffers[index];
+    buffer->done = 0;
+    buffer->consumed = 0;
+    buffer->error = CBIN_ERR_OK;
+#if defined(CBIN_HAVE_IO_URING)
+    if (aio->_ring) {
+        buffer->state = CBIN_AIO_PENDING;
+        if (!cbin_aio_ring_submit(aio, index)) {
+            buffer->state = CBIN_AIO_DONE;
+            return buffer->error = CBIN_ERR_IO;
+        }
+        return CBIN_ERR_OK;
+    }
+#endif
+    cbin_aio_worker_t *worker = aio->_worker;
+    buffer->state = CBIN_AIO_PENDING;
+    cbin_mutex_lock(&worker->lock);
+    buffer->ticket = worker->submitted++;
+    cbin_cond_broadcast(&worker->submitted_cond);
+    cbin_mutex_unlock(&worker->lock);
+    return CBIN_ERR_OK;
+}
+
+static void cbin_aio_wait(cbin_aio_t *aio, cbin_aio_buffer_t *buffer) {
+#if defined(CBIN_HAVE_IO_URING)
+    if (aio->_ring) {
+        while (buffer->state == CBIN_AIO_PENDING)
+            cbin_aio_ring_reap(aio);
+        return;
+    }
+#endif
+    if (buffer->state != CBIN_AIO_PENDING)
+        return;
+    cbin_aio_worker_t *worker = aio->_worker;
+    cbin_mutex_lock(&worker->lock);
+    while (worker->completed <= buffer->ticket)
+        cbin_cond_wait(&worker->completed_cond, &worker->lock);
+    cbin_mutex_unlock(&worker->lock);
+    buffer->state = CBIN_AIO_DONE;
+}
+
+static bool cbin_aio_ready(cbin_aio_t *aio, cbin_aio_buffer_t *buffer) {
+#if defined(CBIN_HAVE_IO_URING)
+    if (aio->_ring) {
+        while (buffer->state == CBIN_AIO_PENDING &&
+               *aio->_ring->cq_head !=
+                   __atomic_load_n(aio->_ring->cq_tail, __ATOMIC_ACQUIRE))
+            cbin_aio_ring_reap(aio);
+        return buffer->state != CBIN_AIO_PENDING;
+    }
+#endif
+    if (buffer->state != CBIN_AIO_PENDING)
+        return true;
+    cbin_aio_worker_t *worker = aio->_worker;
+    cbin_mutex_lock(&worker->lock);
+    bool ready = worker->completed > buffer->ticket;
+    cbin_mutex_unlock(&worker->lock);
+    if (ready)
+        buffer->state = CBIN_AIO_DONE;
+    return ready;
+}
+
+static cbin_err_t cbin_aio_init(cbin_aio_t *aio, int fd, bool sink,
+                                uint64_t offset, size_t buffer_size,
+                                size_t depth, unsigned flags) {
+    memset(aio, 0, sizeof(*aio));
+    aio->_fd = fd;
+    aio->_sink = sink;
+    aio->_buffer_size = buffer_size;
+    aio->_offset = offset;
+    if (depth < 2 || depth > CBIN_AIO_MAX_DEPTH || buffer_size == 0)
+        return aio->_error = CBIN_ERR_FAILED;
+    aio->_buffers = (cbin_aio_buffer_t *)CBIN_REALLOC(
+        NULL, depth * sizeof(cbin_aio_buffer_t));
+    if (!aio->_buffers)
+        return aio->_error = CBIN_ERR_OUT_OF_MEMORY;
+    memset(aio->_buffers, 0, depth * sizeof(cbin_aio_buffer_t));
+    for (; aio->_depth < depth; aio->_depth++) {
+        void *data = CBIN_REALLOC(NULL, buffer_size);
+        if (!data) {
+            cbin_aio_destroy(aio);
+            return aio->_error = CBIN_ERR_OUT_OF_MEMORY;
+        }
+        aio->_buffers[aio->_depth].data = (uint8_t *)data;
+    }
+#if defined(CBIN_HAVE_IO_URING)
+    if (!(flags & CBIN_AIO_THREAD))
+        aio->_ring = cbin_aio_ring_open(depth);
+    if (aio->_ring)
+        return CBIN_ERR_OK;
+#else
+    (void)flags;
+#endif
+    cbin_aio_worker_t *worker =
+        (cbin_aio_worker_t *)CBIN_REALLOC(NULL, sizeof(cbin_aio_worker_t));
+    if (!worker) {
+        cbin_aio_destroy(aio);
+        return aio->_error = CBIN_ERR_OUT_OF_MEMORY;
+    }
+    memset(worker, 0, sizeof(*worker));
+    cbin_mutex_init(&worker->lock);
+    cbin_cond_init(&worker->submitted_cond);
+    cbin_cond_init(&worker->completed_cond);
+    aio->_worker = worker;
+    if (!cbin_thread_create(&worker->thread, cbin_aio_work, aio)) {
+        cbin_cond_destroy(&worker->completed_cond);
+        cbin_cond_destroy(&worker->submitted_cond);
+        cbin_mutex_destroy(&worker->lock);
+        CBIN_FREE(worker);
+        aio->_worker = NULL;
+        cbin_aio_destroy(aio);
+        return aio->_error = CBIN_ERR_FAILED;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_aio_init_source(cbin_aio_t *aio, int fd, uint64_t offset,
+                                size_t buffer_size, size_t depth,
+                                unsigned flags) {
+    if (cbin_aio_init(aio, fd, false, offset, buffer_size, depth, flags))
+        return aio->_error;
+    for (size_t i = 0; i < aio->_depth; i++) {
+        cbin_aio_buffer_t *buffer = &aio->_buffers[i];
+        buffer->size = buffer_size;
+        buffer->offset = aio->_offset;
+        aio->_offset += buffer_size;
+        if (cbin_aio_submit(aio, i))
+            break;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_aio_init_sink(cbin_aio_t *aio, int fd, uint64_t offset,
+                              size_t buffer_size, size_t depth,
+                              unsigned flags) {
+    return cbin_aio_init(aio, fd, true, offset, buffer_size, depth, flags);
+}
+
+void cbin_aio_destroy(cbin_aio_t *aio) {
+    if (aio->_buffers) {
+        for (size_t i = 0; i < aio->_depth; i++)
+            cbin_aio_wait(aio, &aio->_buffers[i]);
+    }
+#if defined(CBIN_HAVE_IO_URING)
+    if (aio->_ring)
+        cbin_aio_ring_close(aio->_ring);
+    aio->_ring = NULL;
+#endif
+    cbin_aio_worker_t *worker = aio->_worker;
+    if (worker) {
+        cbin_mutex_lock(&worker->lock);
+        worker->stop = true;
+        cbin_cond_broadcast(&worker->submitted_cond);
+        cbin_mutex_unlock(&worker->lock);
+        cbin_thread_join(worker->thread);
+        cbin_cond_destroy(&worker->completed_cond);
+        cbin_cond_destroy(&worker->submitted_cond);
+        cbin_mutex_destroy(&worker->lock);
+        CBIN_FREE(worker);
+        aio->_worker = NULL;
+    }
+    if (aio->_buffers) {
+        for (size_t i = 0; i < aio->_depth; i++)
+            CBIN_FREE(aio->_buffers[i].data);
+        CBIN_FREE(aio->_buffers);
+        aio->_buffers = NULL;
+    }
+    aio->_depth = 0;
+}
+
+cbin_err_t cbin_aio_refill(void *user_data, void *buffer, size_t size,
+                           size_t *read) {
+    cbin_aio_t *aio = (cbin_aio_t *)user_data;
+    uint8_t *out = (uint8_t *)buffer;
+    size_t copied = 0;
+    if (aio->_error)
+        return aio->_error;
+    while (copied < size) {
+        cbin_aio_buffer_t *current = &aio->_buffers[aio->_head];
+        if (current->state == CBIN_AIO_FREE)
+            break;
+        // Hand over what is already there rather than waiting for more.
+        if (copied && !cbin_aio_ready(aio, current))
+            break;
+        cbin_aio_wait(aio, current);
+        if (current->error)
+            return aio->_error = current->error;
+        size_t count = current->done - current->consumed;
+        if (count > size - copied)
+            count = size - copied;
+        memcpy(out + copied, current->data + current->consumed, count);
+        current->consumed += count;
+        copied += count;
+        if (current->consumed < current->done)
+            break;
+        // A short read is the end of the file, the reads already in flight
+        // past it complete empty.
+        if (current->done < current->size)
+            aio->_eof = true;
+        if (aio->_eof) {
+            current->state = CBIN_AIO_FREE;
+        } else {
+            current->offset = aio->_offset;
+            aio->_offset += current->size;
+            if (cbin_aio_submit(aio, aio->_head))
+                return aio->_error = current->error;
+        }
+        aio->_head = (aio->_head + 1) % aio->_depth;
+    }
+    *read = copied;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_aio_sink(void *user_data, const void *data, size_t size) {
+    cbin_aio_t *aio = (cbin_aio_t *)user_data;
+    const uint8_t *bytes = (const uint8_t *)data;
+    if (aio->_error)
+        return aio->_error;
+    while (size > 0) {
+        cbin_aio_buffer_t *current = &aio->_buffers[aio->_head];
+        if (current->state != CBIN_AIO_FREE) {
+            cbin_aio_wait(aio, current);
+            if (current->error)
+                return aio->_error = current->error;
+            current->state = CBIN_AIO_FREE;
+            current->size = 0;
+        }
+        size_t count = aio->_buffer_size - current->size;
+        if (count > size)
+            count = size;
+        memcpy(current->data + current->size, bytes, count);
+        current->size += count;
+        bytes += count;
+        size -= count;
+        if (current->size == aio->_buffer_size) {
+            current->offset = aio->_offset;
+            aio->_offset += current->size;
+            if (cbin_aio_submit(aio, aio->_head))
+                return aio->_error = current->error;
+            aio->_head = (aio->_head + 1) % aio->_depth;
+        }
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_aio_drain(cbin_aio_t *aio) {
+    if (!aio->_sink)
+        return CBIN_ERR_FAILED;
+    if (aio->_error)
+        return aio->_error;
+    cbin_aio_buffer_t *current = &aio->_buffers[aio->_head];
+    if (current->state == CBIN_AIO_FREE && current->size > 0) {
+        current->offset = aio->_offset;
+        aio->_offset += current->size;
+        if (cbin_aio_submit(aio, aio->_head))
+            return aio->_error = current->error;
+        aio->_head = (aio->_head + 1) % aio->_depth;
+    }
+    for (size_t i = 0; i < aio->_depth; i++) {
+        cbin_aio_buffer_t *buffer = &aio->_buffers[i];
+        if (buffer->state == CBIN_AIO_FREE)
+            continue;
+        cbin_aio_wait(aio, buffer);
+        if (buffer->error && !aio->_error)
+            aio->_error = buffer->error;
+        buffer->state = CBIN_AIO_FREE;
+        buffer->size = 0;
+    }
+    return aio->_error;
+}
+
+cbin_err_t cbin_reader_init_aio(cbin_reader_t *reader, cbin_aio_t *aio,
+                                size_t window_size) {
+    return cbin_reader_init_stream(reader, window_size, cbin_aio_refill, aio);
+}
+
+cbin_err_t cbin_writer_init_aio(cbin_writer_t *writer, cbin_aio_t *aio,
+                                size_t buffer_size) {
+    return cbin_writer_init_sink(writer, buffer_size, cbin_aio_sink, aio);
+}
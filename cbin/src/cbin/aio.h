@@ -0,0 +1,127 @@
+#ifndef CBIN_SRC_CBIN_AIO_H
+#define CBIN_SRC_CBIN_AIO_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+// Asynchronous file input and output behind the refill and sink callbacks
+// of streaming readers and flushing writers. A ring of buffers is kept in
+// flight: a source reads ahead while the reader parses the buffer before,
+// a sink writes a filled buffer while the writer encodes into the next, so
+// converting a file takes about the longer of the encoding and the disk
+// time rather than their sum.
+//
+// On Linux the transfers go through io_uring when the kernel allows it,
+// elsewhere, or when io_uring is unavailable or CBIN_AIO_THREAD is given,
+// through a worker thread performing them in order. Transfers use explicit
+// offsets, so the file must be seekable.
+
+/// Uses the worker thread even when io_uring is available.
+#define CBIN_AIO_THREAD (1u << 0)
+
+/// The largest number of buffers of an asynchronous file.
+#define CBIN_AIO_MAX_DEPTH 16
+
+/// An asynchronous file, either a source read ahead or a sink written
+/// behind, never both.
+typedef struct cbin_aio_s {
+    int _fd;
+    bool _sink;
+    size_t _buffer_size;
+    size_t _depth;
+    struct cbin_aio_buffer_s *_buffers;
+    // The buffer the reader or writer uses next, buffers are handed to the
+    // backend in ring order.
+    size_t _head;
+    // The file offset of the next transfer.
+    uint64_t _offset;
+    bool _eof;
+    cbin_err_t _error;
+
+    struct cbin_aio_ring_s *_ring;
+    struct cbin_aio_worker_s *_worker;
+} cbin_aio_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes an asynchronous source, which starts reading ahead into all
+/// of its buffers right away.
+/// \param aio The source to initialize.
+/// \param fd The file descriptor to read from, which is not closed by
+/// cbin_aio_destroy.
+/// \param offset The offset in the file to start reading at.
+/// \param buffer_size The size of each buffer.
+/// \param depth The number of buffers, 2 to double buffer, 3 to triple
+/// buffer, up to CBIN_AIO_MAX_DEPTH.
+/// \param flags A combination of CBIN_AIO_* flags.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the depth is out of range or the
+/// worker thread could not be started.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_aio_init_source(cbin_aio_t *aio, int fd, uint64_t offset,
+                                size_t buffer_size, size_t depth,
+                                unsigned flags);
+
+/// Initializes an asynchronous sink. Call cbin_aio_drain once the output is
+/// complete to wait for the last writes and learn whether they succeeded.
+/// \param aio The sink to initialize.
+/// \param fd The file descriptor to write to, which is not closed by
+/// cbin_aio_destroy.
+/// \param offset The offset in the file to start writing at.
+/// \param buffer_size The size of each buffer.
+/// \param depth The number of buffers, see cbin_aio_init_source.
+/// \param flags A combination of CBIN_AIO_* flags.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the depth is out of range or the
+/// worker thread could not be started.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_aio_init_sink(cbin_aio_t *aio, int fd, uint64_t offset,
+                              size_t buffer_size, size_t depth,
+                              unsigned flags);
+
+/// Waits for the transfers in flight and destroys an asynchronous file.
+/// Errors of a sink that was not drained are lost.
+/// \param aio The file to destroy.
+void cbin_aio_destroy(cbin_aio_t *aio);
+
+/// Writes the partially filled buffer of a sink and waits for every write
+/// in flight. The sink can keep being written to afterwards.
+/// \param aio The sink to drain.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the file is a source.
+/// \code CBIN_ERR_IO \endcode if a write failed.
+cbin_err_t cbin_aio_drain(cbin_aio_t *aio);
+
+/// Refill callback reading from the asynchronous source stored in
+/// user_data. Waits only when the buffer it needs is still being read.
+cbin_err_t cbin_aio_refill(void *user_data, void *buffer, size_t size,
+                           size_t *read);
+
+/// Sink callback writing to the asynchronous sink stored in user_data.
+/// The bytes are copied, waiting only when every buffer is being written.
+cbin_err_t cbin_aio_sink(void *user_data, const void *data, size_t size);
+
+/// Initializes a streaming reader over an asynchronous source, see
+/// cbin_reader_init_stream.
+/// \param reader The reader to initialize.
+/// \param aio The source to read from, which must outlive the reader.
+/// \param window_size The size of the window to allocate.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_reader_init_aio(cbin_reader_t *reader, cbin_aio_t *aio,
+                                size_t window_size);
+
+/// Initializes a flushing writer over an asynchronous sink, see
+/// cbin_writer_init_sink. Flush the writer, then drain the sink, to
+/// complete the output.
+/// \param writer The writer to initialize.
+/// \param aio The sink to write to, which must outlive the writer.
+/// \param buffer_size The size of the buffer to allocate.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_init_aio(cbin_writer_t *writer, cbin_aio_t *aio,
+                                size_t buffer_size);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_AIO_H
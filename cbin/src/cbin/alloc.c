@@ -0,0 +1,116 @@
+#include "alloc.h"
+#include <stdint.h>
+#include <string.h>
+
+// Arena allocations are aligned like malloc would align them.
+#define ARENA_ALIGN 16
+
+typedef struct cbin_arena_block_s {
+    struct cbin_arena_block_s *prev;
+    size_t size;
+    size_t used;
+    // Padding so the data following the header stays aligned.
+    size_t _pad;
+} cbin_arena_block_t;
+
+#define BLOCK_DATA(block) ((uint8_t *)((block) + 1))
+
+static size_t cbin_arena_align(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+void cbin_arena_init(cbin_arena_t *arena, size_t block_size) {
+    arena->_block = NULL;
+    arena->_block_size = block_size ? block_size : 4096;
+    arena->_last = NULL;
+    arena->_allocator.reallocate = NULL;
+    arena->_allocator.deallocate = NULL;
+    arena->_allocator.user_data = NULL;
+}
+
+void *cbin_arena_alloc(cbin_arena_t *arena, size_t size) {
+    cbin_arena_block_t *block = arena->_block;
+    size_t offset = block ? cbin_arena_align(block->used) : 0;
+    if (!block || offset > block->size || size > block->size - offset) {
+        size_t block_size = arena->_block_size;
+        if (block_size < size)
+            block_size = size;
+        if (block_size > (size_t)-1 - sizeof(cbin_arena_block_t))
+            return NULL;
+        block = (cbin_arena_block_t *)CBIN_REALLOC(
+            NULL, sizeof(cbin_arena_block_t) + block_size);
+        if (!block)
+            return NULL;
+        block->prev = arena->_block;
+        block->size = block_size;
+        arena->_block = block;
+        offset = 0;
+    }
+    block->used = offset + size;
+    arena->_last = BLOCK_DATA(block) + offset;
+    return arena->_last;
+}
+
+static void *cbin_arena_reallocate(void *user_data, void *ptr,
+                                   size_t old_size, size_t new_size) {
+    cbin_arena_t *arena = (cbin_arena_t *)user_data;
+    if (ptr && ptr == arena->_last) {
+        // The most recent allocation ends at the block's bump pointer, it
+        // can grow or shrink in place as long as the block has room.
+        cbin_arena_block_t *block = arena->_block;
+        size_t offset = (size_t)((uint8_t *)ptr - BLOCK_DATA(block));
+        if (new_size <= block->size - offset) {
+            block->used = offset + new_size;
+            return ptr;
+        }
+    } else if (ptr && new_size <= old_size) {
+        return ptr;
+    }
+    void *allocation = cbin_arena_alloc(arena, new_size);
+    if (allocation && ptr)
+        memcpy(allocation, ptr, old_size < new_size ? old_size : new_size);
+    return allocation;
+}
+
+static void cbin_arena_deallocate(void *user_data, void *ptr, size_t size) {
+    cbin_arena_t *arena = (cbin_arena_t *)user_data;
+    (void)size;
+    // Only the most recent allocation can be given back, the rest is
+    // released with the arena.
+    if (ptr && ptr == arena->_last) {
+        cbin_arena_block_t *block = arena->_block;
+        block->used = (size_t)((uint8_t *)ptr - BLOCK_DATA(block));
+        arena->_last = NULL;
+    }
+}
+
+const cbin_allocator_t *cbin_arena_allocator(cbin_arena_t *arena) {
+    arena->_allocator.reallocate = cbin_arena_reallocate;
+    arena->_allocator.deallocate = cbin_arena_deallocate;
+    arena->_allocator.user_data = arena;
+    return &arena->_allocator;
+}
+
+static void cbin_arena_free_blocks(cbin_arena_block_t *block) {
+    while (block) {
+        cbin_arena_block_t *prev = block->prev;
+        CBIN_FREE(block);
+        block = prev;
+    }
+}
+
+void cbin_arena_reset(cbin_arena_t *arena) {
+    cbin_arena_block_t *block = arena->_block;
+    if (block) {
+        cbin_arena_free_blocks(block->prev);
+        block->prev = NULL;
+        block->used = 0;
+    }
+    arena->_last = NULL;
+}
+
+void cbin_arena_destroy(cbin_arena_t *arena) {
+    cbin_arena_free_blocks(arena->_block);
+    arena->_block = NULL;
+    arena->_last = NULL;
+}
@@ -0,0 +1,89 @@
+#ifndef CBIN_SRC_CBIN_ALLOC_H
+#define CBIN_SRC_CBIN_ALLOC_H
+#include "common.h"
+
+/// A runtime allocator, used instead of CBIN_REALLOC and CBIN_FREE by the
+/// writers it is attached to. Both callbacks receive the size the block was
+/// allocated with, so allocators without per-block headers can work with it.
+typedef struct cbin_allocator_s {
+    /// Allocates, grows or shrinks a block like realloc.
+    /// \param user_data The user data of the allocator.
+    /// \param ptr The block to resize, or NULL to allocate a new one.
+    /// \param old_size The current size of the block, 0 if ptr is NULL.
+    /// \param new_size The size to resize the block to.
+    /// \return The resized block, or NULL if it could not be resized, in
+    /// which case the original block is left untouched.
+    void *(*reallocate)(void *user_data, void *ptr, size_t old_size,
+                        size_t new_size);
+
+    /// Frees a block.
+    /// \param user_data The user data of the allocator.
+    /// \param ptr The block to free.
+    /// \param size The size of the block.
+    void (*deallocate)(void *user_data, void *ptr, size_t size);
+
+    void *user_data;
+} cbin_allocator_t;
+
+/// A bump allocator for request-scoped encoding: allocations are carved out
+/// of large blocks and are all released at once by cbin_arena_reset or
+/// cbin_arena_destroy. Growing the most recent allocation extends it in
+/// place while its block has room, so a writer growing inside an arena
+/// does not copy its contents on every reallocation.
+typedef struct cbin_arena_s {
+    struct cbin_arena_block_s *_block;
+    size_t _block_size;
+    void *_last;
+    cbin_allocator_t _allocator;
+} cbin_arena_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes an empty arena, no memory is allocated until first use.
+/// \param arena The arena to initialize.
+/// \param block_size The size of the blocks to allocate from, larger
+/// allocations get a block of their own.
+void cbin_arena_init(cbin_arena_t *arena, size_t block_size);
+
+/// Allocates from an arena. Allocations are aligned for any type.
+/// \param arena The arena to allocate from.
+/// \param size The number of bytes to allocate.
+/// \return The allocation, or NULL if out of memory.
+void *cbin_arena_alloc(cbin_arena_t *arena, size_t size);
+
+/// Returns an allocator backed by an arena, valid as long as the arena is.
+/// \param arena The arena to allocate from.
+/// \return The allocator of the arena.
+const cbin_allocator_t *cbin_arena_allocator(cbin_arena_t *arena);
+
+/// Releases every allocation of an arena at once. The most recent block is
+/// kept for reuse, the others are freed.
+/// \param arena The arena to reset.
+void cbin_arena_reset(cbin_arena_t *arena);
+
+/// Frees every block of an arena.
+/// \param arena The arena to destroy.
+void cbin_arena_destroy(cbin_arena_t *arena);
+
+// Allocation entry points used by the library, a NULL allocator selects
+// CBIN_REALLOC and CBIN_FREE.
+static inline void *cbin_allocator_realloc(const cbin_allocator_t *allocator,
+                                           void *ptr, size_t old_size,
+                                           size_t new_size) {
+    if (!allocator)
+        return CBIN_REALLOC(ptr, new_size);
+    return allocator->reallocate(allocator->user_data, ptr, old_size,
+                                 new_size);
+}
+static inline void cbin_allocator_free(const cbin_allocator_t *allocator,
+                                       void *ptr, size_t size) {
+    if (!allocator) {
+        CBIN_FREE(ptr);
+        return;
+    }
+    allocator->deallocate(allocator->user_data, ptr, size);
+}
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_ALLOC_H
@@ -0,0 +1,220 @@
+#include "bits.h"
+#include <string.h>
+
+// Fields wider than this are split in two, so that a refill always has
+// room for the whole field next to a partially consumed byte.
+#define BITS_FIELD_MAX 56
+
+void cbin_bitreader_init(cbin_bitreader_t *bits, cbin_reader_t *reader,
+                         cbin_bit_order_t order) {
+    bits->_reader = reader;
+    bits->_bits = 0;
+    bits->_count = 0;
+    bits->_order = order;
+}
+
+// Keeps the partially consumed byte of the accumulator and gives the whole
+// bytes read ahead back to the reader. They are always the bytes right
+// before its position, still in its buffer.
+static void cbin_bitreader_rewind(cbin_bitreader_t *bits) {
+    unsigned rest = bits->_count & 7;
+    bits->_reader->_position -= bits->_count >> 3;
+    bits->_count = rest;
+    if (rest == 0)
+        bits->_bits = 0;
+    else if (bits->_order == CBIN_BITS_MSB_FIRST)
+        bits->_bits &= ~(uint64_t)0 << (64 - rest);
+    else
+        bits->_bits &= ((uint64_t)1 << rest) - 1;
+}
+
+// Refills the accumulator with at least width <= BITS_FIELD_MAX bits.
+static cbin_err_t cbin_bitreader_refill(cbin_bitreader_t *bits,
+                                        unsigned width) {
+    cbin_reader_t *reader = bits->_reader;
+    if (reader->_error)
+        return reader->_error;
+    if (CBIN_LIKELY(reader->_size - reader->_position >= 8)) {
+        // Load a whole word and keep as many whole bytes of it as fit.
+        const uint8_t *src =
+            (const uint8_t *)reader->_buffer + reader->_position;
+        unsigned bytes = (63 - bits->_count) >> 3;
+        if (bits->_order == CBIN_BITS_MSB_FIRST) {
+            bits->_bits |= cbin_load_u64_be(src) >> bits->_count;
+            bits->_count += bytes * 8;
+            bits->_bits &= ~(~(uint64_t)0 >> bits->_count);
+        } else {
+            bits->_bits |= cbin_load_u64_le(src) << bits->_count;
+            bits->_count += bytes * 8;
+            bits->_bits &= ((uint64_t)1 << bits->_count) - 1;
+        }
+        reader->_position += bytes;
+        return CBIN_ERR_OK;
+    }
+    // Near the end of the buffer (or window), one byte at a time. Reading
+    // may move a streaming window, which only keeps the bytes after the
+    // position, so the bytes read ahead go back to the reader first.
+    cbin_bitreader_rewind(bits);
+    while (bits->_count < width) {
+        uint8_t byte;
+        if (cbin_read_u8(reader, &byte))
+            return reader->_error;
+        if (bits->_order == CBIN_BITS_MSB_FIRST)
+            bits->_bits |= (uint64_t)byte << (56 - bits->_count);
+        else
+            bits->_bits |= (uint64_t)byte << bits->_count;
+        bits->_count += 8;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_bitreader_read_slow(cbin_bitreader_t *bits, unsigned width,
+                                    uint64_t *value) {
+    if (bits->_reader->_error)
+        return bits->_reader->_error;
+    if (width == 0 || width > 64) {
+        if (width > 64)
+            return CBIN_ERROR(bits->_reader, CBIN_ERR_OUT_OF_BOUNDS);
+        if (value)
+            *value = 0;
+        return CBIN_ERR_OK;
+    }
+    if (width > BITS_FIELD_MAX) {
+        uint64_t first, second;
+        if (cbin_bitreader_read(bits, 32, &first) ||
+            cbin_bitreader_read(bits, width - 32, &second))
+            return bits->_reader->_error;
+        if (value) {
+            if (bits->_order == CBIN_BITS_MSB_FIRST)
+                *value = first << (width - 32) | second;
+            else
+                *value = first | second << 32;
+        }
+        return CBIN_ERR_OK;
+    }
+    if (bits->_count < width && cbin_bitreader_refill(bits, width))
+        return bits->_reader->_error;
+    uint64_t result = cbin_bitreader_take(bits, width);
+    if (value)
+        *value = result;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_bitreader_peek_slow(cbin_bitreader_t *bits, unsigned width,
+                                    uint64_t *value) {
+    if (bits->_reader->_error)
+        return bits->_reader->_error;
+    if (width == 0) {
+        *value = 0;
+        return CBIN_ERR_OK;
+    }
+    if (width > CBIN_BITS_PEEK_MAX)
+        return CBIN_ERROR(bits->_reader, CBIN_ERR_OUT_OF_BOUNDS);
+    if (bits->_count < width && cbin_bitreader_refill(bits, width))
+        return bits->_reader->_error;
+    return cbin_bitreader_peek(bits, width, value);
+}
+
+cbin_err_t cbin_bitreader_skip(cbin_bitreader_t *bits, size_t count) {
+    if (bits->_reader->_error)
+        return bits->_reader->_error;
+    if (count > bits->_count) {
+        // Drop the whole accumulator and skip the whole bytes past it in
+        // the reader itself.
+        count -= bits->_count;
+        bits->_bits = 0;
+        bits->_count = 0;
+        if (cbin_reader_skip(bits->_reader, count >> 3))
+            return bits->_reader->_error;
+        return cbin_bitreader_read(bits, (unsigned)(count & 7), NULL);
+    }
+    if (count > 0)
+        cbin_bitreader_take(bits, (unsigned)count);
+    return CBIN_ERR_OK;
+}
+
+void cbin_bitreader_align(cbin_bitreader_t *bits) {
+    unsigned rest = bits->_count & 7;
+    if (rest)
+        cbin_bitreader_take(bits, rest);
+}
+
+void cbin_bitreader_finish(cbin_bitreader_t *bits) {
+    cbin_bitreader_align(bits);
+    cbin_bitreader_rewind(bits);
+}
+
+void cbin_bitwriter_init(cbin_bitwriter_t *bits, cbin_writer_t *writer,
+                         cbin_bit_order_t order) {
+    bits->_writer = writer;
+    bits->_bits = 0;
+    bits->_count = 0;
+    bits->_order = order;
+}
+
+// Writes the whole bytes of the accumulator, leaving less than a byte.
+static cbin_err_t cbin_bitwriter_drain(cbin_bitwriter_t *bits) {
+    cbin_writer_t *writer = bits->_writer;
+    unsigned bytes = bits->_count >> 3;
+    if (bytes == 0)
+        return CBIN_ERR_OK;
+    uint8_t word[8];
+    uint8_t *dst = word;
+    // Store the whole word in place when it fits and nothing pending past
+    // the position would be clobbered.
+    bool direct = writer->_capacity - writer->_position >= 8 &&
+                  writer->_written == writer->_position;
+    if (direct)
+        dst = (uint8_t *)writer->_buffer + writer->_position;
+    if (bits->_order == CBIN_BITS_MSB_FIRST)
+        cbin_store_u64_be(dst, bits->_bits);
+    else
+        cbin_store_u64_le(dst, bits->_bits);
+    if (direct) {
+        writer->_position += bytes;
+        writer->_written = writer->_position;
+    } else if (cbin_write(writer, word, bytes)) {
+        return writer->_error;
+    }
+    if (bytes == 8)
+        bits->_bits = 0;
+    else if (bits->_order == CBIN_BITS_MSB_FIRST)
+        bits->_bits <<= bytes * 8;
+    else
+        bits->_bits >>= bytes * 8;
+    bits->_count -= bytes * 8;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_bitwriter_write_slow(cbin_bitwriter_t *bits, unsigned width,
+                                     uint64_t value) {
+    cbin_writer_t *writer = bits->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (width == 0)
+        return CBIN_ERR_OK;
+    if (width > 64)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+    if (cbin_bitwriter_drain(bits))
+        return writer->_error;
+    if (width <= 64 - bits->_count)
+        return cbin_bitwriter_write(bits, width, value);
+    // A wide field next to a partial byte, split in two.
+    if (bits->_order == CBIN_BITS_MSB_FIRST) {
+        if (cbin_bitwriter_write(bits, width - 32, value >> 32))
+            return writer->_error;
+        return cbin_bitwriter_write(bits, 32, value);
+    }
+    if (cbin_bitwriter_write(bits, 32, value))
+        return writer->_error;
+    return cbin_bitwriter_write(bits, width - 32, value >> 32);
+}
+
+void cbin_bitwriter_align(cbin_bitwriter_t *bits) {
+    bits->_count = (bits->_count + 7) & ~7u;
+}
+
+cbin_err_t cbin_bitwriter_finish(cbin_bitwriter_t *bits) {
+    cbin_bitwriter_align(bits);
+    return cbin_bitwriter_drain(bits);
+}
@@ -0,0 +1,195 @@
+#ifndef CBIN_SRC_CBIN_BITS_H
+#define CBIN_SRC_CBIN_BITS_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+/// The largest number of bits cbin_bitreader_peek can look ahead.
+#define CBIN_BITS_PEEK_MAX 56
+
+/// The order bits are packed in within each byte.
+typedef enum cbin_bit_order_e {
+    /// The first bit is the most significant bit of the first byte, and
+    /// multi-bit fields are big-endian.
+    CBIN_BITS_MSB_FIRST,
+    /// The first bit is the least significant bit of the first byte, and
+    /// multi-bit fields are little-endian.
+    CBIN_BITS_LSB_FIRST,
+} cbin_bit_order_t;
+
+/// Reads bit fields from a reader through a 64-bit accumulator, refilled a
+/// word at a time. The accumulator reads ahead of the fields consumed so
+/// far, the underlying reader must not be used directly until
+/// cbin_bitreader_finish.
+typedef struct cbin_bitreader_s {
+    cbin_reader_t *_reader;
+    uint64_t _bits;
+    unsigned _count;
+    cbin_bit_order_t _order;
+} cbin_bitreader_t;
+
+/// Writes bit fields to a writer through a 64-bit accumulator, emptied a
+/// word at a time. The last partial byte is only written by
+/// cbin_bitwriter_finish, the underlying writer must not be used directly
+/// until then.
+typedef struct cbin_bitwriter_s {
+    cbin_writer_t *_writer;
+    uint64_t _bits;
+    unsigned _count;
+    cbin_bit_order_t _order;
+} cbin_bitwriter_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes a bit reader at the current position of a reader.
+/// \param bits The bit reader to initialize.
+/// \param reader The reader to read from.
+/// \param order The order of the bits.
+void cbin_bitreader_init(cbin_bitreader_t *bits, cbin_reader_t *reader,
+                         cbin_bit_order_t order);
+
+/// Reads a field of up to 64 bits, slow path of cbin_bitreader_read.
+cbin_err_t cbin_bitreader_read_slow(cbin_bitreader_t *bits, unsigned width,
+                                    uint64_t *value);
+
+/// Returns the next bits without consuming them, slow path of
+/// cbin_bitreader_peek.
+cbin_err_t cbin_bitreader_peek_slow(cbin_bitreader_t *bits, unsigned width,
+                                    uint64_t *value);
+
+/// Skips a number of bits.
+/// \param bits The bit reader to skip in.
+/// \param count The number of bits to skip.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_bitreader_skip(cbin_bitreader_t *bits, size_t count);
+
+/// Skips to the next byte boundary.
+/// \param bits The bit reader to align.
+void cbin_bitreader_align(cbin_bitreader_t *bits);
+
+/// Skips to the next byte boundary and gives the bytes read ahead back to
+/// the reader, which continues right after the last field read.
+/// \param bits The bit reader to finish.
+void cbin_bitreader_finish(cbin_bitreader_t *bits);
+
+/// Initializes a bit writer at the current position of a writer.
+/// \param bits The bit writer to initialize.
+/// \param writer The writer to write to.
+/// \param order The order of the bits.
+void cbin_bitwriter_init(cbin_bitwriter_t *bits, cbin_writer_t *writer,
+                         cbin_bit_order_t order);
+
+/// Writes a field of up to 64 bits, slow path of cbin_bitwriter_write.
+cbin_err_t cbin_bitwriter_write_slow(cbin_bitwriter_t *bits, unsigned width,
+                                     uint64_t value);
+
+/// Pads the current byte with zero bits.
+/// \param bits The bit writer to align.
+void cbin_bitwriter_align(cbin_bitwriter_t *bits);
+
+/// Pads the current byte with zero bits and writes every buffered byte, the
+/// writer then continues right after the last field written.
+/// \param bits The bit writer to finish.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_bitwriter_finish(cbin_bitwriter_t *bits);
+
+// Consumes 0 < width <= _count < 64 bits from the accumulator.
+static inline uint64_t cbin_bitreader_take(cbin_bitreader_t *bits,
+                                           unsigned width) {
+    uint64_t value;
+    if (bits->_order == CBIN_BITS_MSB_FIRST) {
+        value = bits->_bits >> (64 - width);
+        bits->_bits <<= width;
+    } else {
+        value = bits->_bits & (((uint64_t)1 << width) - 1);
+        bits->_bits >>= width;
+    }
+    bits->_count -= width;
+    return value;
+}
+
+/// Reads a field.
+/// \param bits The bit reader to read from.
+/// \param width The width of the field, up to 64 bits.
+/// \param value The value to read into.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+static inline cbin_err_t cbin_bitreader_read(cbin_bitreader_t *bits,
+                                             unsigned width, uint64_t *value) {
+    if (CBIN_LIKELY(width != 0 && width <= bits->_count)) {
+        uint64_t result = cbin_bitreader_take(bits, width);
+        if (CBIN_LIKELY(value != NULL))
+            *value = result;
+        return CBIN_ERR_OK;
+    }
+    return cbin_bitreader_read_slow(bits, width, value);
+}
+
+/// Reads a single bit.
+/// \param bits The bit reader to read from.
+/// \param value The value to read into.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+static inline cbin_err_t cbin_bitreader_read_bool(cbin_bitreader_t *bits,
+                                                  bool *value) {
+    uint64_t bit = 0;
+    cbin_err_t err = cbin_bitreader_read(bits, 1, &bit);
+    if (CBIN_LIKELY(value != NULL))
+        *value = bit != 0;
+    return err;
+}
+
+/// Returns the next bits without consuming them.
+/// \param bits The bit reader to peek in.
+/// \param width The number of bits to peek, up to CBIN_BITS_PEEK_MAX.
+/// \param value The value to read into.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if fewer bits are left.
+static inline cbin_err_t cbin_bitreader_peek(cbin_bitreader_t *bits,
+                                             unsigned width, uint64_t *value) {
+    if (CBIN_LIKELY(width != 0 && width <= bits->_count)) {
+        if (bits->_order == CBIN_BITS_MSB_FIRST)
+            *value = bits->_bits >> (64 - width);
+        else
+            *value = bits->_bits & (((uint64_t)1 << width) - 1);
+        return CBIN_ERR_OK;
+    }
+    return cbin_bitreader_peek_slow(bits, width, value);
+}
+
+/// Writes a field.
+/// \param bits The bit writer to write to.
+/// \param width The width of the field, up to 64 bits.
+/// \param value The value to write, bits above the width are ignored.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+static inline cbin_err_t cbin_bitwriter_write(cbin_bitwriter_t *bits,
+                                              unsigned width, uint64_t value) {
+    if (CBIN_LIKELY(width != 0 && width <= 64 - bits->_count)) {
+        if (width < 64)
+            value &= ((uint64_t)1 << width) - 1;
+        if (bits->_order == CBIN_BITS_MSB_FIRST)
+            bits->_bits |= value << (64 - width - bits->_count);
+        else
+            bits->_bits |= value << bits->_count;
+        bits->_count += width;
+        return CBIN_ERR_OK;
+    }
+    return cbin_bitwriter_write_slow(bits, width, value);
+}
+
+/// Writes a single bit.
+/// \param bits The bit writer to write to.
+/// \param value The value to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+static inline cbin_err_t cbin_bitwriter_write_bool(cbin_bitwriter_t *bits,
+                                                   bool value) {
+    return cbin_bitwriter_write(bits, 1, value ? 1 : 0);
+}
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_BITS_H
@@ -0,0 +1,265 @@
+#include "blob.h"
+#include "bytes.h"
+#include "varint.h"
+#include <string.h>
+
+static cbin_err_t cbin_write_prefix(cbin_writer_t *writer,
+                                    cbin_prefix_t prefix, size_t size) {
+    if (writer->_error)
+        return writer->_error;
+    switch (prefix) {
+    case CBIN_PREFIX_U8:
+        if (size > UINT8_MAX)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        return cbin_write_u8(writer, (uint8_t)size);
+    case CBIN_PREFIX_U16_LE:
+    case CBIN_PREFIX_U16_BE:
+        if (size > UINT16_MAX)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        if (prefix == CBIN_PREFIX_U16_LE)
+            return cbin_write_u16_le(writer, (uint16_t)size);
+        return cbin_write_u16_be(writer, (uint16_t)size);
+    case CBIN_PREFIX_U32_LE:
+    case CBIN_PREFIX_U32_BE:
+        if ((uint64_t)size > UINT32_MAX)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        if (prefix == CBIN_PREFIX_U32_LE)
+            return cbin_write_u32_le(writer, (uint32_t)size);
+        return cbin_write_u32_be(writer, (uint32_t)size);
+    case CBIN_PREFIX_VARINT:
+        return cbin_write_varu64(writer, (uint64_t)size);
+    }
+    return CBIN_ERROR(writer, CBIN_ERR_FAILED);
+}
+
+cbin_err_t cbin_write_blob(cbin_writer_t *writer, cbin_prefix_t prefix,
+                           const void *data, size_t size) {
+    if (cbin_write_prefix(writer, prefix, size))
+        return writer->_error;
+    return cbin_write(writer, data, size);
+}
+
+cbin_err_t cbin_write_string(cbin_writer_t *writer, cbin_prefix_t prefix,
+                             const char *string) {
+    return cbin_write_blob(writer, prefix, string, strlen(string));
+}
+
+static size_t cbin_frame_slot(cbin_prefix_t prefix) {
+    switch (prefix) {
+    case CBIN_PREFIX_U8:
+        return 1;
+    case CBIN_PREFIX_U16_LE:
+    case CBIN_PREFIX_U16_BE:
+        return 2;
+    case CBIN_PREFIX_U32_LE:
+    case CBIN_PREFIX_U32_BE:
+        return 4;
+    case CBIN_PREFIX_VARINT:
+        return CBIN_FRAME_VARINT_SIZE;
+    }
+    return 0;
+}
+
+cbin_err_t cbin_writer_begin_frame(cbin_writer_t *writer,
+                                   cbin_prefix_t prefix) {
+    if (writer->_error)
+        return writer->_error;
+    size_t slot = cbin_frame_slot(prefix);
+    if (writer->_chunk_size || slot == 0)
+        return CBIN_ERROR(writer, CBIN_ERR_FAILED);
+    if (writer->_frame_count == writer->_frame_capacity) {
+        size_t capacity =
+            writer->_frame_capacity ? writer->_frame_capacity * 2 : 8;
+        void *frames = CBIN_REALLOC(writer->_frames,
+                                    capacity * sizeof(cbin_writer_frame_t));
+        if (!frames)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+        writer->_frames = (cbin_writer_frame_t *)frames;
+        writer->_frame_capacity = capacity;
+    }
+    // The frame is pushed first so that a flush making room for its length
+    // already keeps it in the buffer.
+    cbin_writer_frame_t *frame = &writer->_frames[writer->_frame_count++];
+    frame->position = cbin_writer_position(writer);
+    frame->gap_bytes = writer->_gap_bytes;
+    frame->gap_index = writer->_gap_count;
+    frame->prefix = (int)prefix;
+    if (cbin_writer_reserve(writer, slot, NULL)) {
+        writer->_frame_count--;
+        return writer->_error;
+    }
+    return CBIN_ERR_OK;
+}
+
+// Records the unused bytes of a varint length. Gaps inside the frame were
+// added after the ones before it, inserting at the index saved when the
+// frame began keeps them sorted by position.
+static cbin_err_t cbin_writer_add_gap(cbin_writer_t *writer,
+                                      const cbin_writer_frame_t *frame,
+                                      size_t position, size_t size) {
+    if (writer->_gap_count == writer->_gap_capacity) {
+        size_t capacity = writer->_gap_capacity ? writer->_gap_capacity * 2 : 8;
+        void *gaps =
+            CBIN_REALLOC(writer->_gaps, capacity * sizeof(cbin_writer_gap_t));
+        if (!gaps)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+        writer->_gaps = (cbin_writer_gap_t *)gaps;
+        writer->_gap_capacity = capacity;
+    }
+    cbin_writer_gap_t *gap = &writer->_gaps[frame->gap_index];
+    memmove(gap + 1, gap,
+            (writer->_gap_count - frame->gap_index) * sizeof(*gap));
+    gap->position = position;
+    gap->size = size;
+    writer->_gap_count++;
+    writer->_gap_bytes += size;
+    return CBIN_ERR_OK;
+}
+
+// Removes every gap, moving each byte after the first one once.
+static void cbin_writer_compact(cbin_writer_t *writer) {
+    uint8_t *buffer = (uint8_t *)writer->_buffer;
+    size_t base = writer->_flushed;
+    size_t mark = writer->_checksum_mark;
+    size_t removed = 0;
+    for (size_t i = 0; i < writer->_gap_count; i++) {
+        const cbin_writer_gap_t *gap = &writer->_gaps[i];
+        size_t from = gap->position - base + gap->size;
+        size_t to = i + 1 < writer->_gap_count
+                        ? writer->_gaps[i + 1].position - base
+                        : writer->_written;
+        removed += gap->size;
+        memmove(buffer + from - removed, buffer + from, to - from);
+        // A checksummed region that started inside the frames moves along.
+        if (writer->_checksum && gap->position - base < mark)
+            writer->_checksum_mark -= gap->size;
+    }
+    writer->_position -= removed;
+    writer->_written -= removed;
+    writer->_gap_count = 0;
+    writer->_gap_bytes = 0;
+}
+
+cbin_err_t cbin_writer_end_frame(cbin_writer_t *writer) {
+    if (writer->_error)
+        return writer->_error;
+    if (!writer->_frame_count)
+        return CBIN_ERROR(writer, CBIN_ERR_FAILED);
+    const cbin_writer_frame_t *frame =
+        &writer->_frames[writer->_frame_count - 1];
+    cbin_prefix_t prefix = (cbin_prefix_t)frame->prefix;
+    size_t slot = cbin_frame_slot(prefix);
+    size_t start = frame->position + slot;
+    size_t end = cbin_writer_position(writer);
+    size_t gaps = writer->_gap_bytes - frame->gap_bytes;
+    if (end < start + gaps)
+        return CBIN_ERROR(writer, CBIN_ERR_FAILED);
+    size_t length = end - start - gaps;
+    uint8_t *out = (uint8_t *)writer->_buffer + frame->position -
+                   writer->_flushed + writer->_chunk_start;
+    switch (prefix) {
+    case CBIN_PREFIX_U8:
+        if (length > UINT8_MAX)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        *out = (uint8_t)length;
+        break;
+    case CBIN_PREFIX_U16_LE:
+    case CBIN_PREFIX_U16_BE:
+        if (length > UINT16_MAX)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        if (prefix == CBIN_PREFIX_U16_LE)
+            cbin_store_u16_le(out, (uint16_t)length);
+        else
+            cbin_store_u16_be(out, (uint16_t)length);
+        break;
+    case CBIN_PREFIX_U32_LE:
+    case CBIN_PREFIX_U32_BE:
+        if ((uint64_t)length > UINT32_MAX)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        if (prefix == CBIN_PREFIX_U32_LE)
+            cbin_store_u32_le(out, (uint32_t)length);
+        else
+            cbin_store_u32_be(out, (uint32_t)length);
+        break;
+    case CBIN_PREFIX_VARINT: {
+        if ((uint64_t)length >> (7 * CBIN_FRAME_VARINT_SIZE))
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+        size_t size = 0;
+        uint64_t value = length;
+        while (value >= 0x80) {
+            out[size++] = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        out[size++] = (uint8_t)value;
+        if (size < slot &&
+            cbin_writer_add_gap(writer, frame, frame->position + size,
+                                slot - size))
+            return writer->_error;
+        break;
+    }
+    }
+    if (--writer->_frame_count == 0 && writer->_gap_count)
+        cbin_writer_compact(writer);
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t cbin_read_prefix(cbin_reader_t *reader,
+                                   cbin_prefix_t prefix, size_t *size) {
+    switch (prefix) {
+    case CBIN_PREFIX_U8: {
+        uint8_t value = 0;
+        cbin_read_u8(reader, &value);
+        *size = value;
+        return reader->_error;
+    }
+    case CBIN_PREFIX_U16_LE:
+    case CBIN_PREFIX_U16_BE: {
+        uint16_t value = 0;
+        if (prefix == CBIN_PREFIX_U16_LE)
+            cbin_read_u16_le(reader, &value);
+        else
+            cbin_read_u16_be(reader, &value);
+        *size = value;
+        return reader->_error;
+    }
+    case CBIN_PREFIX_U32_LE:
+    case CBIN_PREFIX_U32_BE: {
+        uint32_t value = 0;
+        if (prefix == CBIN_PREFIX_U32_LE)
+            cbin_read_u32_le(reader, &value);
+        else
+            cbin_read_u32_be(reader, &value);
+        *size = value;
+        return reader->_error;
+    }
+    case CBIN_PREFIX_VARINT: {
+        uint64_t value = 0;
+        if (cbin_read_varu64(reader, &value))
+            return reader->_error;
+        if (value > (size_t)-1)
+            return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+        *size = (size_t)value;
+        return CBIN_ERR_OK;
+    }
+    }
+    return CBIN_ERROR(reader, CBIN_ERR_FAILED);
+}
+
+cbin_err_t cbin_read_blob(cbin_reader_t *reader, cbin_prefix_t prefix,
+                          const void **data, size_t *size) {
+    size_t length = 0;
+    if (reader->_error)
+        return reader->_error;
+    if (cbin_read_prefix(reader, prefix, &length))
+        return reader->_error;
+    if (cbin_read_view(reader, length, data))
+        return reader->_error;
+    if (size)
+        *size = length;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_read_string(cbin_reader_t *reader, cbin_prefix_t prefix,
+                            const char **string, size_t *length) {
+    return cbin_read_blob(reader, prefix, (const void **)string, length);
+}
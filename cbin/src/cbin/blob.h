@@ -0,0 +1,100 @@
+#ifndef CBIN_SRC_CBIN_BLOB_H
+#define CBIN_SRC_CBIN_BLOB_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+/// The encoding of the length in front of a blob or string.
+typedef enum cbin_prefix_e {
+    CBIN_PREFIX_U8,
+    CBIN_PREFIX_U16_LE,
+    CBIN_PREFIX_U16_BE,
+    CBIN_PREFIX_U32_LE,
+    CBIN_PREFIX_U32_BE,
+    /// An unsigned LEB128 varint, see cbin_write_varu64.
+    CBIN_PREFIX_VARINT,
+} cbin_prefix_t;
+
+/// The bytes reserved for the varint length of a frame, enough for lengths
+/// below 32 GiB.
+#define CBIN_FRAME_VARINT_SIZE 5
+
+CBIN_HEADER_BEGIN
+
+/// Writes a blob preceded by its length.
+/// \param writer The writer to write to.
+/// \param prefix The encoding of the length.
+/// \param data The bytes of the blob.
+/// \param size The size of the blob.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if the size does not fit the prefix.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_blob(cbin_writer_t *writer, cbin_prefix_t prefix,
+                           const void *data, size_t size);
+
+/// Writes a NUL-terminated string preceded by its length, the terminator is
+/// not written.
+/// \param writer The writer to write to.
+/// \param prefix The encoding of the length.
+/// \param string The string to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if the length does not fit the
+/// prefix.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_string(cbin_writer_t *writer, cbin_prefix_t prefix,
+                             const char *string);
+
+/// Reads a length-prefixed blob in place, see cbin_read_view for how long
+/// the returned pointer stays valid.
+/// \param reader The reader to read from.
+/// \param prefix The encoding of the length.
+/// \param data Receives a pointer to the bytes of the blob.
+/// \param size Receives the size of the blob.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode if a varint length is malformed.
+cbin_err_t cbin_read_blob(cbin_reader_t *reader, cbin_prefix_t prefix,
+                          const void **data, size_t *size);
+
+/// Reads a length-prefixed string in place, see cbin_read_blob. The string
+/// is not NUL-terminated.
+/// \param reader The reader to read from.
+/// \param prefix The encoding of the length.
+/// \param string Receives a pointer to the characters of the string.
+/// \param length Receives the length of the string.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode if a varint length is malformed.
+cbin_err_t cbin_read_string(cbin_reader_t *reader, cbin_prefix_t prefix,
+                            const char **string, size_t *length);
+
+/// Starts a frame: a length in front of the bytes written until the
+/// matching cbin_writer_end_frame, filled in once they are known. Frames
+/// nest, and their bytes stay in the buffer of a flushing writer until the
+/// outermost one ends, the buffer growing if needed. Varint lengths reserve
+/// CBIN_FRAME_VARINT_SIZE bytes; the unused ones are removed in a single
+/// pass when the outermost frame ends, so every byte moves at most once
+/// however deep the frames nest. Until then positions include those bytes,
+/// and a checksummed region cannot end. Frames allocate their bookkeeping,
+/// so even a fixed writer must be destroyed once it used them.
+/// \param writer The writer to write to, which cannot be segmented.
+/// \param prefix The encoding of the length.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the writer is segmented.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_begin_frame(cbin_writer_t *writer,
+                                   cbin_prefix_t prefix);
+
+/// Ends the innermost frame, writing its length.
+/// \param writer The writer to write to.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no frame is open or the writer sought
+/// back before its start.
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if the length does not fit the
+/// prefix.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_end_frame(cbin_writer_t *writer);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_BLOB_H
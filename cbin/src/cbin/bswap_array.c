@@ -0,0 +1,190 @@
+#include "bswap_array.h"
+#include "cpu.h"
+#include "thread.h"
+#include <endianness/byte_swap.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(CBIN_HAVE_SSE2)
+#    include <emmintrin.h>
+#endif
+#if defined(CBIN_HAVE_DISPATCH)
+#    include <immintrin.h>
+#endif
+#if defined(CBIN_ARCH_NEON)
+#    include <arm_neon.h>
+#endif
+
+#define SCALAR_LOOP(bits)                                                      \
+    for (; i < count; i++) {                                                   \
+        uint##bits##_t v;                                                      \
+        memcpy(&v, s + i * ((bits) / 8), sizeof(v));                           \
+        v = bswap##bits(v);                                                    \
+        memcpy(d + i * ((bits) / 8), &v, sizeof(v));                           \
+    }
+
+static void bswap16_scalar(void *dst, const void *src, size_t count) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t i = 0;
+    SCALAR_LOOP(16)
+}
+static void bswap32_scalar(void *dst, const void *src, size_t count) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t i = 0;
+    SCALAR_LOOP(32)
+}
+static void bswap64_scalar(void *dst, const void *src, size_t count) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t i = 0;
+    SCALAR_LOOP(64)
+}
+
+#if defined(CBIN_HAVE_SSE2)
+// SSE2 has no byte shuffle, so bytes are swapped inside each 16-bit lane with
+// shifts and the 16-bit lanes are then reordered with word shuffles.
+static inline __m128i sse2_swap16(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+static inline __m128i sse2_swap32(__m128i v) {
+    v = sse2_swap16(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+static inline __m128i sse2_swap64(__m128i v) {
+    v = sse2_swap16(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+#    define SSE2_KERNEL(bits)                                                  \
+        static void bswap##bits##_sse2(void *dst, const void *src,             \
+                                       size_t count) {                         \
+            uint8_t *d = (uint8_t *)dst;                                       \
+            const uint8_t *s = (const uint8_t *)src;                           \
+            const size_t lanes = 128 / (bits);                                 \
+            size_t i = 0;                                                      \
+            for (; i + 2 * lanes <= count; i += 2 * lanes) {                   \
+                __m128i a = _mm_loadu_si128(                                   \
+                    (const __m128i *)(s + i * ((bits) / 8)));                  \
+                __m128i b = _mm_loadu_si128(                                   \
+                    (const __m128i *)(s + i * ((bits) / 8) + 16));             \
+                _mm_storeu_si128((__m128i *)(d + i * ((bits) / 8)),            \
+                                 sse2_swap##bits(a));                          \
+                _mm_storeu_si128((__m128i *)(d + i * ((bits) / 8) + 16),       \
+                                 sse2_swap##bits(b));                          \
+            }                                                                  \
+            for (; i + lanes <= count; i += lanes) {                           \
+                __m128i a = _mm_loadu_si128(                                   \
+                    (const __m128i *)(s + i * ((bits) / 8)));                  \
+                _mm_storeu_si128((__m128i *)(d + i * ((bits) / 8)),            \
+                                 sse2_swap##bits(a));                          \
+            }                                                                  \
+            SCALAR_LOOP(bits)                                                  \
+        }
+
+SSE2_KERNEL(16)
+SSE2_KERNEL(32)
+SSE2_KERNEL(64)
+#endif
+
+#if defined(CBIN_HAVE_DISPATCH)
+#    define AVX2_KERNEL(bits, ...)                                             \
+        CBIN_TARGET("avx2")                                                    \
+        static void bswap##bits##_avx2(void *dst, const void *src,             \
+                                       size_t count) {                         \
+            uint8_t *d = (uint8_t *)dst;                                       \
+            const uint8_t *s = (const uint8_t *)src;                           \
+            const __m256i mask = _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__);   \
+            const size_t lanes = 256 / (bits);                                 \
+            size_t i = 0;                                                      \
+            for (; i + 2 * lanes <= count; i += 2 * lanes) {                   \
+                __m256i a = _mm256_loadu_si256(                                \
+                    (const __m256i *)(s + i * ((bits) / 8)));                  \
+                __m256i b = _mm256_loadu_si256(                                \
+                    (const __m256i *)(s + i * ((bits) / 8) + 32));             \
+                _mm256_storeu_si256((__m256i *)(d + i * ((bits) / 8)),         \
+                                    _mm256_shuffle_epi8(a, mask));             \
+                _mm256_storeu_si256((__m256i *)(d + i * ((bits) / 8) + 32),    \
+                                    _mm256_shuffle_epi8(b, mask));             \
+            }                                                                  \
+            for (; i + lanes <= count; i += lanes) {                           \
+                __m256i a = _mm256_loadu_si256(                                \
+                    (const __m256i *)(s + i * ((bits) / 8)));                  \
+                _mm256_storeu_si256((__m256i *)(d + i * ((bits) / 8)),         \
+                                    _mm256_shuffle_epi8(a, mask));             \
+            }                                                                  \
+            SCALAR_LOOP(bits)                                                  \
+        }
+
+AVX2_KERNEL(16, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+AVX2_KERNEL(32, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+AVX2_KERNEL(64, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+#endif
+
+#if defined(CBIN_ARCH_NEON)
+#    define NEON_KERNEL(bits, rev)                                             \
+        static void bswap##bits##_neon(void *dst, const void *src,             \
+                                       size_t count) {                         \
+            uint8_t *d = (uint8_t *)dst;                                       \
+            const uint8_t *s = (const uint8_t *)src;                           \
+            const size_t lanes = 128 / (bits);                                 \
+            size_t i = 0;                                                      \
+            for (; i + 2 * lanes <= count; i += 2 * lanes) {                   \
+                uint8x16_t a = vld1q_u8(s + i * ((bits) / 8));                 \
+                uint8x16_t b = vld1q_u8(s + i * ((bits) / 8) + 16);            \
+                vst1q_u8(d + i * ((bits) / 8), rev(a));                        \
+                vst1q_u8(d + i * ((bits) / 8) + 16, rev(b));                   \
+            }                                                                  \
+            for (; i + lanes <= count; i += lanes) {                           \
+                uint8x16_t a = vld1q_u8(s + i * ((bits) / 8));                 \
+                vst1q_u8(d + i * ((bits) / 8), rev(a));                        \
+            }                                                                  \
+            SCALAR_LOOP(bits)                                                  \
+        }
+
+NEON_KERNEL(16, vrev16q_u8)
+NEON_KERNEL(32, vrev32q_u8)
+NEON_KERNEL(64, vrev64q_u8)
+#endif
+
+#if defined(CBIN_ARCH_NEON)
+#    define BASELINE(bits) bswap##bits##_neon
+#elif defined(CBIN_HAVE_SSE2)
+#    define BASELINE(bits) bswap##bits##_sse2
+#else
+#    define BASELINE(bits) bswap##bits##_scalar
+#endif
+
+#if defined(CBIN_HAVE_DISPATCH)
+#    define SELECT(bits)                                                       \
+        ((cbin_cpu_features() & CBIN_CPU_AVX2) ? bswap##bits##_avx2            \
+                                               : BASELINE(bits))
+#else
+#    define SELECT(bits) BASELINE(bits)
+#endif
+
+// Below this many values the dispatch and vector setup cost more than they
+// save, so short arrays stay on the scalar path.
+#define SMALL_COUNT 8
+
+#define DISPATCH(bits)                                                         \
+    void cbin_bswap##bits##_array(void *dst, const void *src, size_t count) {  \
+        static volatile cbin_bswap_array_fn cached = NULL;                     \
+        if (count < SMALL_COUNT) {                                             \
+            bswap##bits##_scalar(dst, src, count);                             \
+            return;                                                            \
+        }                                                                      \
+        cbin_bswap_array_fn impl = cbin_atomic_load_fn(&cached);               \
+        if (CBIN_UNLIKELY(impl == NULL)) {                                     \
+            impl = SELECT(bits);                                               \
+            cbin_atomic_store_fn(&cached, impl);                               \
+        }                                                                      \
+        impl(dst, src, count);                                                 \
+    }
+
+DISPATCH(16)
+DISPATCH(32)
+DISPATCH(64)
@@ -0,0 +1,29 @@
+#ifndef CBIN_SRC_CBIN_BSWAP_ARRAY_H
+#define CBIN_SRC_CBIN_BSWAP_ARRAY_H
+#include "common.h"
+
+typedef void (*cbin_bswap_array_fn)(void *dst, const void *src, size_t count);
+
+CBIN_HEADER_BEGIN
+
+/// Byte-swaps an array of 16-bit values.
+/// \param dst The destination array, may be the same as \p src.
+/// \param src The source array, alignment is not required.
+/// \param count The number of values to swap.
+void cbin_bswap16_array(void *dst, const void *src, size_t count);
+
+/// Byte-swaps an array of 32-bit values.
+/// \param dst The destination array, may be the same as \p src.
+/// \param src The source array, alignment is not required.
+/// \param count The number of values to swap.
+void cbin_bswap32_array(void *dst, const void *src, size_t count);
+
+/// Byte-swaps an array of 64-bit values.
+/// \param dst The destination array, may be the same as \p src.
+/// \param src The source array, alignment is not required.
+/// \param count The number of values to swap.
+void cbin_bswap64_array(void *dst, const void *src, size_t count);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_BSWAP_ARRAY_H
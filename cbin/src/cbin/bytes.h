@@ -0,0 +1,92 @@
+#ifndef CBIN_SRC_CBIN_BYTES_H
+#define CBIN_SRC_CBIN_BYTES_H
+#include "common.h"
+#include <stdint.h>
+#include <string.h>
+
+// Endian-independent loads and stores. The shift-and-or forms are recognized
+// by GCC and Clang and compile to a single (byte-swapping) move, so they are
+// usable from the inline fast paths without the endianness dependency.
+
+static inline uint16_t cbin_load_u16_le(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+static inline uint16_t cbin_load_u16_be(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return ((uint16_t)p[0] << 8) | (uint16_t)p[1];
+}
+static inline void cbin_store_u16_le(void *ptr, uint16_t value) {
+    uint8_t *p = (uint8_t *)ptr;
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+static inline void cbin_store_u16_be(void *ptr, uint16_t value) {
+    uint8_t *p = (uint8_t *)ptr;
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+static inline uint32_t cbin_load_u32_le(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+static inline uint32_t cbin_load_u32_be(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+static inline void cbin_store_u32_le(void *ptr, uint32_t value) {
+    uint8_t *p = (uint8_t *)ptr;
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+static inline void cbin_store_u32_be(void *ptr, uint32_t value) {
+    uint8_t *p = (uint8_t *)ptr;
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+static inline uint64_t cbin_load_u64_le(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+           ((uint64_t)p[3] << 24) | ((uint64_t)p[4] << 32) |
+           ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) |
+           ((uint64_t)p[7] << 56);
+}
+static inline uint64_t cbin_load_u64_be(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+           ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+static inline void cbin_store_u64_le(void *ptr, uint64_t value) {
+    uint8_t *p = (uint8_t *)ptr;
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    p[4] = (uint8_t)(value >> 32);
+    p[5] = (uint8_t)(value >> 40);
+    p[6] = (uint8_t)(value >> 48);
+    p[7] = (uint8_t)(value >> 56);
+}
+static inline void cbin_store_u64_be(void *ptr, uint64_t value) {
+    uint8_t *p = (uint8_t *)ptr;
+    p[0] = (uint8_t)(value >> 56);
+    p[1] = (uint8_t)(value >> 48);
+    p[2] = (uint8_t)(value >> 40);
+    p[3] = (uint8_t)(value >> 32);
+    p[4] = (uint8_t)(value >> 24);
+    p[5] = (uint8_t)(value >> 16);
+    p[6] = (uint8_t)(value >> 8);
+    p[7] = (uint8_t)value;
+}
+
+#endif // CBIN_SRC_CBIN_BYTES_H
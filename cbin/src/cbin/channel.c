@@ -0,0 +1,155 @@
+#include "channel.h"
+#include "thread.h"
+#include <string.h>
+
+// A record header is the span of the record, header included, followed by
+// its commit word: 0 while unpublished, the length of the message plus one,
+// or CHANNEL_SKIP for padding and dropped messages.
+#define CHANNEL_HEADER 8
+#define CHANNEL_SKIP UINT32_MAX
+#define CHANNEL_MIN_CAPACITY 64
+
+static inline size_t cbin_channel_span(size_t size) {
+    return CHANNEL_HEADER + ((size + 7) & ~(size_t)7);
+}
+
+cbin_err_t cbin_channel_init(cbin_channel_t *channel, size_t capacity,
+                             unsigned flags) {
+    memset(channel, 0, sizeof(*channel));
+    size_t size = CHANNEL_MIN_CAPACITY;
+    while (size < capacity) {
+        if (size > (size_t)-1 / 2)
+            return CBIN_ERR_OUT_OF_MEMORY;
+        size <<= 1;
+    }
+    channel->_ring = (uint8_t *)CBIN_REALLOC(NULL, size);
+    if (!channel->_ring)
+        return CBIN_ERR_OUT_OF_MEMORY;
+    // Several producers publish through the commit words, which have to
+    // read as 0 until then.
+    memset(channel->_ring, 0, size);
+    channel->_capacity = size;
+    channel->_multi = (flags & CBIN_CHANNEL_MPSC) != 0;
+    return CBIN_ERR_OK;
+}
+
+void cbin_channel_destroy(cbin_channel_t *channel) {
+    if (channel->_ring)
+        CBIN_FREE(channel->_ring);
+    memset(channel, 0, sizeof(*channel));
+}
+
+cbin_err_t cbin_channel_reserve(cbin_channel_t *channel, cbin_writer_t *writer,
+                                size_t size) {
+    size_t capacity = channel->_capacity;
+    // With at most half of the ring per record, a record always fits either
+    // before the end of the ring or at its start once the ring drains.
+    if (size > capacity / 2 - CHANNEL_HEADER || size > UINT32_MAX / 2)
+        return CBIN_ERR_OUT_OF_MEMORY;
+    size_t span = cbin_channel_span(size);
+    size_t tail, offset, pad;
+    if (!channel->_multi) {
+        tail = channel->_tail;
+        offset = tail & (capacity - 1);
+        pad = offset + span > capacity ? capacity - offset : 0;
+        if (tail + pad + span - channel->_head_cache > capacity) {
+            channel->_head_cache = cbin_atomic_load_acquire(&channel->_head);
+            if (tail + pad + span - channel->_head_cache > capacity)
+                return CBIN_ERR_FAILED;
+        }
+        if (pad) {
+            // Only visible to the consumer once the tail moves past it.
+            uint32_t *header = (uint32_t *)(channel->_ring + offset);
+            header[0] = (uint32_t)pad;
+            header[1] = CHANNEL_SKIP;
+        }
+    } else {
+        do {
+            // The head is loaded first, so it can never be past the tail.
+            size_t head = cbin_atomic_load_acquire(&channel->_head);
+            tail = cbin_atomic_load_size(&channel->_tail);
+            offset = tail & (capacity - 1);
+            pad = offset + span > capacity ? capacity - offset : 0;
+            if (tail + pad + span - head > capacity)
+                return CBIN_ERR_FAILED;
+        } while (!cbin_atomic_cas_size(&channel->_tail, tail,
+                                       tail + pad + span));
+        if (pad) {
+            uint32_t *header = (uint32_t *)(channel->_ring + offset);
+            header[0] = (uint32_t)pad;
+            cbin_atomic_store_release_u32(&header[1], CHANNEL_SKIP);
+        }
+    }
+    uint8_t *record = channel->_ring + ((tail + pad) & (capacity - 1));
+    ((uint32_t *)record)[0] = (uint32_t)span;
+    cbin_writer_init_fixed(writer, record + CHANNEL_HEADER,
+                           span - CHANNEL_HEADER);
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_channel_publish(cbin_channel_t *channel,
+                                cbin_writer_t *writer) {
+    uint8_t *record = (uint8_t *)cbin_writer_buffer(writer) - CHANNEL_HEADER;
+    uint32_t *header = (uint32_t *)record;
+    cbin_err_t err = cbin_writer_error(writer);
+    size_t length = cbin_writer_position(writer);
+    if (channel->_multi) {
+        cbin_atomic_store_release_u32(
+            &header[1], err ? CHANNEL_SKIP : (uint32_t)length + 1);
+        return err;
+    }
+    // A single producer has not moved the tail yet, so a dropped message
+    // simply leaves its space to the next one, and an unused part of the
+    // reservation is given back.
+    if (err)
+        return err;
+    size_t capacity = channel->_capacity;
+    size_t span = cbin_channel_span(length);
+    header[0] = (uint32_t)span;
+    header[1] = (uint32_t)length + 1;
+    size_t tail = channel->_tail;
+    size_t offset = (size_t)(record - channel->_ring);
+    tail += ((offset - tail) & (capacity - 1)) + span;
+    cbin_atomic_store_release(&channel->_tail, tail);
+    return CBIN_ERR_OK;
+}
+
+static void cbin_channel_advance(cbin_channel_t *channel, uint32_t *header) {
+    size_t span = header[0];
+    if (channel->_multi)
+        memset(header, 0, span);
+    cbin_atomic_store_release(&channel->_head, channel->_head + span);
+}
+
+cbin_err_t cbin_channel_receive(cbin_channel_t *channel,
+                                cbin_reader_t *reader) {
+    size_t mask = channel->_capacity - 1;
+    for (;;) {
+        size_t head = channel->_head;
+        uint32_t *header = (uint32_t *)(channel->_ring + (head & mask));
+        uint32_t commit;
+        if (!channel->_multi) {
+            if (head == channel->_tail_cache) {
+                channel->_tail_cache =
+                    cbin_atomic_load_acquire(&channel->_tail);
+                if (head == channel->_tail_cache)
+                    return CBIN_ERR_FAILED;
+            }
+            commit = header[1];
+        } else {
+            commit = cbin_atomic_load_acquire_u32(&header[1]);
+            if (commit == 0)
+                return CBIN_ERR_FAILED;
+        }
+        if (commit != CHANNEL_SKIP) {
+            cbin_reader_init(reader, header + 2, commit - 1);
+            return CBIN_ERR_OK;
+        }
+        cbin_channel_advance(channel, header);
+    }
+}
+
+void cbin_channel_release(cbin_channel_t *channel, cbin_reader_t *reader) {
+    const uint8_t *payload = (const uint8_t *)cbin_reader_buffer(reader);
+    cbin_channel_advance(channel, (uint32_t *)(payload - CHANNEL_HEADER));
+}
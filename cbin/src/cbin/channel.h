@@ -0,0 +1,95 @@
+#ifndef CBIN_SRC_CBIN_CHANNEL_H
+#define CBIN_SRC_CBIN_CHANNEL_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+// A bounded, lock-free channel of encoded messages between threads, over a
+// ring of bytes. A producer reserves a message and encodes it with a fixed
+// writer directly in the ring, the consumer decodes it in place with a
+// reader: nothing is allocated or copied per message. Every message has an
+// 8-byte header, its span and its length, and is padded to 8 bytes. A
+// message that does not fit before the end of the ring is preceded by a
+// padding record that the consumer skips.
+//
+// With a single producer, messages are published by advancing the tail and
+// the unused part of a reservation is given back. With several producers
+// (CBIN_CHANNEL_MPSC), space is claimed with a compare-and-swap on the tail
+// and each message is published through its own header, so producers never
+// wait for each other; the consumer then zeroes the messages it releases.
+// There is a single consumer in both cases.
+
+/// Allows several threads to produce concurrently.
+#define CBIN_CHANNEL_MPSC (1u << 0)
+
+typedef struct cbin_channel_s {
+    uint8_t *_ring;
+    size_t _capacity;
+    bool _multi;
+    uint8_t _pad0[CBIN_CACHE_LINE];
+
+    // Producer side, _head_cache is only used by a single producer.
+    volatile size_t _tail;
+    size_t _head_cache;
+    uint8_t _pad1[CBIN_CACHE_LINE];
+
+    // Consumer side, _tail_cache is only used with a single producer.
+    volatile size_t _head;
+    size_t _tail_cache;
+    uint8_t _pad2[CBIN_CACHE_LINE];
+} cbin_channel_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes an empty channel.
+/// \param channel The channel to initialize.
+/// \param capacity The size of the ring, rounded up to a power of two. A
+/// message cannot take more than half of it.
+/// \param flags CBIN_CHANNEL_MPSC for several producers, or 0.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_channel_init(cbin_channel_t *channel, size_t capacity,
+                             unsigned flags);
+
+/// Frees the ring of a channel, no thread may use it anymore.
+/// \param channel The channel to destroy.
+void cbin_channel_destroy(cbin_channel_t *channel);
+
+/// Reserves a message and initializes a fixed writer over it, in the ring.
+/// The message must then be published, before the next reservation of the
+/// same producer.
+/// \param channel The channel to produce to.
+/// \param writer The writer to initialize.
+/// \param size The maximum size of the message.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the channel is full for now.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode if the size can never fit.
+cbin_err_t cbin_channel_reserve(cbin_channel_t *channel, cbin_writer_t *writer,
+                                size_t size);
+
+/// Publishes the bytes written to a reserved message. A writer in error,
+/// such as one that overflowed its reservation, is dropped instead.
+/// \param channel The channel the message was reserved in.
+/// \param writer The writer returned by cbin_channel_reserve.
+/// \return \code CBIN_ERR_OK \endcode or the error of the writer.
+cbin_err_t cbin_channel_publish(cbin_channel_t *channel,
+                                cbin_writer_t *writer);
+
+/// Initializes a reader over the oldest published message, in place. It
+/// stays valid until cbin_channel_release, receiving again without
+/// releasing returns the same message.
+/// \param channel The channel to consume from.
+/// \param reader The reader to initialize.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no message is published yet.
+cbin_err_t cbin_channel_receive(cbin_channel_t *channel,
+                                cbin_reader_t *reader);
+
+/// Gives the space of a received message back to the producers.
+/// \param channel The channel the message was received from.
+/// \param reader The reader returned by cbin_channel_receive.
+void cbin_channel_release(cbin_channel_t *channel, cbin_reader_t *reader);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_CHANNEL_H
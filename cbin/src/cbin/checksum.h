@@ -0,0 +1,92 @@
+#ifndef CBIN_SRC_CBIN_CHECKSUM_H
+#define CBIN_SRC_CBIN_CHECKSUM_H
+#include "common.h"
+#include <stdint.h>
+
+/// Readers and writers add the bytes of a checksummed region to its checksum
+/// in blocks of at least this size, while they are still in cache.
+#define CBIN_CHECKSUM_BLOCK 4096
+
+/// The algorithm of a checksum.
+typedef enum cbin_checksum_type_e {
+    /// CRC-32C (Castagnoli), stored as a u32_le.
+    CBIN_CHECKSUM_CRC32C,
+    /// xxHash64 with a seed of 0, stored as a u64_le.
+    CBIN_CHECKSUM_XXH64,
+} cbin_checksum_type_t;
+
+/// The state of an incremental xxHash64.
+typedef struct cbin_xxh64_s {
+    uint64_t _lanes[4];
+    uint64_t _total;
+    uint64_t _seed;
+    uint8_t _buffer[32];
+    size_t _buffered;
+} cbin_xxh64_t;
+
+/// An incremental checksum, either updated by hand or attached to a reader
+/// or writer to cover a region of its bytes.
+typedef struct cbin_checksum_s {
+    cbin_checksum_type_t _type;
+    uint32_t _crc;
+    cbin_xxh64_t _xxh;
+} cbin_checksum_t;
+
+CBIN_HEADER_BEGIN
+
+/// Updates a CRC-32C, using the CRC instructions of SSE4.2 or ARMv8 when
+/// available.
+/// \param crc The CRC of the previous bytes, 0 for the first ones.
+/// \param data The bytes to add.
+/// \param size The number of bytes to add.
+/// \return The CRC of all the bytes so far.
+uint32_t cbin_crc32c(uint32_t crc, const void *data, size_t size);
+
+/// Initializes an incremental xxHash64.
+/// \param state The state to initialize.
+/// \param seed The seed of the hash.
+void cbin_xxh64_init(cbin_xxh64_t *state, uint64_t seed);
+
+/// Adds bytes to an incremental xxHash64.
+/// \param state The state to update.
+/// \param data The bytes to add.
+/// \param size The number of bytes to add.
+void cbin_xxh64_update(cbin_xxh64_t *state, const void *data, size_t size);
+
+/// Returns the xxHash64 of the bytes added so far.
+/// \param state The state to get the hash of.
+/// \return The hash.
+uint64_t cbin_xxh64_digest(const cbin_xxh64_t *state);
+
+/// Computes the xxHash64 of a buffer.
+/// \param data The bytes to hash.
+/// \param size The number of bytes to hash.
+/// \param seed The seed of the hash.
+/// \return The hash.
+uint64_t cbin_xxh64(const void *data, size_t size, uint64_t seed);
+
+/// Initializes an empty checksum.
+/// \param checksum The checksum to initialize.
+/// \param type The algorithm of the checksum.
+void cbin_checksum_init(cbin_checksum_t *checksum, cbin_checksum_type_t type);
+
+/// Adds bytes to a checksum.
+/// \param checksum The checksum to update.
+/// \param data The bytes to add.
+/// \param size The number of bytes to add.
+void cbin_checksum_update(cbin_checksum_t *checksum, const void *data,
+                          size_t size);
+
+/// Returns the checksum of the bytes added so far.
+/// \param checksum The checksum to get the value of.
+/// \return The checksum, widened to 64 bits for CRC-32C.
+uint64_t cbin_checksum_digest(const cbin_checksum_t *checksum);
+
+/// Returns the size of the checksum once stored.
+/// \param checksum The checksum to get the size of.
+/// \return 4 for CRC-32C, 8 for xxHash64.
+size_t cbin_checksum_size(const cbin_checksum_t *checksum);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_CHECKSUM_H
@@ -43,6 +43,9 @@
 #define CBIN_ERR_FAILED 1
 #define CBIN_ERR_OUT_OF_BOUNDS 2
 #define CBIN_ERR_OUT_OF_MEMORY 3
+#define CBIN_ERR_IO 4
+#define CBIN_ERR_CORRUPT 5
+#define CBIN_ERR_CHECKSUM 6
 
 #if defined(__clang__) || defined(__GNUC__)
 #    define CBIN_LIKELY(x) __builtin_expect(!!(x), 1)
@@ -52,6 +55,12 @@
 #    define CBIN_UNLIKELY(x) (x)
 #endif
 
+/// The size of a cache line, which state written by different threads is
+/// kept apart by.
+#ifndef CBIN_CACHE_LINE
+#    define CBIN_CACHE_LINE 64
+#endif
+
 typedef int cbin_err_t;
 
 #endif // CBIN_SRC_CBIN_COMMON_H
@@ -0,0 +1,371 @@
+#include "compress.h"
+#include "bytes.h"
+#include <string.h>
+
+#define MIN_MATCH 4
+// The last bytes of a block are always literals and no match starts in its
+// last MF_LIMIT bytes, which lets the compressor load words without bounds
+// checks near the end.
+#define LAST_LITERALS 5
+#define MF_LIMIT 12
+#define MAX_OFFSET 65535
+#define HASH_SIZE ((size_t)1 << CBIN_COMPRESS_HASH_BITS)
+// Failed lookups in a row before the compressor starts skipping bytes, so
+// that incompressible input is crossed quickly.
+#define SKIP_TRIGGER 6
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define CTZ64(x) ((size_t)__builtin_ctzll(x))
+#else
+static size_t CTZ64(uint64_t x) {
+    size_t n = 0;
+    while (!(x & 1))
+        x >>= 1, n++;
+    return n;
+}
+#endif
+
+cbin_err_t cbin_compressor_init(cbin_compressor_t *compressor) {
+    compressor->_table =
+        (uint32_t *)CBIN_REALLOC(NULL, HASH_SIZE * sizeof(uint32_t));
+    compressor->_base = 1;
+    compressor->_scratch = NULL;
+    compressor->_scratch_size = 0;
+    if (!compressor->_table)
+        return CBIN_ERR_OUT_OF_MEMORY;
+    memset(compressor->_table, 0, HASH_SIZE * sizeof(uint32_t));
+    return CBIN_ERR_OK;
+}
+void cbin_compressor_destroy(cbin_compressor_t *compressor) {
+    CBIN_FREE(compressor->_table);
+    CBIN_FREE(compressor->_scratch);
+    compressor->_table = NULL;
+    compressor->_scratch = NULL;
+    compressor->_scratch_size = 0;
+}
+size_t cbin_compress_bound(size_t size) { return size + size / 255 + 16; }
+
+static inline uint32_t cbin_lz_hash(const uint8_t *p) {
+    return (cbin_load_u32_le(p) * 2654435761u) >>
+           (32 - CBIN_COMPRESS_HASH_BITS);
+}
+
+// Counts the bytes shared by a and b, stopping at limit.
+static inline size_t cbin_lz_count(const uint8_t *a, const uint8_t *b,
+                                   const uint8_t *limit) {
+    const uint8_t *start = a;
+    while (a + 8 <= limit) {
+        uint64_t diff = cbin_load_u64_le(a) ^ cbin_load_u64_le(b);
+        if (diff)
+            return (size_t)(a - start) + CTZ64(diff) / 8;
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b)
+        a++, b++;
+    return (size_t)(a - start);
+}
+
+// Writes the extension bytes of a length that did not fit in its token.
+static inline uint8_t *cbin_lz_length(uint8_t *op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+// Writes a token and its literals, followed by a match unless match is 0.
+static uint8_t *cbin_lz_sequence(uint8_t *op, const uint8_t *literals,
+                                 size_t count, size_t offset, size_t match) {
+    uint8_t *token = op++;
+    size_t extra = match ? match - MIN_MATCH : 0;
+    *token = (uint8_t)(((count < 15 ? count : 15) << 4) |
+                       (extra < 15 ? extra : 15));
+    if (count >= 15)
+        op = cbin_lz_length(op, count - 15);
+    if (count) {
+        memcpy(op, literals, count);
+        op += count;
+    }
+    if (!match)
+        return op;
+    cbin_store_u16_le(op, (uint16_t)offset);
+    op += 2;
+    if (extra >= 15)
+        op = cbin_lz_length(op, extra - 15);
+    return op;
+}
+
+cbin_err_t cbin_compress(cbin_compressor_t *compressor, const void *data,
+                         size_t size, void *out, size_t capacity,
+                         size_t *compressed) {
+    if (size > UINT32_MAX || capacity < cbin_compress_bound(size))
+        return CBIN_ERR_OUT_OF_BOUNDS;
+    const uint8_t *src = (const uint8_t *)data;
+    uint8_t *op = (uint8_t *)out;
+    size_t anchor = 0;
+    if (size > MF_LIMIT) {
+        // Entries are stored as positions past _base, which moves forward
+        // with every block: entries of earlier blocks fall below it and are
+        // ignored, so the table never has to be cleared between blocks. The
+        // base starts at 1 so that cleared entries are never valid.
+        uint32_t *table = compressor->_table;
+        if (size > UINT32_MAX - compressor->_base) {
+            memset(table, 0, HASH_SIZE * sizeof(uint32_t));
+            compressor->_base = 1;
+        }
+        uint32_t base = compressor->_base;
+        size_t limit = size - MF_LIMIT;
+        const uint8_t *match_limit = src + size - LAST_LITERALS;
+        size_t ip = 0;
+        size_t misses = 0;
+        while (ip < limit) {
+            uint32_t h = cbin_lz_hash(src + ip);
+            uint32_t entry = table[h];
+            table[h] = base + (uint32_t)ip;
+            size_t ref = (size_t)(entry - base);
+            if (entry < base || ip - ref > MAX_OFFSET ||
+                cbin_load_u32_le(src + ref) != cbin_load_u32_le(src + ip)) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+                ip--, ref--;
+            size_t length =
+                MIN_MATCH + cbin_lz_count(src + ip + MIN_MATCH,
+                                          src + ref + MIN_MATCH, match_limit);
+            op = cbin_lz_sequence(op, src + anchor, ip - anchor, ip - ref,
+                                  length);
+            ip += length;
+            anchor = ip;
+            misses = 0;
+            if (ip < limit)
+                table[cbin_lz_hash(src + ip - 2)] = base + (uint32_t)ip - 2;
+        }
+        compressor->_base = base + (uint32_t)size;
+    }
+    op = cbin_lz_sequence(op, src + anchor, size - anchor, 0, 0);
+    *compressed = (size_t)(op - (uint8_t *)out);
+    return CBIN_ERR_OK;
+}
+
+// Reads the extension bytes of a length, returns false past the input.
+static inline bool cbin_lz_read_length(const uint8_t **ip, const uint8_t *end,
+                                       size_t *length) {
+    uint8_t byte;
+    do {
+        if (*ip == end)
+            return false;
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+cbin_err_t cbin_decompress(const void *data, size_t size, void *out,
+                           size_t capacity, size_t *decompressed) {
+    const uint8_t *ip = (const uint8_t *)data;
+    const uint8_t *end = ip + size;
+    uint8_t *op = (uint8_t *)out;
+    uint8_t *out_end = op + capacity;
+    if (size == 0)
+        return CBIN_ERR_CORRUPT;
+    for (;;) {
+        if (ip == end)
+            return CBIN_ERR_CORRUPT;
+        uint8_t token = *ip++;
+        size_t count = token >> 4;
+        if (count == 15 && !cbin_lz_read_length(&ip, end, &count))
+            return CBIN_ERR_CORRUPT;
+        if (count > (size_t)(end - ip) || count > (size_t)(out_end - op))
+            return CBIN_ERR_CORRUPT;
+        if (count <= 16 && end - ip >= 16 && out_end - op >= 16) {
+            memcpy(op, ip, 16);
+        } else if (count) {
+            memcpy(op, ip, count);
+        }
+        op += count;
+        ip += count;
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return CBIN_ERR_CORRUPT;
+        size_t offset = cbin_load_u16_le(ip);
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !cbin_lz_read_length(&ip, end, &length))
+            return CBIN_ERR_CORRUPT;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t *)out) ||
+            length > (size_t)(out_end - op))
+            return CBIN_ERR_CORRUPT;
+        const uint8_t *match = op - offset;
+        uint8_t *match_end = op + length;
+        if ((size_t)(out_end - match_end) >= 8 &&
+            (offset >= 8 || length >= 16)) {
+            if (offset < 8) {
+                // Repeats a short pattern until it spans a word, the rest
+                // is then copied from a multiple of the offset at least a
+                // word away.
+                size_t period = offset * ((8 + offset - 1) / offset);
+                for (size_t i = 0; i < period; i++)
+                    op[i] = match[i];
+                op += period;
+                match = op - period;
+            }
+            // Copies in words, overshooting the match by up to 7 bytes
+            // which the next sequence overwrites.
+            do {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < match_end);
+        } else {
+            // Overlapping matches repeat the last offset bytes.
+            while (op < match_end)
+                *op++ = *match++;
+        }
+        op = match_end;
+    }
+    *decompressed = (size_t)(op - (uint8_t *)out);
+    return CBIN_ERR_OK;
+}
+
+static bool cbin_compressor_scratch(cbin_compressor_t *compressor,
+                                    size_t size) {
+    if (compressor->_scratch_size >= size)
+        return true;
+    // The old contents are not needed, so there is nothing to copy.
+    CBIN_FREE(compressor->_scratch);
+    compressor->_scratch = CBIN_REALLOC(NULL, size);
+    compressor->_scratch_size = compressor->_scratch ? size : 0;
+    return compressor->_scratch != NULL;
+}
+
+// Writes the header and the payload of a block to a buffer of at least
+// CBIN_COMPRESS_HEADER + cbin_compress_bound(size) bytes.
+static size_t cbin_compress_block(cbin_compressor_t *compressor,
+                                  const void *data, size_t size,
+                                  uint8_t *out) {
+    size_t stored = 0;
+    cbin_compress(compressor, data, size, out + CBIN_COMPRESS_HEADER,
+                  cbin_compress_bound(size), &stored);
+    if (stored >= size) {
+        if (size)
+            memcpy(out + CBIN_COMPRESS_HEADER, data, size);
+        stored = size;
+    }
+    cbin_store_u32_le(out, (uint32_t)size);
+    cbin_store_u32_le(out + 4, (uint32_t)stored);
+    return CBIN_COMPRESS_HEADER + stored;
+}
+
+cbin_err_t cbin_write_compressed(cbin_writer_t *writer,
+                                 cbin_compressor_t *compressor,
+                                 const void *data, size_t size) {
+    if (writer->_error)
+        return writer->_error;
+    if (size > UINT32_MAX)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+    size_t bound = CBIN_COMPRESS_HEADER + cbin_compress_bound(size);
+    bool direct = writer->_position + bound <= writer->_capacity ||
+                  writer->_chunk_size != 0 ||
+                  (writer->_sink ? bound <= writer->_capacity
+                                 : writer->_owns_buffer || writer->_inline);
+    if (direct) {
+        if (cbin_writer_ensure(writer, bound))
+            return writer->_error;
+        size_t written =
+            cbin_compress_block(compressor, data, size,
+                                (uint8_t *)writer->_buffer + writer->_position);
+        return cbin_writer_reserve(writer, written, NULL);
+    }
+    if (!cbin_compressor_scratch(compressor, bound))
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    size_t written = cbin_compress_block(compressor, data, size,
+                                         (uint8_t *)compressor->_scratch);
+    return cbin_write(writer, compressor->_scratch, written);
+}
+
+cbin_err_t cbin_writer_compress(cbin_writer_t *writer,
+                                cbin_compressor_t *compressor) {
+    if (writer->_error)
+        return writer->_error;
+    if (writer->_sink || writer->_chunk_size || writer->_checksum)
+        return CBIN_ERROR(writer, CBIN_ERR_FAILED);
+    size_t size = writer->_written;
+    if (size > UINT32_MAX)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+    size_t bound = CBIN_COMPRESS_HEADER + cbin_compress_bound(size);
+    if (!cbin_compressor_scratch(compressor, bound))
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    size_t written = cbin_compress_block(compressor, writer->_buffer, size,
+                                         (uint8_t *)compressor->_scratch);
+    if (writer->_owns_buffer && !writer->_allocator) {
+        void *buffer = writer->_buffer;
+        size_t capacity = writer->_capacity;
+        writer->_buffer = compressor->_scratch;
+        writer->_capacity = compressor->_scratch_size;
+        compressor->_scratch = buffer;
+        compressor->_scratch_size = buffer ? capacity : 0;
+    } else {
+        if (written > writer->_capacity) {
+            if (!writer->_owns_buffer && !writer->_inline)
+                return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+            // The old bytes are replaced, an inline buffer is not copied.
+            void *buffer = writer->_owns_buffer
+                               ? cbin_allocator_realloc(
+                                     writer->_allocator, writer->_buffer,
+                                     writer->_capacity, written)
+                               : cbin_allocator_realloc(writer->_allocator,
+                                                        NULL, 0, written);
+            if (!buffer)
+                return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+            writer->_buffer = buffer;
+            writer->_capacity = written;
+            writer->_owns_buffer = true;
+        }
+        memcpy(writer->_buffer, compressor->_scratch, written);
+    }
+    writer->_position = written;
+    writer->_written = written;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_reader_init_compressed(cbin_reader_t *reader,
+                                       cbin_reader_t *source) {
+    cbin_reader_init(reader, NULL, 0);
+    uint32_t size, stored;
+    const void *payload;
+    if (cbin_read_u32_le(source, &size) ||
+        cbin_read_u32_le(source, &stored))
+        return CBIN_ERROR(reader, source->_error);
+    // A sequence expands to at most 255 bytes per byte of payload.
+    if (stored > size || (uint64_t)size > (uint64_t)stored * 255 + 16)
+        return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+    if (cbin_read_view(source, stored, &payload))
+        return CBIN_ERROR(reader, source->_error);
+    if (size == 0)
+        return CBIN_ERR_OK;
+    void *buffer = CBIN_REALLOC(NULL, size);
+    if (!buffer)
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_MEMORY);
+    if (stored == size) {
+        memcpy(buffer, payload, size);
+    } else {
+        size_t decompressed = 0;
+        if (cbin_decompress(payload, stored, buffer, size, &decompressed) ||
+            decompressed != size) {
+            CBIN_FREE(buffer);
+            return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+        }
+    }
+    // The buffer is owned through _window, which cbin_reader_destroy frees.
+    reader->_window = buffer;
+    reader->_buffer = buffer;
+    reader->_size = size;
+    return CBIN_ERR_OK;
+}
@@ -0,0 +1,120 @@
+#ifndef CBIN_SRC_CBIN_COMPRESS_H
+#define CBIN_SRC_CBIN_COMPRESS_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+// A byte-oriented LZ77 codec in the LZ4 block format: sequences of a token,
+// literals, a u16_le match offset and a match length, with no entropy stage.
+// Compressed blocks written by the reader and writer helpers carry a header:
+//
+//   u32_le raw size, u32_le stored size, payload
+//
+// A payload whose stored size equals the raw size is kept uncompressed,
+// which is how incompressible input is written.
+
+/// The number of bits of the hash table of a compressor.
+#ifndef CBIN_COMPRESS_HASH_BITS
+#    define CBIN_COMPRESS_HASH_BITS 14
+#endif
+
+/// The size of the header of a compressed block.
+#define CBIN_COMPRESS_HEADER 8
+
+/// The reusable state of the compressor. Keeping one per thread avoids the
+/// allocation and the clearing of its tables for every message.
+typedef struct cbin_compressor_s {
+    uint32_t *_table;
+    uint32_t _base;
+    void *_scratch;
+    size_t _scratch_size;
+} cbin_compressor_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes a compressor.
+/// \param compressor The compressor to initialize.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_compressor_init(cbin_compressor_t *compressor);
+
+/// Destroys a compressor.
+/// \param compressor The compressor to destroy.
+void cbin_compressor_destroy(cbin_compressor_t *compressor);
+
+/// Returns the largest payload that compressing a number of bytes can give.
+/// \param size The number of bytes to compress.
+/// \return The bound, without the block header.
+size_t cbin_compress_bound(size_t size);
+
+/// Compresses bytes into a payload, without a block header.
+/// \param compressor The compressor to use.
+/// \param data The bytes to compress.
+/// \param size The number of bytes to compress, less than 4 GiB.
+/// \param out The buffer to compress into.
+/// \param capacity The size of the buffer, at least cbin_compress_bound.
+/// \param compressed Receives the size of the payload.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_compress(cbin_compressor_t *compressor, const void *data,
+                         size_t size, void *out, size_t capacity,
+                         size_t *compressed);
+
+/// Decompresses a payload produced by cbin_compress. The payload is fully
+/// validated, malformed input never reads or writes out of bounds. Bytes of
+/// the buffer past the decompressed ones may be overwritten.
+/// \param data The payload to decompress.
+/// \param size The size of the payload.
+/// \param out The buffer to decompress into.
+/// \param capacity The size of the buffer.
+/// \param decompressed Receives the number of bytes decompressed.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_CORRUPT \endcode if the payload is malformed or does not
+/// fit in the buffer.
+cbin_err_t cbin_decompress(const void *data, size_t size, void *out,
+                           size_t capacity, size_t *decompressed);
+
+/// Writes bytes as a compressed block. The payload is compressed straight
+/// into the buffer of the writer when it has room for the bound, otherwise
+/// through the scratch buffer of the compressor.
+/// \param writer The writer to write to.
+/// \param compressor The compressor to use.
+/// \param data The bytes to compress.
+/// \param size The number of bytes to compress, less than 4 GiB.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_compressed(cbin_writer_t *writer,
+                                 cbin_compressor_t *compressor,
+                                 const void *data, size_t size);
+
+/// Replaces everything written to a writer by a compressed block of it. The
+/// buffer of an owning writer is swapped with the scratch buffer of the
+/// compressor when both use the default allocator, so that finishing a
+/// message neither allocates nor copies once the compressor is warm.
+/// \param writer The writer to compress, which cannot be flushing or
+/// segmented.
+/// \param compressor The compressor to use.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if part of the output already left the
+/// writer.
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_compress(cbin_writer_t *writer,
+                                cbin_compressor_t *compressor);
+
+/// Reads a compressed block and initializes a reader over its bytes. The
+/// reader owns the decompressed buffer, destroy it with cbin_reader_destroy.
+/// With a streaming source the block must fit in its window.
+/// \param reader The reader to initialize.
+/// \param source The reader to read the block from.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_reader_init_compressed(cbin_reader_t *reader,
+                                       cbin_reader_t *source);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_COMPRESS_H
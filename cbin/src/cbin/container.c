@@ -0,0 +1,336 @@
+#include "container.h"
+#include "thread.h"
+#include <string.h>
+
+#define HEADER_SIZE 4
+#define FRAME_HEADER_SIZE 4
+#define TRAILER_SIZE 20
+
+cbin_err_t cbin_container_writer_init(cbin_container_writer_t *container,
+                                      cbin_writer_t *writer) {
+    container->_writer = writer;
+    container->_base = cbin_writer_position(writer);
+    container->_offsets = NULL;
+    container->_count = 0;
+    container->_capacity = 0;
+    container->_frame_start = 0;
+    container->_open = false;
+    return cbin_write_u32_le(writer, CBIN_CONTAINER_MAGIC);
+}
+
+void cbin_container_writer_destroy(cbin_container_writer_t *container) {
+    if (container->_offsets)
+        CBIN_FREE(container->_offsets);
+    container->_offsets = NULL;
+    container->_count = 0;
+    container->_capacity = 0;
+}
+
+// Records the offset of a frame starting at the current position.
+static cbin_err_t cbin_container_push(cbin_container_writer_t *container) {
+    cbin_writer_t *writer = container->_writer;
+    if (container->_count == container->_capacity) {
+        size_t capacity = container->_capacity ? container->_capacity * 2 : 64;
+        void *offsets =
+            CBIN_REALLOC(container->_offsets, capacity * sizeof(uint64_t));
+        if (!offsets)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+        container->_offsets = (uint64_t *)offsets;
+        container->_capacity = capacity;
+    }
+    container->_offsets[container->_count++] =
+        cbin_writer_position(writer) - container->_base;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_container_write_frame(cbin_container_writer_t *container,
+                                      const void *data, size_t size) {
+    cbin_writer_t *writer = container->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (container->_open)
+        return CBIN_ERR_FAILED;
+    if ((uint64_t)size > UINT32_MAX)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+    if (cbin_container_push(container) ||
+        cbin_write_u32_le(writer, (uint32_t)size))
+        return writer->_error;
+    return cbin_write(writer, data, size);
+}
+
+cbin_err_t cbin_container_begin_frame(cbin_container_writer_t *container) {
+    cbin_writer_t *writer = container->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (container->_open)
+        return CBIN_ERR_FAILED;
+    container->_frame_start = cbin_writer_position(writer);
+    // Keep the placeholder buffered until it is patched.
+    if (cbin_writer_ensure(writer, FRAME_HEADER_SIZE) ||
+        cbin_container_push(container) || cbin_write_u32_le(writer, 0))
+        return writer->_error;
+    container->_open = true;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_container_end_frame(cbin_container_writer_t *container) {
+    cbin_writer_t *writer = container->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (!container->_open)
+        return CBIN_ERR_FAILED;
+    container->_open = false;
+    size_t end = cbin_writer_position(writer);
+    size_t size = end - container->_frame_start - FRAME_HEADER_SIZE;
+    if ((uint64_t)size > UINT32_MAX)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
+    if (cbin_writer_seek(writer, container->_frame_start) ||
+        cbin_write_u32_le(writer, (uint32_t)size))
+        return writer->_error;
+    return cbin_writer_seek(writer, end);
+}
+
+cbin_err_t cbin_container_finish(cbin_container_writer_t *container) {
+    cbin_writer_t *writer = container->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (container->_open)
+        return CBIN_ERR_FAILED;
+    uint64_t index = cbin_writer_position(writer) - container->_base;
+    cbin_write_u64_le_array(writer, container->_offsets, container->_count);
+    cbin_write_u64_le(writer, container->_count);
+    cbin_write_u64_le(writer, index);
+    return cbin_write_u32_le(writer, CBIN_CONTAINER_MAGIC);
+}
+
+cbin_err_t cbin_container_open(cbin_container_t *container, const void *data,
+                               size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    container->_data = bytes;
+    container->_index = 0;
+    container->_count = 0;
+    if (size < HEADER_SIZE + TRAILER_SIZE ||
+        cbin_load_u32_le(bytes) != CBIN_CONTAINER_MAGIC ||
+        cbin_load_u32_le(bytes + size - 4) != CBIN_CONTAINER_MAGIC)
+        return CBIN_ERR_CORRUPT;
+    const uint8_t *trailer = bytes + size - TRAILER_SIZE;
+    uint64_t count = cbin_load_u64_le(trailer);
+    uint64_t index = cbin_load_u64_le(trailer + 8);
+    size_t end = size - TRAILER_SIZE;
+    if (index < HEADER_SIZE || index > end || (end - index) % 8 != 0 ||
+        (end - index) / 8 != count)
+        return CBIN_ERR_CORRUPT;
+    container->_index = (size_t)index;
+    container->_count = (size_t)count;
+    return CBIN_ERR_OK;
+}
+
+size_t cbin_container_frame_count(const cbin_container_t *container) {
+    return container->_count;
+}
+
+cbin_err_t cbin_container_frame(const cbin_container_t *container,
+                                size_t index, cbin_reader_t *reader) {
+    cbin_reader_init(reader, NULL, 0);
+    if (index >= container->_count)
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
+    const uint8_t *data = container->_data;
+    uint64_t offset = cbin_load_u64_le(data + container->_index + index * 8);
+    if (offset < HEADER_SIZE ||
+        offset > container->_index - FRAME_HEADER_SIZE)
+        return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+    uint32_t size = cbin_load_u32_le(data + offset);
+    if (size > container->_index - FRAME_HEADER_SIZE - offset)
+        return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+    cbin_reader_init(reader, data + offset + FRAME_HEADER_SIZE, size);
+    return CBIN_ERR_OK;
+}
+
+// The location of an encoded frame in the writer of the worker that
+// encoded it.
+typedef struct cbin_frame_span_s {
+    size_t worker;
+    size_t start;
+    size_t size;
+} cbin_frame_span_t;
+
+// State shared by the workers of a parallel job. Frames are claimed one at
+// a time from a shared counter, the first error stops the other workers.
+typedef struct cbin_job_s {
+    volatile size_t next;
+    volatile int error;
+    size_t count;
+    void *user_data;
+    const cbin_container_t *container;
+    cbin_frame_decode_fn decode;
+    cbin_frame_encode_fn encode;
+    cbin_frame_span_t *spans;
+} cbin_job_t;
+
+// Workers sit next to each other in one array, the padding keeps the hot
+// writer state of each one off the cache lines of its neighbours.
+typedef struct cbin_worker_s {
+    cbin_job_t *job;
+    size_t id;
+    cbin_writer_t writer;
+    uint8_t _pad[CBIN_CACHE_LINE];
+} cbin_worker_t;
+
+static bool cbin_job_claim(cbin_job_t *job, size_t *index) {
+    if (cbin_atomic_load(&job->error))
+        return false;
+    *index = cbin_atomic_fetch_add(&job->next, 1);
+    return *index < job->count;
+}
+
+static void cbin_job_fail(cbin_job_t *job, cbin_err_t err) {
+    cbin_atomic_cas(&job->error, CBIN_ERR_OK, err);
+}
+
+// Runs a worker on each of the given threads, the calling thread being the
+// first one. Workers that cannot be started leave their share of the
+// frames to the others.
+static cbin_err_t cbin_job_run(cbin_job_t *job, cbin_worker_t *workers,
+                               size_t threads, cbin_thread_fn run) {
+    cbin_thread_t *handles = NULL;
+    size_t started = 0;
+    if (threads > 1) {
+        handles = (cbin_thread_t *)CBIN_REALLOC(
+            NULL, (threads - 1) * sizeof(cbin_thread_t));
+    }
+    if (handles) {
+        for (; started < threads - 1; started++) {
+            if (!cbin_thread_create(&handles[started], run,
+                                    &workers[started + 1]))
+                break;
+        }
+    }
+    run(&workers[0]);
+    for (size_t i = 0; i < started; i++)
+        cbin_thread_join(handles[i]);
+    if (handles)
+        CBIN_FREE(handles);
+    return job->error;
+}
+
+static size_t cbin_job_threads(size_t threads, size_t count) {
+    if (threads == 0)
+        threads = cbin_thread_count();
+    if (threads > count)
+        threads = count;
+    return threads ? threads : 1;
+}
+
+static void cbin_decode_worker(void *arg) {
+    cbin_worker_t *worker = (cbin_worker_t *)arg;
+    cbin_job_t *job = worker->job;
+    size_t index;
+    while (cbin_job_claim(job, &index)) {
+        cbin_reader_t reader;
+        cbin_err_t err = cbin_container_frame(job->container, index, &reader);
+        if (!err)
+            err = job->decode(job->user_data, index, &reader);
+        if (err)
+            cbin_job_fail(job, err);
+    }
+}
+
+cbin_err_t cbin_container_decode_parallel(const cbin_container_t *container,
+                                          size_t threads,
+                                          cbin_frame_decode_fn decode,
+                                          void *user_data) {
+    cbin_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.count = container->_count;
+    job.user_data = user_data;
+    job.container = container;
+    job.decode = decode;
+    threads = cbin_job_threads(threads, job.count);
+    cbin_worker_t *workers =
+        (cbin_worker_t *)CBIN_REALLOC(NULL, threads * sizeof(cbin_worker_t));
+    if (!workers)
+        return CBIN_ERR_OUT_OF_MEMORY;
+    for (size_t i = 0; i < threads; i++) {
+        workers[i].job = &job;
+        workers[i].id = i;
+    }
+    cbin_err_t err = cbin_job_run(&job, workers, threads, cbin_decode_worker);
+    CBIN_FREE(workers);
+    return err;
+}
+
+static void cbin_encode_worker(void *arg) {
+    cbin_worker_t *worker = (cbin_worker_t *)arg;
+    cbin_job_t *job = worker->job;
+    cbin_writer_t *writer = &worker->writer;
+    size_t index;
+    while (cbin_job_claim(job, &index)) {
+        size_t start = cbin_writer_written(writer);
+        cbin_writer_seek(writer, start);
+        cbin_err_t err = job->encode(job->user_data, index, writer);
+        if (!err)
+            err = cbin_writer_error(writer);
+        if (err) {
+            cbin_job_fail(job, err);
+            return;
+        }
+        job->spans[index].worker = worker->id;
+        job->spans[index].start = start;
+        job->spans[index].size = cbin_writer_written(writer) - start;
+    }
+}
+
+cbin_err_t cbin_container_encode_parallel(cbin_writer_t *writer, size_t count,
+                                          size_t threads,
+                                          cbin_frame_encode_fn encode,
+                                          void *user_data) {
+    if (writer->_error)
+        return writer->_error;
+    cbin_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.count = count;
+    job.user_data = user_data;
+    job.encode = encode;
+    threads = cbin_job_threads(threads, count);
+    cbin_worker_t *workers =
+        (cbin_worker_t *)CBIN_REALLOC(NULL, threads * sizeof(cbin_worker_t));
+    job.spans = (cbin_frame_span_t *)CBIN_REALLOC(
+        NULL, (count ? count : 1) * sizeof(cbin_frame_span_t));
+    if (!workers || !job.spans) {
+        if (workers)
+            CBIN_FREE(workers);
+        if (job.spans)
+            CBIN_FREE(job.spans);
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers[i].job = &job;
+        workers[i].id = i;
+        cbin_writer_init_dynamic(&workers[i].writer, 0);
+    }
+
+    cbin_err_t err = cbin_job_run(&job, workers, threads, cbin_encode_worker);
+    if (err) {
+        CBIN_ERROR(writer, err);
+    } else {
+        // Merge the frames in order.
+        cbin_container_writer_t container;
+        cbin_container_writer_init(&container, writer);
+        for (size_t i = 0; i < count; i++) {
+            const cbin_frame_span_t *span = &job.spans[i];
+            const uint8_t *buffer = (const uint8_t *)cbin_writer_buffer(
+                &workers[span->worker].writer);
+            if (cbin_container_write_frame(&container, buffer + span->start,
+                                           span->size))
+                break;
+        }
+        err = cbin_container_finish(&container);
+        cbin_container_writer_destroy(&container);
+    }
+
+    for (size_t i = 0; i < threads; i++)
+        cbin_writer_destroy(&workers[i].writer);
+    CBIN_FREE(workers);
+    CBIN_FREE(job.spans);
+    return err;
+}
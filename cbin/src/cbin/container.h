@@ -0,0 +1,158 @@
+#ifndef CBIN_SRC_CBIN_CONTAINER_H
+#define CBIN_SRC_CBIN_CONTAINER_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+// A container is a sequence of independent frames followed by an index of
+// their offsets, so that frames can be located without scanning and
+// decoded in parallel:
+//
+//   u32_le magic
+//   frames:  u32_le length, payload
+//   index:   u64_le offset of each frame
+//   trailer: u64_le frame count, u64_le index offset, u32_le magic
+
+/// The magic number at both ends of a container.
+#define CBIN_CONTAINER_MAGIC 0x31464243u // "CBF1"
+
+/// Writes frames and the index of a container over a writer.
+typedef struct cbin_container_writer_s {
+    cbin_writer_t *_writer;
+    size_t _base;
+    uint64_t *_offsets;
+    size_t _count;
+    size_t _capacity;
+    size_t _frame_start;
+    bool _open;
+} cbin_container_writer_t;
+
+/// A container read from a buffer. It only references the buffer, which
+/// must outlive it.
+typedef struct cbin_container_s {
+    const uint8_t *_data;
+    size_t _index;
+    size_t _count;
+} cbin_container_t;
+
+/// Decodes a frame.
+/// \param user_data The user data given to cbin_container_decode_parallel.
+/// \param index The index of the frame.
+/// \param reader A reader over the payload of the frame.
+/// \return \code CBIN_ERR_OK \endcode or an error to stop decoding.
+typedef cbin_err_t (*cbin_frame_decode_fn)(void *user_data, size_t index,
+                                           cbin_reader_t *reader);
+
+/// Encodes a frame.
+/// \param user_data The user data given to cbin_container_encode_parallel.
+/// \param index The index of the frame.
+/// \param writer The writer to encode the payload of the frame into.
+/// \return \code CBIN_ERR_OK \endcode or an error to stop encoding.
+typedef cbin_err_t (*cbin_frame_encode_fn)(void *user_data, size_t index,
+                                           cbin_writer_t *writer);
+
+CBIN_HEADER_BEGIN
+
+/// Starts a container at the current position of a writer.
+/// \param container The container writer to initialize.
+/// \param writer The writer to write to.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_container_writer_init(cbin_container_writer_t *container,
+                                      cbin_writer_t *writer);
+
+/// Destroys a container writer, the writer itself is left alone.
+/// \param container The container writer to destroy.
+void cbin_container_writer_destroy(cbin_container_writer_t *container);
+
+/// Writes a whole frame.
+/// \param container The container writer to write to.
+/// \param data The payload of the frame.
+/// \param size The size of the payload.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if the payload is 4 GiB or more.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_container_write_frame(cbin_container_writer_t *container,
+                                      const void *data, size_t size);
+
+/// Starts a frame whose payload is then written directly to the writer. The
+/// length is patched in by cbin_container_end_frame, so with a flushing
+/// writer the whole frame must fit in its buffer.
+/// \param container The container writer to write to.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if a frame is already open.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_container_begin_frame(cbin_container_writer_t *container);
+
+/// Ends the frame started by cbin_container_begin_frame.
+/// \param container The container writer to write to.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no frame is open.
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_container_end_frame(cbin_container_writer_t *container);
+
+/// Writes the index and the trailer, completing the container.
+/// \param container The container writer to finish.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if a frame is still open.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_container_finish(cbin_container_writer_t *container);
+
+/// Opens a container held in a buffer, e.g. the buffer of a memory mapped
+/// reader.
+/// \param container The container to open.
+/// \param data The bytes of the container.
+/// \param size The size of the container.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_container_open(cbin_container_t *container, const void *data,
+                               size_t size);
+
+/// Returns the number of frames of a container.
+/// \param container The container to get the frame count of.
+/// \return The number of frames.
+size_t cbin_container_frame_count(const cbin_container_t *container);
+
+/// Initializes a reader over the payload of a frame.
+/// \param container The container to read from.
+/// \param index The index of the frame.
+/// \param reader The reader to initialize.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if there is no such frame.
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_container_frame(const cbin_container_t *container,
+                                size_t index, cbin_reader_t *reader);
+
+/// Decodes every frame of a container on a pool of threads. Frames are
+/// handed out one at a time, so uneven frames still balance across the
+/// threads. The callback runs concurrently and in no particular order, the
+/// calling thread takes part in the work.
+/// \param container The container to decode.
+/// \param threads The number of threads to use, 0 for one per CPU.
+/// \param decode The callback decoding a frame.
+/// \param user_data The user data passed to the callback.
+/// \return \code CBIN_ERR_OK \endcode, the first error of a callback or
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_container_decode_parallel(const cbin_container_t *container,
+                                          size_t threads,
+                                          cbin_frame_decode_fn decode,
+                                          void *user_data);
+
+/// Encodes a number of frames on a pool of threads into a whole container.
+/// Each thread encodes into a writer of its own, which are merged in frame
+/// order into the output once all frames are done.
+/// \param writer The writer to write the container to.
+/// \param count The number of frames to encode.
+/// \param threads The number of threads to use, 0 for one per CPU.
+/// \param encode The callback encoding a frame.
+/// \param user_data The user data passed to the callback.
+/// \return \code CBIN_ERR_OK \endcode, the first error of a callback or
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_container_encode_parallel(cbin_writer_t *writer, size_t count,
+                                          size_t threads,
+                                          cbin_frame_encode_fn encode,
+                                          void *user_data);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_CONTAINER_H
@@ -0,0 +1,52 @@
+#include "cpu.h"
+#include "thread.h"
+
+#if defined(CBIN_HAVE_DISPATCH) && defined(_MSC_VER)
+#    include <immintrin.h>
+#    include <intrin.h>
+#endif
+
+#define CPU_DETECTED (1u << 30)
+
+static unsigned cbin_cpu_detect(void) {
+    unsigned features = 0;
+#if defined(CBIN_HAVE_DISPATCH) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    if (info[2] & (1 << 9))
+        features |= CBIN_CPU_SSSE3;
+    if (info[2] & (1 << 20))
+        features |= CBIN_CPU_SSE42;
+    // AVX2 also needs the OS to save the upper YMM state.
+    if (max_leaf >= 7 && (info[2] & (1 << 27)) &&
+        (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            features |= CBIN_CPU_AVX2;
+    }
+#elif defined(CBIN_HAVE_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3"))
+        features |= CBIN_CPU_SSSE3;
+    if (__builtin_cpu_supports("sse4.2"))
+        features |= CBIN_CPU_SSE42;
+    if (__builtin_cpu_supports("avx2"))
+        features |= CBIN_CPU_AVX2;
+#endif
+    return features;
+}
+
+unsigned cbin_cpu_features(void) {
+    // Detection is idempotent, so a racing first call only repeats the work.
+    // The features are cached with a marker bit so that a single atomic
+    // tells whether they were detected.
+    static volatile int cached = 0;
+    int features = cbin_atomic_load(&cached);
+    if (CBIN_LIKELY(features))
+        return (unsigned)features & ~CPU_DETECTED;
+    features = (int)(cbin_cpu_detect() | CPU_DETECTED);
+    cbin_atomic_cas(&cached, 0, features);
+    return (unsigned)features & ~CPU_DETECTED;
+}
@@ -0,0 +1,45 @@
+#ifndef CBIN_SRC_CBIN_CPU_H
+#define CBIN_SRC_CBIN_CPU_H
+#include "common.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#    define CBIN_ARCH_X86
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) ||                               \
+    (defined(__ARM_NEON) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#    define CBIN_ARCH_NEON
+#endif
+
+#if defined(CBIN_ARCH_X86) &&                                                  \
+    (defined(__SSE2__) || defined(_M_X64) ||                                   \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#    define CBIN_HAVE_SSE2
+#endif
+
+// Kernels for extensions above the compile-time baseline are built with a
+// per-function target attribute and selected at runtime.
+#if defined(CBIN_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#    define CBIN_TARGET(x) __attribute__((target(x)))
+#    define CBIN_HAVE_DISPATCH
+#elif defined(CBIN_ARCH_X86) && defined(_MSC_VER)
+#    define CBIN_TARGET(x)
+#    define CBIN_HAVE_DISPATCH
+#else
+#    define CBIN_TARGET(x)
+#endif
+
+#define CBIN_CPU_SSSE3 (1u << 0)
+#define CBIN_CPU_SSE42 (1u << 1)
+#define CBIN_CPU_AVX2 (1u << 2)
+
+CBIN_HEADER_BEGIN
+
+/// Returns the set of CBIN_CPU_* features supported by the running CPU.
+/// \return A bitmask of CBIN_CPU_* flags, always 0 on non-x86 targets.
+unsigned cbin_cpu_features(void);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_CPU_H
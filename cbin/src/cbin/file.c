@@ -0,0 +1,249 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE
+#endif
+#include "file.h"
+#include "reader.h"
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <io.h>
+#    include <windows.h>
+#else
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    if defined(__linux__)
+#        include <sys/syscall.h>
+#    endif
+#endif
+
+#if defined(_WIN32)
+
+static void *cbin_map_file(const char *path, size_t *size, unsigned flags) {
+    DWORD hint = FILE_ATTRIBUTE_NORMAL;
+    if (flags & CBIN_MMAP_SEQUENTIAL)
+        hint |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (flags & CBIN_MMAP_RANDOM)
+        hint |= FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, hint, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER length;
+    void *view = NULL;
+    if (GetFileSizeEx(file, &length) &&
+        (unsigned long long)length.QuadPart <= (size_t)-1) {
+        *size = (size_t)length.QuadPart;
+        if (*size > 0) {
+            HANDLE mapping =
+                CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping) {
+                view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+    return view;
+}
+
+void cbin_file_unmap(const void *buffer, size_t size) {
+    (void)size;
+    UnmapViewOfFile(buffer);
+}
+
+void *cbin_file_map_ring(size_t *size) {
+    (void)size;
+    return NULL;
+}
+
+void cbin_file_unmap_ring(void *ring, size_t size) {
+    (void)ring;
+    (void)size;
+}
+
+#else
+
+static void *cbin_map_file(const char *path, size_t *size, unsigned flags) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    void *view = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size >= 0 &&
+        (unsigned long long)st.st_size <= (size_t)-1) {
+        *size = (size_t)st.st_size;
+        if (*size > 0) {
+            int map_flags = MAP_PRIVATE;
+#    ifdef MAP_POPULATE
+            if (flags & CBIN_MMAP_POPULATE)
+                map_flags |= MAP_POPULATE;
+#    endif
+            view = mmap(NULL, *size, PROT_READ, map_flags, fd, 0);
+            if (view == MAP_FAILED)
+                view = NULL;
+        }
+    }
+    close(fd);
+    return view;
+}
+
+void cbin_file_unmap(const void *buffer, size_t size) {
+    munmap((void *)buffer, size);
+}
+
+void *cbin_file_map_ring(size_t *size) {
+#    if defined(__linux__) && defined(SYS_memfd_create)
+    // Smaller rings are cheap to compact and would waste most of a page.
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0 || *size < (size_t)page)
+        return NULL;
+    size_t length = (*size + (size_t)page - 1) & ~((size_t)page - 1);
+    if (length < *size || length > (size_t)-1 / 2)
+        return NULL;
+    int fd = (int)syscall(SYS_memfd_create, "cbin-ring", 0u);
+    if (fd < 0)
+        return NULL;
+    // Reserve both copies first, then map the same pages over each half.
+    uint8_t *ring = NULL;
+    if (ftruncate(fd, (off_t)length) == 0) {
+        void *area = mmap(NULL, 2 * length, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (area != MAP_FAILED) {
+            ring = (uint8_t *)area;
+            int prot = PROT_READ | PROT_WRITE;
+            if (mmap(ring, length, prot, MAP_SHARED | MAP_FIXED, fd, 0) ==
+                    MAP_FAILED ||
+                mmap(ring + length, length, prot, MAP_SHARED | MAP_FIXED, fd,
+                     0) == MAP_FAILED) {
+                munmap(area, 2 * length);
+                ring = NULL;
+            }
+        }
+    }
+    close(fd);
+    if (ring)
+        *size = length;
+    return ring;
+#    else
+    (void)size;
+    return NULL;
+#    endif
+}
+
+void cbin_file_unmap_ring(void *ring, size_t size) {
+    munmap(ring, 2 * size);
+}
+
+#endif
+
+cbin_err_t cbin_reader_init_mmap(cbin_reader_t *reader, const char *path,
+                                 unsigned flags) {
+    size_t size = (size_t)-1;
+    void *view = cbin_map_file(path, &size, flags);
+    if (!view && size != 0) {
+        cbin_reader_init(reader, NULL, 0);
+        return CBIN_ERROR(reader, CBIN_ERR_IO);
+    }
+    cbin_reader_init(reader, view, size);
+    reader->_mapped = view != NULL;
+#ifdef MAP_POPULATE
+    // Already prefaulted by the mapping itself.
+    flags &= ~CBIN_MMAP_POPULATE;
+#endif
+    // The advice is only a hint, a refusal leaves a working reader.
+    cbin_reader_advise(reader, flags);
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_reader_advise(cbin_reader_t *reader, unsigned flags) {
+    if (!reader->_mapped)
+        return CBIN_ERR_OK;
+#if !defined(_WIN32)
+    void *base = (void *)reader->_buffer;
+    if (flags & CBIN_MMAP_SEQUENTIAL) {
+        if (posix_madvise(base, reader->_size, POSIX_MADV_SEQUENTIAL))
+            return CBIN_ERR_IO;
+    } else if (flags & CBIN_MMAP_RANDOM) {
+        if (posix_madvise(base, reader->_size, POSIX_MADV_RANDOM))
+            return CBIN_ERR_IO;
+    }
+    if (flags & CBIN_MMAP_POPULATE) {
+        if (posix_madvise(base, reader->_size, POSIX_MADV_WILLNEED))
+            return CBIN_ERR_IO;
+    }
+#    ifdef MADV_HUGEPAGE
+    // Only honoured by filesystems with large folio support; a refusal is
+    // not an error since the mapping works the same either way.
+    if (flags & CBIN_MMAP_HUGE_PAGES)
+        madvise(base, reader->_size, MADV_HUGEPAGE);
+#    endif
+#else
+    (void)flags;
+#endif
+    return CBIN_ERR_OK;
+}
+
+#if defined(_WIN32)
+cbin_err_t cbin_fd_refill(void *user_data, void *buffer, size_t size,
+                          size_t *bytes_read) {
+    int fd = (int)(intptr_t)user_data;
+    unsigned chunk = size > 0x40000000u ? 0x40000000u : (unsigned)size;
+    int n = _read(fd, buffer, chunk);
+    if (n < 0)
+        return CBIN_ERR_IO;
+    *bytes_read = (size_t)n;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_fd_sink(void *user_data, const void *data, size_t size) {
+    int fd = (int)(intptr_t)user_data;
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (size > 0) {
+        unsigned chunk = size > 0x40000000u ? 0x40000000u : (unsigned)size;
+        int n = _write(fd, bytes, chunk);
+        if (n < 0)
+            return CBIN_ERR_IO;
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return CBIN_ERR_OK;
+}
+#else
+cbin_err_t cbin_fd_refill(void *user_data, void *buffer, size_t size,
+                          size_t *bytes_read) {
+    int fd = (int)(intptr_t)user_data;
+    ssize_t n;
+    do {
+        n = (ssize_t)read(fd, buffer, size);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return CBIN_ERR_IO;
+    *bytes_read = (size_t)n;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_fd_sink(void *user_data, const void *data, size_t size) {
+    int fd = (int)(intptr_t)user_data;
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (size > 0) {
+        ssize_t n = (ssize_t)write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return CBIN_ERR_IO;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return CBIN_ERR_OK;
+}
+#endif
+
+cbin_err_t cbin_reader_init_fd(cbin_reader_t *reader, int fd,
+                               size_t window_size) {
+    return cbin_reader_init_stream(reader, window_size, cbin_fd_refill,
+                                   (void *)(intptr_t)fd);
+}
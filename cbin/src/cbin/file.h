@@ -0,0 +1,33 @@
+#ifndef CBIN_SRC_CBIN_FILE_H
+#define CBIN_SRC_CBIN_FILE_H
+#include "common.h"
+
+CBIN_HEADER_BEGIN
+
+/// Releases a mapping created by cbin_reader_init_mmap.
+/// \param buffer The start of the mapping.
+/// \param size The size of the mapping.
+void cbin_file_unmap(const void *buffer, size_t size);
+
+/// Maps a ring buffer twice back to back, so that any span of up to its
+/// size starting inside the first copy is contiguous.
+/// \param size The size of the ring, rounded up to a whole number of pages.
+/// \return The start of the mapping, or NULL where it is not supported or
+/// the size is smaller than a page.
+void *cbin_file_map_ring(size_t *size);
+
+/// Releases a mapping created by cbin_file_map_ring.
+/// \param ring The start of the mapping.
+/// \param size The size of the ring.
+void cbin_file_unmap_ring(void *ring, size_t size);
+
+/// Refill callback reading from the file descriptor stored in user_data.
+cbin_err_t cbin_fd_refill(void *user_data, void *buffer, size_t size,
+                          size_t *read);
+
+/// Sink callback writing to the file descriptor stored in user_data.
+cbin_err_t cbin_fd_sink(void *user_data, const void *data, size_t size);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_FILE_H
@@ -0,0 +1,375 @@
+#include "index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRAILER_SIZE 24
+#define INDEX_ALIGNMENT 64
+// Keys written per call when the columns are written out.
+#define COLUMN_CHUNK 256
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define CTZ64(x) ((size_t)__builtin_ctzll(x))
+#    define PREFETCH(p) __builtin_prefetch(p)
+#else
+static size_t CTZ64(unsigned long long x) {
+    size_t n = 0;
+    while (!(x & 1))
+        x >>= 1, n++;
+    return n;
+}
+#    define PREFETCH(p) ((void)(p))
+#endif
+
+typedef struct cbin_index_entry_s {
+    uint64_t key;
+    uint64_t offset;
+} cbin_index_entry_t;
+
+// The seed of the bucket hash, out of the range of the slot seeds so that
+// both hashes are independent.
+#define BUCKET_SEED ((uint64_t)1 << 32)
+
+static inline uint64_t cbin_index_hash(uint64_t key, uint64_t seed) {
+    // The splitmix64 finalizer, a bijection: distinct keys never share a
+    // hash for the same seed.
+    uint64_t h = key ^ (seed * 0x9E3779B97F4A7C15ull);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+static inline size_t cbin_index_bucket_count(size_t count) {
+    return count / 2 + 1;
+}
+
+void cbin_index_writer_init(cbin_index_writer_t *index,
+                            cbin_writer_t *writer) {
+    index->_writer = writer;
+    index->_entries = NULL;
+    index->_count = 0;
+    index->_capacity = 0;
+}
+
+void cbin_index_writer_destroy(cbin_index_writer_t *index) {
+    if (index->_entries)
+        CBIN_FREE(index->_entries);
+    index->_entries = NULL;
+    index->_count = 0;
+    index->_capacity = 0;
+}
+
+cbin_err_t cbin_index_add(cbin_index_writer_t *index, uint64_t key) {
+    cbin_writer_t *writer = index->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (index->_count == index->_capacity) {
+        size_t capacity = index->_capacity ? index->_capacity * 2 : 64;
+        void *entries = CBIN_REALLOC(index->_entries,
+                                     capacity * sizeof(cbin_index_entry_t));
+        if (!entries)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+        index->_entries = (cbin_index_entry_t *)entries;
+        index->_capacity = capacity;
+    }
+    cbin_index_entry_t *entry = &index->_entries[index->_count++];
+    entry->key = key;
+    entry->offset = cbin_writer_position(writer);
+    return CBIN_ERR_OK;
+}
+
+static int cbin_index_compare(const void *a, const void *b) {
+    uint64_t x = ((const cbin_index_entry_t *)a)->key;
+    uint64_t y = ((const cbin_index_entry_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+// Stores sorted entries in the breadth-first order of a binary search tree,
+// node k in slot k, by walking the tree in order.
+static void cbin_index_eytzinger(const cbin_index_entry_t *sorted,
+                                 cbin_index_entry_t *tree, size_t count) {
+    size_t k = 1;
+    while (2 * k <= count)
+        k *= 2;
+    for (size_t i = 0; i < count; i++) {
+        tree[k] = sorted[i];
+        if (2 * k + 1 <= count) {
+            // The leftmost node of the right subtree.
+            k = 2 * k + 1;
+            while (2 * k <= count)
+                k *= 2;
+        } else {
+            // Up to the first ancestor reached from its left subtree.
+            k >>= CTZ64(~(unsigned long long)k) + 1;
+        }
+    }
+    memset(&tree[0], 0, sizeof(tree[0]));
+}
+
+// Scratch memory of the perfect hash construction, in a single block.
+typedef struct cbin_index_build_s {
+    cbin_index_entry_t *grouped;
+    size_t *starts;
+    size_t *order;
+    uint64_t *taken;
+} cbin_index_build_t;
+
+// Finds the seed that sends every key of a bucket to a distinct free slot,
+// and stores the bucket there.
+static cbin_err_t cbin_index_place(cbin_index_build_t *build,
+                                   const cbin_index_entry_t *bucket,
+                                   size_t size, size_t count,
+                                   cbin_index_entry_t *table, size_t *slots,
+                                   uint32_t *seed) {
+    for (uint64_t candidate = 0; candidate <= UINT32_MAX; candidate++) {
+        size_t placed = 0;
+        while (placed < size) {
+            size_t slot =
+                cbin_index_hash(bucket[placed].key, candidate) % count;
+            if (build->taken[slot / 64] >> (slot % 64) & 1)
+                break;
+            size_t j = 0;
+            while (j < placed && slots[j] != slot)
+                j++;
+            if (j < placed)
+                break;
+            slots[placed++] = slot;
+        }
+        if (placed == size) {
+            for (size_t j = 0; j < size; j++) {
+                build->taken[slots[j] / 64] |= (uint64_t)1 << (slots[j] % 64);
+                table[slots[j]] = bucket[j];
+            }
+            *seed = (uint32_t)candidate;
+            return CBIN_ERR_OK;
+        }
+    }
+    return CBIN_ERR_FAILED;
+}
+
+// Builds a minimal perfect hash by hash and displace: the buckets are
+// placed from the largest to the smallest, each one trying seeds until all
+// of its keys land in free slots.
+static cbin_err_t cbin_index_perfect_hash(const cbin_index_entry_t *entries,
+                                          size_t count,
+                                          cbin_index_entry_t *table,
+                                          uint32_t *seeds, size_t buckets) {
+    size_t words = count / 64 + 1;
+    cbin_index_build_t build;
+    build.grouped = (cbin_index_entry_t *)CBIN_REALLOC(
+        NULL, count * sizeof(cbin_index_entry_t) + words * sizeof(uint64_t) +
+                  (2 * buckets + 1) * sizeof(size_t));
+    if (!build.grouped)
+        return CBIN_ERR_OUT_OF_MEMORY;
+    build.taken = (uint64_t *)(build.grouped + count);
+    build.starts = (size_t *)(build.taken + words);
+    build.order = build.starts + buckets + 1;
+    memset(build.taken, 0, words * sizeof(uint64_t));
+
+    // Group the entries by bucket.
+    size_t *starts = build.starts;
+    memset(starts, 0, (buckets + 1) * sizeof(size_t));
+    for (size_t i = 0; i < count; i++)
+        starts[cbin_index_hash(entries[i].key, BUCKET_SEED) % buckets + 1]++;
+    size_t largest = 0;
+    for (size_t b = 0; b < buckets; b++) {
+        if (starts[b + 1] > largest)
+            largest = starts[b + 1];
+        starts[b + 1] += starts[b];
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t b = cbin_index_hash(entries[i].key, BUCKET_SEED) % buckets;
+        build.grouped[starts[b]++] = entries[i];
+    }
+    for (size_t b = buckets; b > 0; b--)
+        starts[b] = starts[b - 1];
+    starts[0] = 0;
+
+    // Order the buckets by decreasing size with a counting sort, the sizes
+    // array then holds the slots of the bucket being placed.
+    size_t *sizes =
+        (size_t *)CBIN_REALLOC(NULL, (largest + 2) * sizeof(size_t));
+    if (!sizes) {
+        CBIN_FREE(build.grouped);
+        return CBIN_ERR_OUT_OF_MEMORY;
+    }
+    memset(sizes, 0, (largest + 2) * sizeof(size_t));
+    for (size_t b = 0; b < buckets; b++)
+        sizes[largest - (starts[b + 1] - starts[b]) + 1]++;
+    for (size_t s = 0; s <= largest; s++)
+        sizes[s + 1] += sizes[s];
+    for (size_t b = 0; b < buckets; b++)
+        build.order[sizes[largest - (starts[b + 1] - starts[b])]++] = b;
+
+    cbin_err_t err = CBIN_ERR_OK;
+    for (size_t i = 0; i < buckets && !err; i++) {
+        size_t b = build.order[i];
+        size_t size = starts[b + 1] - starts[b];
+        seeds[b] = 0;
+        if (size > 0)
+            err = cbin_index_place(&build, build.grouped + starts[b], size,
+                                   count, table, sizes, &seeds[b]);
+    }
+    CBIN_FREE(sizes);
+    CBIN_FREE(build.grouped);
+    return err;
+}
+
+static cbin_err_t cbin_index_write_column(cbin_writer_t *writer,
+                                          const cbin_index_entry_t *table,
+                                          size_t slots, bool offsets) {
+    uint64_t chunk[COLUMN_CHUNK];
+    for (size_t i = 0; i < slots; i += COLUMN_CHUNK) {
+        size_t n = slots - i < COLUMN_CHUNK ? slots - i : COLUMN_CHUNK;
+        for (size_t j = 0; j < n; j++)
+            chunk[j] = offsets ? table[i + j].offset : table[i + j].key;
+        if (cbin_write_u64_le_array(writer, chunk, n))
+            return writer->_error;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_index_finish(cbin_index_writer_t *index, unsigned layout) {
+    cbin_writer_t *writer = index->_writer;
+    if (writer->_error)
+        return writer->_error;
+    if (layout > CBIN_INDEX_HASH)
+        return CBIN_ERR_FAILED;
+    size_t count = index->_count;
+    cbin_index_entry_t *entries = index->_entries;
+    if (count > 0)
+        qsort(entries, count, sizeof(*entries), cbin_index_compare);
+    for (size_t i = 1; i < count; i++) {
+        if (entries[i].key == entries[i - 1].key)
+            return CBIN_ERR_FAILED;
+    }
+
+    size_t slots = count + (layout == CBIN_INDEX_EYTZINGER);
+    size_t buckets = layout == CBIN_INDEX_HASH ? cbin_index_bucket_count(count)
+                                               : 0;
+    cbin_index_entry_t *table = entries;
+    uint32_t *seeds = NULL;
+    cbin_err_t err = CBIN_ERR_OK;
+    if (layout != CBIN_INDEX_SORTED) {
+        table = (cbin_index_entry_t *)CBIN_REALLOC(NULL,
+                                                   slots * sizeof(*table));
+        if (!table)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    if (layout == CBIN_INDEX_EYTZINGER) {
+        cbin_index_eytzinger(entries, table, count);
+    } else if (layout == CBIN_INDEX_HASH) {
+        seeds = (uint32_t *)CBIN_REALLOC(NULL, buckets * sizeof(uint32_t));
+        err = seeds ? cbin_index_perfect_hash(entries, count, table, seeds,
+                                              buckets)
+                    : CBIN_ERR_OUT_OF_MEMORY;
+        if (err == CBIN_ERR_OUT_OF_MEMORY)
+            err = CBIN_ERROR(writer, err);
+    }
+
+    if (!err) {
+        static const uint8_t zeros[INDEX_ALIGNMENT] = {0};
+        size_t position = cbin_writer_position(writer);
+        size_t padding = (INDEX_ALIGNMENT - position % INDEX_ALIGNMENT) %
+                         INDEX_ALIGNMENT;
+        uint64_t offset = position + padding;
+        if (!cbin_write(writer, zeros, padding) &&
+            !cbin_index_write_column(writer, table, slots, false) &&
+            !cbin_index_write_column(writer, table, slots, true) &&
+            (!seeds || !cbin_write_u32_le_array(writer, seeds, buckets)) &&
+            !cbin_write_u64_le(writer, count) &&
+            !cbin_write_u64_le(writer, offset) &&
+            !cbin_write_u32_le(writer, layout))
+            cbin_write_u32_le(writer, CBIN_INDEX_MAGIC);
+        err = writer->_error;
+    }
+    if (table != entries)
+        CBIN_FREE(table);
+    if (seeds)
+        CBIN_FREE(seeds);
+    return err;
+}
+
+cbin_err_t cbin_index_open(cbin_index_t *index, const void *data,
+                           size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    memset(index, 0, sizeof(*index));
+    if (size < TRAILER_SIZE ||
+        cbin_load_u32_le(bytes + size - 4) != CBIN_INDEX_MAGIC)
+        return CBIN_ERR_CORRUPT;
+    const uint8_t *trailer = bytes + size - TRAILER_SIZE;
+    uint64_t count = cbin_load_u64_le(trailer);
+    uint64_t offset = cbin_load_u64_le(trailer + 8);
+    uint32_t layout = cbin_load_u32_le(trailer + 16);
+    size_t end = size - TRAILER_SIZE;
+    if (layout > CBIN_INDEX_HASH || count > end / 16 || offset > end)
+        return CBIN_ERR_CORRUPT;
+    size_t slots = (size_t)count + (layout == CBIN_INDEX_EYTZINGER);
+    size_t buckets =
+        layout == CBIN_INDEX_HASH ? cbin_index_bucket_count((size_t)count) : 0;
+    if (end - offset != slots * 16 + buckets * 4)
+        return CBIN_ERR_CORRUPT;
+    index->_keys = bytes + offset;
+    index->_offsets = index->_keys + slots * 8;
+    index->_seeds = index->_offsets + slots * 8;
+    index->_slots = slots;
+    index->_count = (size_t)count;
+    index->_buckets = buckets;
+    index->_end = (size_t)offset;
+    index->_layout = layout;
+    return CBIN_ERR_OK;
+}
+
+size_t cbin_index_count(const cbin_index_t *index) { return index->_count; }
+
+static inline uint64_t cbin_index_key(const cbin_index_t *index,
+                                      size_t slot) {
+    return cbin_load_u64_le(index->_keys + slot * 8);
+}
+
+cbin_err_t cbin_index_find(const cbin_index_t *index, uint64_t key,
+                           size_t *offset) {
+    size_t count = index->_count;
+    if (count == 0)
+        return CBIN_ERR_FAILED;
+    size_t slot;
+    if (index->_layout == CBIN_INDEX_SORTED) {
+        // Branchless binary search for the last key not above the key.
+        slot = 0;
+        for (size_t n = count; n > 1; n -= n / 2) {
+            if (cbin_index_key(index, slot + n / 2) <= key)
+                slot += n / 2;
+        }
+    } else if (index->_layout == CBIN_INDEX_EYTZINGER) {
+        size_t k = 1;
+        while (k <= count) {
+            PREFETCH(index->_keys + k * 64);
+            k = 2 * k + (cbin_index_key(index, k) < key);
+        }
+        // Back to the last node where the search went left, the first key
+        // not below the key.
+        k >>= CTZ64(~(unsigned long long)k) + 1;
+        if (k == 0)
+            return CBIN_ERR_FAILED;
+        slot = k;
+    } else {
+        size_t bucket = cbin_index_hash(key, BUCKET_SEED) % index->_buckets;
+        uint32_t seed = cbin_load_u32_le(index->_seeds + bucket * 4);
+        slot = cbin_index_hash(key, seed) % count;
+    }
+    if (cbin_index_key(index, slot) != key)
+        return CBIN_ERR_FAILED;
+    uint64_t position = cbin_load_u64_le(index->_offsets + slot * 8);
+    if (position > index->_end)
+        return CBIN_ERR_CORRUPT;
+    *offset = (size_t)position;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_index_seek(const cbin_index_t *index, cbin_reader_t *reader,
+                           uint64_t key) {
+    size_t offset;
+    cbin_err_t err = cbin_index_find(index, key, &offset);
+    if (err)
+        return err;
+    return cbin_reader_seek(reader, offset);
+}
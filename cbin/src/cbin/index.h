@@ -0,0 +1,128 @@
+#ifndef CBIN_SRC_CBIN_INDEX_H
+#define CBIN_SRC_CBIN_INDEX_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+// An index maps 64-bit keys to the positions of records written before it,
+// so that a record of a large file can be found without scanning it. It is
+// written as a footer after the records:
+//
+//   padding: 0 bytes up to a multiple of 64 bytes
+//   keys:    u64_le key of each slot
+//   offsets: u64_le position of the record of each slot
+//   seeds:   u32_le seed of each bucket, for CBIN_INDEX_HASH only
+//   trailer: u64_le key count, u64_le index offset, u32_le layout,
+//            u32_le magic
+//
+// The slots are laid out in one of three ways:
+//
+// - CBIN_INDEX_SORTED: the keys in ascending order, found by binary search.
+// - CBIN_INDEX_EYTZINGER: the sorted keys in the breadth-first order of a
+//   binary search tree, root in slot 1 and slot 0 unused. The top levels
+//   share a few cache lines, and the eight descendants three levels down
+//   fill one, which is prefetched while the search goes on.
+// - CBIN_INDEX_HASH: a minimal perfect hash. Keys are spread over buckets
+//   of two keys on average, and each bucket stores the seed that sends its
+//   keys to free slots. A lookup reads one seed and one slot.
+//
+// Larger keys, such as strings, can be hashed to 64 bits with cbin_xxh64
+// and compared with the record once found.
+
+/// The magic number of the trailer of an index.
+#define CBIN_INDEX_MAGIC 0x31584243u // "CBX1"
+
+#define CBIN_INDEX_SORTED 0u
+#define CBIN_INDEX_EYTZINGER 1u
+#define CBIN_INDEX_HASH 2u
+
+/// Collects the keys of the records written to a writer, then writes their
+/// index after them.
+typedef struct cbin_index_writer_s {
+    cbin_writer_t *_writer;
+    struct cbin_index_entry_s *_entries;
+    size_t _count;
+    size_t _capacity;
+} cbin_index_writer_t;
+
+/// An index read from a buffer. It only references the buffer, which must
+/// outlive it.
+typedef struct cbin_index_s {
+    const uint8_t *_keys;
+    const uint8_t *_offsets;
+    const uint8_t *_seeds;
+    size_t _slots;
+    size_t _count;
+    size_t _buckets;
+    size_t _end;
+    unsigned _layout;
+} cbin_index_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes an empty index over a writer. Positions are taken from the
+/// writer, so the index has to be opened over everything it wrote.
+/// \param index The index writer to initialize.
+/// \param writer The writer the records are written to.
+void cbin_index_writer_init(cbin_index_writer_t *index,
+                            cbin_writer_t *writer);
+
+/// Destroys an index writer, the writer itself is left alone.
+/// \param index The index writer to destroy.
+void cbin_index_writer_destroy(cbin_index_writer_t *index);
+
+/// Adds the record starting at the current position of the writer.
+/// \param index The index writer to add to.
+/// \param key The key of the record.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_index_add(cbin_index_writer_t *index, uint64_t key);
+
+/// Writes the index of the records added so far.
+/// \param index The index writer to finish.
+/// \param layout CBIN_INDEX_SORTED, CBIN_INDEX_EYTZINGER or CBIN_INDEX_HASH.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if a key was added twice.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_index_finish(cbin_index_writer_t *index, unsigned layout);
+
+/// Opens the index at the end of a buffer, e.g. the buffer of a memory
+/// mapped reader. Only the trailer is read.
+/// \param index The index to open.
+/// \param data The bytes of the file.
+/// \param size The size of the file.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_index_open(cbin_index_t *index, const void *data,
+                           size_t size);
+
+/// Returns the number of keys of an index.
+/// \param index The index to get the key count of.
+/// \return The number of keys.
+size_t cbin_index_count(const cbin_index_t *index);
+
+/// Finds the position of the record of a key.
+/// \param index The index to search.
+/// \param key The key to find.
+/// \param offset Receives the position of the record.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the key is not in the index.
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_index_find(const cbin_index_t *index, uint64_t key,
+                           size_t *offset);
+
+/// Seeks a reader over the indexed file to the record of a key.
+/// \param index The index to search.
+/// \param reader The reader to position.
+/// \param key The key to find.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the key is not in the index, the reader
+/// is left alone.
+/// \code CBIN_ERR_CORRUPT \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_index_seek(const cbin_index_t *index, cbin_reader_t *reader,
+                           uint64_t key);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_INDEX_H
@@ -0,0 +1,514 @@
+#include "packed.h"
+#include "bytes.h"
+#include "cpu.h"
+#include <string.h>
+
+#if defined(CBIN_HAVE_SSE2)
+#    include <emmintrin.h>
+#endif
+#if defined(CBIN_ARCH_NEON) && !defined(__ARM_BIG_ENDIAN)
+#    include <arm_neon.h>
+#    define PACKED_NEON
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define CLZ(x) ((unsigned)__builtin_clz(x))
+#else
+static unsigned CLZ(uint32_t x) {
+    unsigned n = 0;
+    while (!(x & 0x80000000u))
+        x <<= 1, n++;
+    return n;
+}
+#endif
+
+#define PACKED_HEADER 5
+
+// Fully unrolls the unpack loops, whose shifts then become immediates.
+#if defined(__GNUC__) || defined(__clang__)
+#    define PACKED_UNROLL _Pragma("GCC unroll 32")
+#else
+#    define PACKED_UNROLL
+#endif
+
+static size_t packed_block_size(unsigned width) { return 16 * (size_t)width; }
+
+static size_t packed_tail_size(size_t count, unsigned width) {
+    return (count * width + 7) / 8;
+}
+
+// Finds the reference and width of a block, and stores the values relative
+// to the reference.
+static unsigned packed_prepare(uint32_t *block, size_t count,
+                               uint32_t *reference) {
+    uint32_t min = block[0];
+    for (size_t i = 1; i < count; i++)
+        min = block[i] < min ? block[i] : min;
+    uint32_t bits = 0;
+    for (size_t i = 0; i < count; i++) {
+        block[i] -= min;
+        bits |= block[i];
+    }
+    *reference = min;
+    return bits ? 32 - CLZ(bits) : 0;
+}
+
+static void packed_pack_block(uint8_t *out, const uint32_t *block,
+                              unsigned width) {
+    if (width == 0)
+        return;
+    for (unsigned lane = 0; lane < 4; lane++) {
+        uint64_t bits = 0;
+        unsigned count = 0;
+        size_t word = 0;
+        for (unsigned k = 0; k < CBIN_PACKED_BLOCK / 4; k++) {
+            bits |= (uint64_t)block[4 * k + lane] << count;
+            count += width;
+            if (count >= 32) {
+                cbin_store_u32_le(out + 4 * (4 * word + lane),
+                                  (uint32_t)bits);
+                word++;
+                bits >>= 32;
+                count -= 32;
+            }
+        }
+    }
+}
+
+static void packed_pack_tail(uint8_t *out, const uint32_t *block,
+                             size_t count, unsigned width) {
+    uint64_t bits = 0;
+    unsigned pending = 0;
+    for (size_t i = 0; i < count; i++) {
+        bits |= (uint64_t)block[i] << pending;
+        pending += width;
+        while (pending >= 8) {
+            *out++ = (uint8_t)bits;
+            bits >>= 8;
+            pending -= 8;
+        }
+    }
+    if (pending)
+        *out = (uint8_t)bits;
+}
+
+// Packs a block of n values, which are overwritten.
+static cbin_err_t packed_write_block(cbin_writer_t *writer, uint32_t *block,
+                                     size_t n) {
+    uint32_t reference;
+    unsigned width = packed_prepare(block, n, &reference);
+    size_t size = n == CBIN_PACKED_BLOCK ? packed_block_size(width)
+                                         : packed_tail_size(n, width);
+    void *out;
+    if (cbin_writer_reserve(writer, PACKED_HEADER + size, &out))
+        return writer->_error;
+    uint8_t *bytes = (uint8_t *)out;
+    bytes[0] = (uint8_t)width;
+    cbin_store_u32_le(bytes + 1, reference);
+    if (n == CBIN_PACKED_BLOCK)
+        packed_pack_block(bytes + PACKED_HEADER, block, width);
+    else
+        packed_pack_tail(bytes + PACKED_HEADER, block, n, width);
+    return CBIN_ERR_OK;
+}
+
+static size_t packed_block_count(size_t count, size_t i) {
+    return count - i < CBIN_PACKED_BLOCK ? count - i : CBIN_PACKED_BLOCK;
+}
+
+static cbin_err_t packed_write16(cbin_writer_t *writer,
+                                 const uint16_t *values, size_t count,
+                                 bool delta) {
+    uint32_t block[CBIN_PACKED_BLOCK];
+    uint16_t previous = 0;
+    if (writer->_error)
+        return writer->_error;
+    for (size_t i = 0; i < count; i += CBIN_PACKED_BLOCK) {
+        size_t n = packed_block_count(count, i);
+        for (size_t j = 0; j < n; j++) {
+            block[j] = (uint16_t)(values[i + j] - previous);
+            if (delta)
+                previous = values[i + j];
+        }
+        if (packed_write_block(writer, block, n))
+            return writer->_error;
+    }
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t packed_write32(cbin_writer_t *writer,
+                                 const uint32_t *values, size_t count,
+                                 bool delta) {
+    uint32_t block[CBIN_PACKED_BLOCK];
+    uint32_t previous = 0;
+    if (writer->_error)
+        return writer->_error;
+    for (size_t i = 0; i < count; i += CBIN_PACKED_BLOCK) {
+        size_t n = packed_block_count(count, i);
+        if (delta) {
+            for (size_t j = 0; j < n; j++) {
+                block[j] = values[i + j] - previous;
+                previous = values[i + j];
+            }
+        } else {
+            memcpy(block, values + i, n * sizeof(uint32_t));
+        }
+        if (packed_write_block(writer, block, n))
+            return writer->_error;
+    }
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t packed_write64(cbin_writer_t *writer,
+                                 const uint64_t *values, size_t count,
+                                 bool delta) {
+    uint32_t low[CBIN_PACKED_BLOCK];
+    uint32_t high[CBIN_PACKED_BLOCK];
+    uint64_t previous = 0;
+    if (writer->_error)
+        return writer->_error;
+    for (size_t i = 0; i < count; i += CBIN_PACKED_BLOCK) {
+        size_t n = packed_block_count(count, i);
+        for (size_t j = 0; j < n; j++) {
+            uint64_t value = values[i + j] - previous;
+            if (delta)
+                previous = values[i + j];
+            low[j] = (uint32_t)value;
+            high[j] = (uint32_t)(value >> 32);
+        }
+        if (packed_write_block(writer, low, n) ||
+            packed_write_block(writer, high, n))
+            return writer->_error;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_write_u16_packed_array(cbin_writer_t *writer,
+                                      const uint16_t *values, size_t count) {
+    return packed_write16(writer, values, count, false);
+}
+
+cbin_err_t cbin_write_u16_delta_packed_array(cbin_writer_t *writer,
+                                            const uint16_t *values,
+                                            size_t count) {
+    return packed_write16(writer, values, count, true);
+}
+
+cbin_err_t cbin_write_u32_packed_array(cbin_writer_t *writer,
+                                      const uint32_t *values, size_t count) {
+    return packed_write32(writer, values, count, false);
+}
+
+cbin_err_t cbin_write_u32_delta_packed_array(cbin_writer_t *writer,
+                                            const uint32_t *values,
+                                            size_t count) {
+    return packed_write32(writer, values, count, true);
+}
+
+cbin_err_t cbin_write_u64_packed_array(cbin_writer_t *writer,
+                                      const uint64_t *values, size_t count) {
+    return packed_write64(writer, values, count, false);
+}
+
+cbin_err_t cbin_write_u64_delta_packed_array(cbin_writer_t *writer,
+                                            const uint64_t *values,
+                                            size_t count) {
+    return packed_write64(writer, values, count, true);
+}
+
+static void packed_unpack_scalar(const uint8_t *in, uint32_t *out,
+                                 unsigned width, uint32_t reference) {
+    uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+    for (unsigned lane = 0; lane < 4; lane++) {
+        uint64_t bits = 0;
+        unsigned count = 0;
+        size_t word = 0;
+        for (unsigned k = 0; k < CBIN_PACKED_BLOCK / 4; k++) {
+            if (count < width) {
+                uint32_t next = cbin_load_u32_le(in + 4 * (4 * word + lane));
+                bits |= (uint64_t)next << count;
+                word++;
+                count += 32;
+            }
+            out[4 * k + lane] = ((uint32_t)bits & mask) + reference;
+            bits >>= width;
+            count -= width;
+        }
+    }
+}
+
+static void packed_unpack_tail(const uint8_t *in, uint32_t *out,
+                               size_t count, unsigned width,
+                               uint32_t reference) {
+    uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+    uint64_t bits = 0;
+    unsigned pending = 0;
+    for (size_t i = 0; i < count; i++) {
+        while (pending < width) {
+            bits |= (uint64_t)*in++ << pending;
+            pending += 8;
+        }
+        out[i] = ((uint32_t)bits & mask) + reference;
+        bits >>= width;
+        pending -= width;
+    }
+}
+
+#if defined(CBIN_HAVE_SSE2)
+// The width is a constant in every instance, so that the shifts and the
+// word loads of the unrolled loop are resolved at compile time.
+static inline void packed_unpack_sse2(const uint8_t *in, uint32_t *out,
+                                      const unsigned width,
+                                      uint32_t reference) {
+    const __m128i *src = (const __m128i *)in;
+    __m128i *dst = (__m128i *)out;
+    __m128i mask =
+        _mm_set1_epi32(width == 32 ? -1 : (int)((1u << width) - 1));
+    __m128i base = _mm_set1_epi32((int)reference);
+    __m128i word = _mm_loadu_si128(src++);
+    unsigned shift = 0;
+    PACKED_UNROLL
+    for (unsigned k = 0; k < CBIN_PACKED_BLOCK / 4; k++) {
+        __m128i value = _mm_srl_epi32(word, _mm_cvtsi32_si128((int)shift));
+        if (shift + width > 32) {
+            word = _mm_loadu_si128(src++);
+            value = _mm_or_si128(
+                value,
+                _mm_sll_epi32(word, _mm_cvtsi32_si128((int)(32 - shift))));
+            shift = shift + width - 32;
+        } else {
+            shift += width;
+            if (shift == 32 && k + 1 < CBIN_PACKED_BLOCK / 4) {
+                word = _mm_loadu_si128(src++);
+                shift = 0;
+            }
+        }
+        _mm_storeu_si128(dst + k,
+                         _mm_add_epi32(_mm_and_si128(value, mask), base));
+    }
+}
+
+#    define PACKED_UNPACK packed_unpack_sse2
+#elif defined(PACKED_NEON)
+static inline void packed_unpack_neon(const uint8_t *in, uint32_t *out,
+                                      const unsigned width,
+                                      uint32_t reference) {
+    const uint32_t *src = (const uint32_t *)(const void *)in;
+    uint32x4_t mask = vdupq_n_u32(width == 32 ? ~0u : (1u << width) - 1);
+    uint32x4_t base = vdupq_n_u32(reference);
+    uint32x4_t word = vld1q_u32(src);
+    src += 4;
+    unsigned shift = 0;
+    PACKED_UNROLL
+    for (unsigned k = 0; k < CBIN_PACKED_BLOCK / 4; k++) {
+        uint32x4_t value = vshlq_u32(word, vdupq_n_s32(-(int)shift));
+        if (shift + width > 32) {
+            word = vld1q_u32(src);
+            src += 4;
+            value = vorrq_u32(
+                value, vshlq_u32(word, vdupq_n_s32((int)(32 - shift))));
+            shift = shift + width - 32;
+        } else {
+            shift += width;
+            if (shift == 32 && k + 1 < CBIN_PACKED_BLOCK / 4) {
+                word = vld1q_u32(src);
+                src += 4;
+                shift = 0;
+            }
+        }
+        vst1q_u32(out + 4 * k, vaddq_u32(vandq_u32(value, mask), base));
+    }
+}
+
+#    define PACKED_UNPACK packed_unpack_neon
+#endif
+
+#if defined(PACKED_UNPACK)
+#    define PACKED_CASE(w)                                                     \
+    case w:                                                                    \
+        PACKED_UNPACK(in, out, w, reference);                                  \
+        return;
+#endif
+
+static void packed_unpack_block(const uint8_t *in, uint32_t *out,
+                                unsigned width, uint32_t reference) {
+#if defined(PACKED_UNPACK)
+    switch (width) {
+        PACKED_CASE(1) PACKED_CASE(2) PACKED_CASE(3) PACKED_CASE(4)
+        PACKED_CASE(5) PACKED_CASE(6) PACKED_CASE(7) PACKED_CASE(8)
+        PACKED_CASE(9) PACKED_CASE(10) PACKED_CASE(11) PACKED_CASE(12)
+        PACKED_CASE(13) PACKED_CASE(14) PACKED_CASE(15) PACKED_CASE(16)
+        PACKED_CASE(17) PACKED_CASE(18) PACKED_CASE(19) PACKED_CASE(20)
+        PACKED_CASE(21) PACKED_CASE(22) PACKED_CASE(23) PACKED_CASE(24)
+        PACKED_CASE(25) PACKED_CASE(26) PACKED_CASE(27) PACKED_CASE(28)
+        PACKED_CASE(29) PACKED_CASE(30) PACKED_CASE(31) PACKED_CASE(32)
+    default:
+        break;
+    }
+#endif
+    if (width == 0) {
+        for (size_t i = 0; i < CBIN_PACKED_BLOCK; i++)
+            out[i] = reference;
+        return;
+    }
+    packed_unpack_scalar(in, out, width, reference);
+}
+
+// Turns the differences of a block back into values, four at a time with
+// an in-register prefix sum, and returns the last value.
+static uint32_t packed_prefix_sum(uint32_t *values, size_t count,
+                                  uint32_t previous) {
+    size_t i = 0;
+#if defined(CBIN_HAVE_SSE2)
+    __m128i carry = _mm_set1_epi32((int)previous);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, carry);
+        _mm_storeu_si128((__m128i *)(values + i), v);
+        carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    previous = (uint32_t)_mm_cvtsi128_si32(carry);
+#elif defined(PACKED_NEON)
+    uint32x4_t carry = vdupq_n_u32(previous);
+    uint32x4_t zero = vdupq_n_u32(0);
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t v = vld1q_u32(values + i);
+        v = vaddq_u32(v, vextq_u32(zero, v, 3));
+        v = vaddq_u32(v, vextq_u32(zero, v, 2));
+        v = vaddq_u32(v, carry);
+        vst1q_u32(values + i, v);
+        carry = vdupq_n_u32(vgetq_lane_u32(v, 3));
+    }
+    previous = vgetq_lane_u32(carry, 0);
+#endif
+    for (; i < count; i++) {
+        previous += values[i];
+        values[i] = previous;
+    }
+    return previous;
+}
+
+// Unpacks a block of n values, or skips it if out is NULL.
+static cbin_err_t packed_read_block(cbin_reader_t *reader, uint32_t *out,
+                                    size_t n) {
+    if (cbin_reader_ensure(reader, PACKED_HEADER))
+        return reader->_error;
+    const uint8_t *header =
+        (const uint8_t *)reader->_buffer + reader->_position;
+    unsigned width = header[0];
+    uint32_t reference = cbin_load_u32_le(header + 1);
+    if (width > 32)
+        return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+    size_t size = n == CBIN_PACKED_BLOCK ? packed_block_size(width)
+                                         : packed_tail_size(n, width);
+    if (cbin_reader_ensure(reader, PACKED_HEADER + size))
+        return reader->_error;
+    // Ensuring may have moved the window of a streaming reader.
+    const uint8_t *data =
+        (const uint8_t *)reader->_buffer + reader->_position + PACKED_HEADER;
+    if (out) {
+        if (n == CBIN_PACKED_BLOCK)
+            packed_unpack_block(data, out, width, reference);
+        else
+            packed_unpack_tail(data, out, n, width, reference);
+    }
+    reader->_position += PACKED_HEADER + size;
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t packed_read16(cbin_reader_t *reader, uint16_t *values,
+                                size_t count, bool delta) {
+    uint32_t block[CBIN_PACKED_BLOCK];
+    uint32_t previous = 0;
+    if (reader->_error)
+        return reader->_error;
+    for (size_t i = 0; i < count; i += CBIN_PACKED_BLOCK) {
+        size_t n = packed_block_count(count, i);
+        if (packed_read_block(reader, values ? block : NULL, n))
+            return reader->_error;
+        if (!values)
+            continue;
+        uint32_t bits = 0;
+        for (size_t j = 0; j < n; j++)
+            bits |= block[j];
+        if (bits > 0xFFFFu)
+            return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+        // The sums wrap around at 32 bits, their low 16 bits still do at 16.
+        if (delta)
+            previous = packed_prefix_sum(block, n, previous);
+        for (size_t j = 0; j < n; j++)
+            values[i + j] = (uint16_t)block[j];
+    }
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t packed_read32(cbin_reader_t *reader, uint32_t *values,
+                                size_t count, bool delta) {
+    uint32_t previous = 0;
+    if (reader->_error)
+        return reader->_error;
+    for (size_t i = 0; i < count; i += CBIN_PACKED_BLOCK) {
+        size_t n = packed_block_count(count, i);
+        if (packed_read_block(reader, values ? values + i : NULL, n))
+            return reader->_error;
+        if (values && delta)
+            previous = packed_prefix_sum(values + i, n, previous);
+    }
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t packed_read64(cbin_reader_t *reader, uint64_t *values,
+                                size_t count, bool delta) {
+    uint32_t low[CBIN_PACKED_BLOCK];
+    uint32_t high[CBIN_PACKED_BLOCK];
+    uint64_t previous = 0;
+    if (reader->_error)
+        return reader->_error;
+    for (size_t i = 0; i < count; i += CBIN_PACKED_BLOCK) {
+        size_t n = packed_block_count(count, i);
+        if (packed_read_block(reader, values ? low : NULL, n) ||
+            packed_read_block(reader, values ? high : NULL, n))
+            return reader->_error;
+        if (!values)
+            continue;
+        for (size_t j = 0; j < n; j++) {
+            uint64_t value = (uint64_t)high[j] << 32 | low[j];
+            if (delta)
+                value = previous += value;
+            values[i + j] = value;
+        }
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_read_u16_packed_array(cbin_reader_t *reader,
+                                     uint16_t *values, size_t count) {
+    return packed_read16(reader, values, count, false);
+}
+
+cbin_err_t cbin_read_u16_delta_packed_array(cbin_reader_t *reader,
+                                           uint16_t *values, size_t count) {
+    return packed_read16(reader, values, count, true);
+}
+
+cbin_err_t cbin_read_u32_packed_array(cbin_reader_t *reader,
+                                     uint32_t *values, size_t count) {
+    return packed_read32(reader, values, count, false);
+}
+
+cbin_err_t cbin_read_u32_delta_packed_array(cbin_reader_t *reader,
+                                           uint32_t *values, size_t count) {
+    return packed_read32(reader, values, count, true);
+}
+
+cbin_err_t cbin_read_u64_packed_array(cbin_reader_t *reader,
+                                     uint64_t *values, size_t count) {
+    return packed_read64(reader, values, count, false);
+}
+
+cbin_err_t cbin_read_u64_delta_packed_array(cbin_reader_t *reader,
+                                           uint64_t *values, size_t count) {
+    return packed_read64(reader, values, count, true);
+}
@@ -0,0 +1,81 @@
+#ifndef CBIN_SRC_CBIN_PACKED_H
+#define CBIN_SRC_CBIN_PACKED_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+// Bit-packed integer arrays in the SIMD-BP128 layout. Values are cut in
+// blocks of 128, each written as
+//
+//   u8 width, u32_le reference, 16 * width bytes
+//
+// where every value is stored as its difference to the reference, the
+// smallest value of the block, on width bits. The bits are interleaved over
+// four 32-bit lanes: value i goes to lane i % 4, and word j of lane l is the
+// 32-bit word 4 * j + l of the block, so that one 128-bit load holds a word
+// of every lane. The last block of fewer than 128 values packs them one
+// after the other instead, least significant bit first, on
+// (count * width + 7) / 8 bytes.
+//
+// 16-bit values are packed the same way, on at most 16 bits. 64-bit values
+// are split, each block being written as two blocks of this layout: the
+// low 32 bits of its values, then the high 32 bits, which are often all the
+// same and then take no more than the header.
+//
+// The delta variant packs the differences between consecutive values
+// instead, the first one relative to 0, which suits sorted IDs and offsets.
+// Differences wrap around at the width of the values, so any array
+// round-trips.
+
+/// The number of values of a block.
+#define CBIN_PACKED_BLOCK 128
+
+CBIN_HEADER_BEGIN
+
+/// Writes an array of values, bit-packed by blocks. The count is not
+/// stored, it has to be known to the reader.
+/// \param writer The writer to write to.
+/// \param values The values to write.
+/// \param count The number of values to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_u16_packed_array(cbin_writer_t *writer,
+                                      const uint16_t *values, size_t count);
+cbin_err_t cbin_write_u16_delta_packed_array(cbin_writer_t *writer,
+                                            const uint16_t *values,
+                                            size_t count);
+cbin_err_t cbin_write_u32_packed_array(cbin_writer_t *writer,
+                                      const uint32_t *values, size_t count);
+cbin_err_t cbin_write_u32_delta_packed_array(cbin_writer_t *writer,
+                                            const uint32_t *values,
+                                            size_t count);
+cbin_err_t cbin_write_u64_packed_array(cbin_writer_t *writer,
+                                      const uint64_t *values, size_t count);
+cbin_err_t cbin_write_u64_delta_packed_array(cbin_writer_t *writer,
+                                            const uint64_t *values,
+                                            size_t count);
+
+/// Reads an array written by the matching packed array writer, unpacking
+/// four values per instruction with SSE2 or NEON.
+/// \param reader The reader to read from.
+/// \param values The array to read into, may be NULL to skip the values.
+/// \param count The number of values to read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_read_u16_packed_array(cbin_reader_t *reader,
+                                     uint16_t *values, size_t count);
+cbin_err_t cbin_read_u16_delta_packed_array(cbin_reader_t *reader,
+                                           uint16_t *values, size_t count);
+cbin_err_t cbin_read_u32_packed_array(cbin_reader_t *reader,
+                                     uint32_t *values, size_t count);
+cbin_err_t cbin_read_u32_delta_packed_array(cbin_reader_t *reader,
+                                           uint32_t *values, size_t count);
+cbin_err_t cbin_read_u64_packed_array(cbin_reader_t *reader,
+                                     uint64_t *values, size_t count);
+cbin_err_t cbin_read_u64_delta_packed_array(cbin_reader_t *reader,
+                                           uint64_t *values, size_t count);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_PACKED_H
@@ -0,0 +1,232 @@
+#include "pool.h"
+
+#if CBIN_POOL_CACHE_SIZE < 2
+#    error "CBIN_POOL_CACHE_SIZE must be at least 2."
+#endif
+
+// Idle buffers are linked through their own first bytes.
+typedef struct cbin_pool_node_s {
+    struct cbin_pool_node_s *next;
+    size_t capacity;
+} cbin_pool_node_t;
+
+// Buffers cached by a thread. Caches are registered in the pool so that
+// cbin_pool_destroy can free the ones of threads that are still alive.
+typedef struct cbin_pool_cache_s {
+    cbin_pool_t *pool;
+    struct cbin_pool_cache_s *prev;
+    struct cbin_pool_cache_s *next;
+    cbin_pool_node_t *free;
+    size_t count;
+} cbin_pool_cache_t;
+
+static void cbin_pool_free_nodes(cbin_pool_t *pool, cbin_pool_node_t *node) {
+    while (node) {
+        cbin_pool_node_t *next = node->next;
+        cbin_allocator_free(pool->_allocator, node, node->capacity);
+        node = next;
+    }
+}
+
+// Moves a whole cache to the shared list, with the pool locked.
+static void cbin_pool_cache_drain(cbin_pool_t *pool,
+                                  cbin_pool_cache_t *cache) {
+    cbin_pool_node_t *tail = cache->free;
+    if (!tail)
+        return;
+    while (tail->next)
+        tail = tail->next;
+    tail->next = pool->_free;
+    pool->_free = cache->free;
+    pool->_free_count += cache->count;
+    cache->free = NULL;
+    cache->count = 0;
+}
+
+static void cbin_pool_cache_unlink(cbin_pool_t *pool,
+                                   cbin_pool_cache_t *cache) {
+    if (cache->prev)
+        cache->prev->next = cache->next;
+    else
+        pool->_caches = cache->next;
+    if (cache->next)
+        cache->next->prev = cache->prev;
+}
+
+// Runs when a thread that used the pool exits.
+static void CBIN_TLS_CALL cbin_pool_cache_release(void *value) {
+    cbin_pool_cache_t *cache = (cbin_pool_cache_t *)value;
+    if (!cache)
+        return;
+    cbin_pool_t *pool = cache->pool;
+    cbin_mutex_lock(&pool->_lock);
+    cbin_pool_cache_drain(pool, cache);
+    cbin_pool_cache_unlink(pool, cache);
+    cbin_mutex_unlock(&pool->_lock);
+    CBIN_FREE(cache);
+}
+
+// Returns the cache of the calling thread, creating it on first use. NULL
+// if it could not be created, the shared list is used directly then.
+static cbin_pool_cache_t *cbin_pool_cache(cbin_pool_t *pool) {
+    cbin_pool_cache_t *cache =
+        (cbin_pool_cache_t *)cbin_tls_get(pool->_cache_key);
+    if (CBIN_LIKELY(cache != NULL))
+        return cache;
+    cache = (cbin_pool_cache_t *)CBIN_REALLOC(NULL, sizeof(*cache));
+    if (!cache)
+        return NULL;
+    cache->pool = pool;
+    cache->prev = NULL;
+    cache->free = NULL;
+    cache->count = 0;
+    cbin_mutex_lock(&pool->_lock);
+    cache->next = pool->_caches;
+    if (pool->_caches)
+        pool->_caches->prev = cache;
+    pool->_caches = cache;
+    cbin_mutex_unlock(&pool->_lock);
+    if (!cbin_tls_set(pool->_cache_key, cache)) {
+        cbin_mutex_lock(&pool->_lock);
+        cbin_pool_cache_unlink(pool, cache);
+        cbin_mutex_unlock(&pool->_lock);
+        CBIN_FREE(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+cbin_err_t cbin_pool_init(cbin_pool_t *pool, size_t buffer_size,
+                          const cbin_allocator_t *allocator) {
+    // Idle buffers must be able to hold their list node.
+    if (buffer_size < sizeof(cbin_pool_node_t))
+        buffer_size = sizeof(cbin_pool_node_t);
+    pool->_buffer_size = buffer_size;
+    pool->_max_size =
+        buffer_size > (size_t)-1 / 4 ? (size_t)-1 : buffer_size * 4;
+    pool->_allocator = allocator;
+    pool->_free = NULL;
+    pool->_free_count = 0;
+    pool->_caches = NULL;
+    if (!cbin_tls_create(&pool->_cache_key, cbin_pool_cache_release))
+        return CBIN_ERR_FAILED;
+    cbin_mutex_init(&pool->_lock);
+    return CBIN_ERR_OK;
+}
+
+void cbin_pool_destroy(cbin_pool_t *pool) {
+    // Deleting the key does not run the thread exit callbacks everywhere,
+    // the caches still registered are freed here.
+    cbin_tls_delete(pool->_cache_key);
+    cbin_pool_cache_t *cache = pool->_caches;
+    while (cache) {
+        cbin_pool_cache_t *next = cache->next;
+        cbin_pool_free_nodes(pool, cache->free);
+        CBIN_FREE(cache);
+        cache = next;
+    }
+    cbin_pool_free_nodes(pool, pool->_free);
+    pool->_caches = NULL;
+    pool->_free = NULL;
+    pool->_free_count = 0;
+    cbin_mutex_destroy(&pool->_lock);
+}
+
+cbin_err_t cbin_pool_acquire(cbin_pool_t *pool, cbin_writer_t *writer) {
+    cbin_pool_cache_t *cache = cbin_pool_cache(pool);
+    cbin_pool_node_t *node = NULL;
+    if (cache && cache->count > 0) {
+        node = cache->free;
+        cache->free = node->next;
+        cache->count--;
+    } else {
+        cbin_mutex_lock(&pool->_lock);
+        node = pool->_free;
+        if (node) {
+            pool->_free = node->next;
+            pool->_free_count--;
+            // Refill half of the cache in the same critical section, so
+            // the next acquisitions do not need the lock.
+            while (cache && pool->_free &&
+                   cache->count < CBIN_POOL_CACHE_SIZE / 2) {
+                cbin_pool_node_t *refill = pool->_free;
+                pool->_free = refill->next;
+                pool->_free_count--;
+                refill->next = cache->free;
+                cache->free = refill;
+                cache->count++;
+            }
+        }
+        cbin_mutex_unlock(&pool->_lock);
+    }
+
+    if (cbin_writer_init_allocator(writer, 0, pool->_allocator))
+        return writer->_error;
+    if (node) {
+        writer->_buffer = node;
+        writer->_capacity = node->capacity;
+        return CBIN_ERR_OK;
+    }
+    writer->_buffer = cbin_allocator_realloc(pool->_allocator, NULL, 0,
+                                             pool->_buffer_size);
+    if (!writer->_buffer)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    writer->_capacity = pool->_buffer_size;
+    return CBIN_ERR_OK;
+}
+
+void cbin_pool_release(cbin_pool_t *pool, cbin_writer_t *writer) {
+#if defined(CBIN_STATS)
+    cbin_writer_publish_stats(writer);
+#endif
+    cbin_writer_destroy_frames(writer);
+    cbin_pool_node_t *node = (cbin_pool_node_t *)writer->_buffer;
+    size_t capacity = writer->_capacity;
+    writer->_buffer = NULL;
+    writer->_capacity = 0;
+    writer->_position = 0;
+    writer->_written = 0;
+    if (!node)
+        return;
+    if (capacity > pool->_max_size || capacity < sizeof(cbin_pool_node_t)) {
+        cbin_allocator_free(pool->_allocator, node, capacity);
+        return;
+    }
+    node->capacity = capacity;
+
+    cbin_pool_cache_t *cache = cbin_pool_cache(pool);
+    if (!cache) {
+        cbin_mutex_lock(&pool->_lock);
+        node->next = pool->_free;
+        pool->_free = node;
+        pool->_free_count++;
+        cbin_mutex_unlock(&pool->_lock);
+        return;
+    }
+    if (cache->count == CBIN_POOL_CACHE_SIZE) {
+        // Hand the older half of a full cache back to the other threads.
+        cbin_pool_node_t *keep = cache->free;
+        for (size_t i = 1; i < CBIN_POOL_CACHE_SIZE / 2; i++)
+            keep = keep->next;
+        cbin_pool_cache_t spill = {0};
+        spill.free = keep->next;
+        spill.count = cache->count - CBIN_POOL_CACHE_SIZE / 2;
+        keep->next = NULL;
+        cache->count = CBIN_POOL_CACHE_SIZE / 2;
+        cbin_mutex_lock(&pool->_lock);
+        cbin_pool_cache_drain(pool, &spill);
+        cbin_mutex_unlock(&pool->_lock);
+    }
+    node->next = cache->free;
+    cache->free = node;
+    cache->count++;
+}
+
+void cbin_pool_trim(cbin_pool_t *pool) {
+    cbin_mutex_lock(&pool->_lock);
+    cbin_pool_node_t *node = pool->_free;
+    pool->_free = NULL;
+    pool->_free_count = 0;
+    cbin_mutex_unlock(&pool->_lock);
+    cbin_pool_free_nodes(pool, node);
+}
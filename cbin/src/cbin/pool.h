@@ -0,0 +1,71 @@
+#ifndef CBIN_SRC_CBIN_POOL_H
+#define CBIN_SRC_CBIN_POOL_H
+#include "alloc.h"
+#include "thread.h"
+#include "writer.h"
+
+/// Number of buffers each thread keeps for itself before handing them back
+/// to the shared list of the pool.
+#ifndef CBIN_POOL_CACHE_SIZE
+#    define CBIN_POOL_CACHE_SIZE 16
+#endif
+
+/// A thread-safe pool of writer buffers. Buffers released to the pool are
+/// kept for the next writer instead of being freed, so steady-state
+/// encoding does not allocate. Each thread caches a few buffers of its own,
+/// acquiring and releasing only takes the pool lock when that cache is
+/// empty or full.
+typedef struct cbin_pool_s {
+    size_t _buffer_size;
+    size_t _max_size;
+    const cbin_allocator_t *_allocator;
+
+    cbin_mutex_t _lock;
+    cbin_tls_t _cache_key;
+    struct cbin_pool_node_s *_free;
+    size_t _free_count;
+    struct cbin_pool_cache_s *_caches;
+} cbin_pool_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes an empty pool.
+/// \param pool The pool to initialize.
+/// \param buffer_size The initial capacity of the writers handed out. Buffers
+/// that grew past four times this size are freed on release rather than
+/// kept.
+/// \param allocator The allocator of the buffers, must outlive the pool.
+/// NULL selects CBIN_REALLOC and CBIN_FREE.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the thread-local cache could not be
+/// created.
+cbin_err_t cbin_pool_init(cbin_pool_t *pool, size_t buffer_size,
+                          const cbin_allocator_t *allocator);
+
+/// Frees every buffer held by a pool. Writers still acquired from the pool
+/// must be destroyed with cbin_writer_destroy instead of being released, and
+/// no other thread may use the pool anymore.
+/// \param pool The pool to destroy.
+void cbin_pool_destroy(cbin_pool_t *pool);
+
+/// Initializes a resizable writer over a pooled buffer.
+/// \param pool The pool to acquire from.
+/// \param writer The writer to initialize.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_pool_acquire(cbin_pool_t *pool, cbin_writer_t *writer);
+
+/// Hands the buffer of a writer acquired from a pool back to it. The writer
+/// must be initialized again before being used.
+/// \param pool The pool the writer was acquired from.
+/// \param writer The writer to release.
+void cbin_pool_release(cbin_pool_t *pool, cbin_writer_t *writer);
+
+/// Frees the buffers in the shared list of a pool, the per-thread caches
+/// are left alone.
+/// \param pool The pool to trim.
+void cbin_pool_trim(cbin_pool_t *pool);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_POOL_H
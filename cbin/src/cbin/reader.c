@@ -3,6 +3,10 @@
 //
 
 #include "reader.h"
+#include "bswap_array.h"
+#include "checksum.h"
+#include "file.h"
+#include "scan.h"
 #include <endianness/byte_swap.h>
 #include <endianness/detection.h>
 #include <string.h>
@@ -11,10 +15,227 @@ void cbin_reader_init(cbin_reader_t *reader, const void *buffer, size_t size) {
     reader->_position = 0;
     reader->_size = buffer ? size : 0;
     reader->_error = CBIN_ERR_OK;
+    reader->_mapped = false;
+    reader->_window = NULL;
+    reader->_window_capacity = 0;
+    reader->_base = 0;
+    reader->_refill = NULL;
+    reader->_refill_user = NULL;
+    reader->_eof = false;
+    reader->_ring = false;
+    reader->_mirrored = false;
+    reader->_checkpoint = (size_t)-1;
+    reader->_checkpoint_checksum = NULL;
+    reader->_checksum = NULL;
+    reader->_checksum_mark = 0;
+#if defined(CBIN_STATS)
+    memset(&reader->_stats, 0, sizeof(reader->_stats));
+#endif
+}
+cbin_err_t cbin_reader_init_stream(cbin_reader_t *reader, size_t window_size,
+                                   cbin_reader_refill_fn refill,
+                                   void *user_data) {
+    cbin_reader_init(reader, NULL, 0);
+    if (window_size == 0)
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_MEMORY);
+    reader->_window = CBIN_REALLOC(NULL, window_size);
+    if (!reader->_window)
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_MEMORY);
+    reader->_buffer = reader->_window;
+    reader->_window_capacity = window_size;
+    reader->_refill = refill;
+    reader->_refill_user = user_data;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_reader_init_ring(cbin_reader_t *reader, size_t capacity) {
+    cbin_reader_init(reader, NULL, 0);
+    if (capacity == 0)
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_MEMORY);
+    size_t size = capacity;
+    void *ring = cbin_file_map_ring(&size);
+    if (ring) {
+        reader->_mirrored = true;
+        capacity = size;
+    } else if (!(ring = CBIN_REALLOC(NULL, capacity))) {
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    reader->_window = ring;
+    reader->_buffer = ring;
+    reader->_window_capacity = capacity;
+    reader->_ring = true;
+    return CBIN_ERR_OK;
+}
+
+// Returns the offset of the first byte that has to stay buffered, the
+// current position or the open checkpoint if it is before.
+static inline size_t cbin_reader_hold(const cbin_reader_t *reader) {
+    size_t hold = reader->_position;
+    if (reader->_checkpoint != (size_t)-1 &&
+        reader->_checkpoint - reader->_base < hold)
+        hold = reader->_checkpoint - reader->_base;
+    return hold;
+}
+
+// Adds the bytes consumed up to end since the last update to the checksum of
+// the open region. Bytes are hashed in blocks, soon after they are read and
+// while they are still in cache, rather than one value at a time.
+static void cbin_reader_hash(cbin_reader_t *reader, size_t end) {
+    if (end > reader->_checksum_mark) {
+        cbin_checksum_update(reader->_checksum,
+                             (const uint8_t *)reader->_buffer +
+                                 reader->_checksum_mark,
+                             end - reader->_checksum_mark);
+        reader->_checksum_mark = end;
+    }
+}
+// Bytes after an open checkpoint may be read again, so they are only hashed
+// once it is committed.
+static inline void cbin_reader_hash_block(cbin_reader_t *reader) {
+    if (CBIN_UNLIKELY(reader->_checksum != NULL)) {
+        size_t end = cbin_reader_hold(reader);
+        if (end > reader->_checksum_mark &&
+            end - reader->_checksum_mark >= CBIN_CHECKSUM_BLOCK)
+            cbin_reader_hash(reader, end);
+    }
+}
+
+// Drops the bytes that no longer have to stay buffered from the front of the
+// buffer, hashing them first when a checksummed region is open.
+static size_t cbin_reader_release(cbin_reader_t *reader) {
+    size_t drop = cbin_reader_hold(reader);
+    if (drop > 0) {
+        if (reader->_checksum) {
+            cbin_reader_hash(reader, drop);
+            reader->_checksum_mark -= drop;
+        }
+        reader->_buffer = (const uint8_t *)reader->_buffer + drop;
+        reader->_base += drop;
+        reader->_size -= drop;
+        reader->_position -= drop;
+    }
+    return drop;
+}
+
+// Makes at least count bytes available at the current position of a
+// streaming reader. Consumed bytes are dropped from the front of the window,
+// the rest is moved down and the window is topped up from the callback.
+// Running out of input is reported without touching the error state, so
+// callers decide whether it is fatal.
+static cbin_err_t cbin_reader_fill(cbin_reader_t *reader, size_t count) {
+    size_t held = reader->_position - cbin_reader_hold(reader);
+    if (count > reader->_window_capacity - held)
+        return CBIN_ERR_OUT_OF_BOUNDS;
+    uint8_t *window = (uint8_t *)reader->_window;
+    if (cbin_reader_release(reader)) {
+        memmove(window, reader->_buffer, reader->_size);
+        reader->_buffer = window;
+    }
+    while (reader->_size - reader->_position < count) {
+        if (reader->_eof)
+            return CBIN_ERR_OUT_OF_BOUNDS;
+        size_t read = 0;
+        cbin_err_t err = reader->_refill(
+            reader->_refill_user, window + reader->_size,
+            reader->_window_capacity - reader->_size, &read);
+        if (err)
+            return CBIN_ERROR(reader, err);
+        if (read == 0)
+            reader->_eof = true;
+        CBIN_STAT_ADD(reader, refill_count, 1);
+        CBIN_STAT_ADD(reader, bytes_refilled, read);
+        reader->_size += read;
+    }
+    return CBIN_ERR_OK;
+}
+
+void cbin_reader_destroy(cbin_reader_t *reader) {
+#if defined(CBIN_STATS)
+    cbin_reader_publish_stats(reader);
+#endif
+    if (reader->_mapped && reader->_buffer) {
+        cbin_file_unmap(reader->_buffer, reader->_size);
+    }
+    if (reader->_mirrored) {
+        cbin_file_unmap_ring(reader->_window, reader->_window_capacity);
+    } else if (reader->_window) {
+        CBIN_FREE(reader->_window);
+    }
+    cbin_reader_init(reader, NULL, 0);
 }
 void cbin_reader_reset(cbin_reader_t *reader) {
     reader->_position = 0;
     reader->_error = CBIN_ERR_OK;
+    reader->_checkpoint = (size_t)-1;
+    reader->_checksum = NULL;
+}
+// Free space after the buffered bytes of a ring reader. A mirrored ring
+// wraps around, the heap ring ends at the end of its window.
+static size_t cbin_reader_ring_free(const cbin_reader_t *reader) {
+    size_t space = reader->_window_capacity - reader->_size;
+    if (!reader->_mirrored)
+        space -= (size_t)((const uint8_t *)reader->_buffer -
+                         (const uint8_t *)reader->_window);
+    return space;
+}
+void *cbin_reader_ring_space(cbin_reader_t *reader, size_t *size) {
+    if (!reader->_ring) {
+        *size = 0;
+        return NULL;
+    }
+    uint8_t *window = (uint8_t *)reader->_window;
+    size_t capacity = reader->_window_capacity;
+    cbin_reader_release(reader);
+    size_t offset = (size_t)((const uint8_t *)reader->_buffer - window);
+    if (reader->_mirrored) {
+        // Both copies hold the same bytes, stay in the first one.
+        if (offset >= capacity)
+            reader->_buffer = window + offset - capacity;
+    } else if (offset > 0 && offset * 2 > capacity - reader->_size) {
+        memmove(window, reader->_buffer, reader->_size);
+        reader->_buffer = window;
+    }
+    *size = cbin_reader_ring_free(reader);
+    return (uint8_t *)reader->_buffer + reader->_size;
+}
+cbin_err_t cbin_reader_ring_commit(cbin_reader_t *reader, size_t size) {
+    if (!reader->_ring || size > cbin_reader_ring_free(reader))
+        return CBIN_ERR_OUT_OF_BOUNDS;
+    reader->_size += size;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_reader_append(cbin_reader_t *reader, const void *data,
+                              size_t size) {
+    size_t space;
+    void *out = cbin_reader_ring_space(reader, &space);
+    if (size > space)
+        return CBIN_ERR_OUT_OF_MEMORY;
+    if (size > 0)
+        memcpy(out, data, size);
+    reader->_size += size;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_reader_checkpoint(cbin_reader_t *reader) {
+    if (reader->_error)
+        return reader->_error;
+    reader->_checkpoint = reader->_base + reader->_position;
+    reader->_checkpoint_checksum = reader->_checksum;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_reader_rollback(cbin_reader_t *reader) {
+    if (reader->_checkpoint == (size_t)-1)
+        return CBIN_ERR_FAILED;
+    // The checkpoint stays open for the next attempt.
+    reader->_position = reader->_checkpoint - reader->_base;
+    reader->_checksum = reader->_checkpoint_checksum;
+    reader->_error = CBIN_ERR_OK;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_reader_commit(cbin_reader_t *reader) {
+    if (reader->_checkpoint == (size_t)-1)
+        return CBIN_ERR_FAILED;
+    reader->_checkpoint = (size_t)-1;
+    return reader->_error;
 }
 void cbin_reader_discard_error(cbin_reader_t *reader) {
     reader->_error = CBIN_ERR_OK;
@@ -23,16 +244,26 @@ cbin_err_t cbin_reader_skip(cbin_reader_t *reader, size_t count) {
     if (reader->_error)
         return reader->_error;
     if (reader->_position + count > reader->_size) {
-        return reader->_error = CBIN_ERR_OUT_OF_BOUNDS;
+        if (!reader->_refill)
+            return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
+        return cbin_read(reader, NULL, count);
     }
+    CBIN_STAT_ADD(reader, bytes_read, count);
     reader->_position += count;
     return CBIN_ERR_OK;
 }
 cbin_err_t cbin_reader_seek(cbin_reader_t *reader, size_t position) {
     if (reader->_error)
         return reader->_error;
+    CBIN_STAT_ADD(reader, seek_count, 1);
+    if (position < reader->_base) {
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
+    }
+    position -= reader->_base;
     if (position > reader->_size) {
-        return reader->_error = CBIN_ERR_OUT_OF_BOUNDS;
+        if (!reader->_refill)
+            return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
+        return cbin_reader_skip(reader, position - reader->_position);
     }
     reader->_position = position;
     return CBIN_ERR_OK;
@@ -41,28 +272,149 @@ const void *cbin_reader_buffer(const cbin_reader_t *reader) {
     return reader->_buffer;
 }
 size_t cbin_reader_position(const cbin_reader_t *reader) {
-    return reader->_position;
+    return reader->_base + reader->_position;
+}
+size_t cbin_reader_size(const cbin_reader_t *reader) {
+    return reader->_base + reader->_size;
 }
-size_t cbin_reader_size(const cbin_reader_t *reader) { return reader->_size; }
 cbin_err_t cbin_reader_error(const cbin_reader_t *reader) {
     return reader->_error;
 }
 size_t cbin_reader_remaining(const cbin_reader_t *reader) {
     return reader->_size - reader->_position;
 }
+// Reads a value that does not fit in the rest of the window. Values that
+// fit in a full window are read atomically, larger ones are copied through
+// the window piece by piece.
+static cbin_err_t cbin_read_stream(cbin_reader_t *reader, void *buffer,
+                                   size_t size) {
+    cbin_err_t err;
+    if (size <= reader->_window_capacity) {
+        if ((err = cbin_reader_fill(reader, size)))
+            return CBIN_ERROR(reader, err);
+        if (CBIN_LIKELY(buffer != NULL)) {
+            memcpy(buffer, (const uint8_t *)reader->_buffer + reader->_position,
+                   size);
+        }
+        CBIN_STAT_ADD(reader, bytes_read, size);
+        reader->_position += size;
+        return CBIN_ERR_OK;
+    }
+    uint8_t *out = (uint8_t *)buffer;
+    while (size > 0) {
+        if (reader->_position == reader->_size) {
+            if ((err = cbin_reader_fill(reader, 1)))
+                return CBIN_ERROR(reader, err);
+        }
+        size_t chunk = reader->_size - reader->_position;
+        if (chunk > size)
+            chunk = size;
+        if (out) {
+            memcpy(out, (const uint8_t *)reader->_buffer + reader->_position,
+                   chunk);
+            out += chunk;
+        }
+        CBIN_STAT_ADD(reader, bytes_read, chunk);
+        reader->_position += chunk;
+        size -= chunk;
+    }
+    return CBIN_ERR_OK;
+}
+
 cbin_err_t cbin_read(cbin_reader_t *reader, void *buffer, size_t size) {
     if (reader->_error)
         return reader->_error;
+    cbin_reader_hash_block(reader);
     if (reader->_position + size > reader->_size) {
-        return reader->_error = CBIN_ERR_OUT_OF_BOUNDS;
+        if (reader->_refill)
+            return cbin_read_stream(reader, buffer, size);
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
     }
     if (CBIN_LIKELY(buffer != NULL)) {
         memcpy(buffer, (const uint8_t *)reader->_buffer + reader->_position,
                size);
     }
+    CBIN_STAT_ADD(reader, bytes_read, size);
+    reader->_position += size;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_read_view(cbin_reader_t *reader, size_t size,
+                          const void **out) {
+    if (cbin_reader_ensure(reader, size))
+        return reader->_error;
+    if (CBIN_LIKELY(out != NULL))
+        *out = (const uint8_t *)reader->_buffer + reader->_position;
+    CBIN_STAT_ADD(reader, bytes_read, size);
     reader->_position += size;
     return CBIN_ERR_OK;
 }
+cbin_err_t cbin_reader_ensure(cbin_reader_t *reader, size_t count) {
+    if (reader->_error)
+        return reader->_error;
+    cbin_reader_hash_block(reader);
+    if (count > reader->_size - reader->_position) {
+        cbin_err_t err = CBIN_ERR_OUT_OF_BOUNDS;
+        if (reader->_refill)
+            err = cbin_reader_fill(reader, count);
+        if (err)
+            return CBIN_ERROR(reader, err);
+    }
+    return CBIN_ERR_OK;
+}
+bool cbin_reader_get_stats(const cbin_reader_t *reader,
+                           cbin_reader_stats_t *stats) {
+#if defined(CBIN_STATS)
+    *stats = reader->_stats;
+    return true;
+#else
+    (void)reader;
+    memset(stats, 0, sizeof(*stats));
+    return false;
+#endif
+}
+void cbin_reader_publish_stats(cbin_reader_t *reader) {
+#if defined(CBIN_STATS)
+    cbin_stats_publish_reader(&reader->_stats);
+    memset(&reader->_stats, 0, sizeof(reader->_stats));
+#else
+    (void)reader;
+#endif
+}
+cbin_err_t cbin_reader_begin_checksum(cbin_reader_t *reader,
+                                      cbin_checksum_t *checksum) {
+    if (reader->_error)
+        return reader->_error;
+    if (reader->_checksum)
+        return CBIN_ERR_FAILED;
+    reader->_checksum = checksum;
+    reader->_checksum_mark = reader->_position;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_reader_end_checksum(cbin_reader_t *reader) {
+    if (!reader->_checksum)
+        return CBIN_ERR_FAILED;
+    cbin_reader_hash(reader, reader->_position);
+    reader->_checksum = NULL;
+    return reader->_error;
+}
+cbin_err_t cbin_reader_verify_checksum(cbin_reader_t *reader) {
+    cbin_checksum_t *checksum = reader->_checksum;
+    cbin_err_t err = cbin_reader_end_checksum(reader);
+    if (err)
+        return err;
+    uint64_t stored;
+    if (cbin_checksum_size(checksum) == 4) {
+        uint32_t crc;
+        if ((err = cbin_read_u32_le(reader, &crc)))
+            return err;
+        stored = crc;
+    } else if ((err = cbin_read_u64_le(reader, &stored))) {
+        return err;
+    }
+    if (stored != cbin_checksum_digest(checksum))
+        return CBIN_ERROR(reader, CBIN_ERR_CHECKSUM);
+    return CBIN_ERR_OK;
+}
 
 #ifdef __LITTLE_ENDIAN__
 #    define READ_LE(size, swap) return cbin_read(reader, value, (size) / 8)
@@ -110,7 +462,7 @@ cbin_err_t cbin_read_u64_le(cbin_reader_t *reader, uint64_t *value) {
     READ_LE(64, bswap64);
 }
 cbin_err_t cbin_read_u64_be(cbin_reader_t *reader, uint64_t *value) {
-    return READ_BE(64, bswap64);
+    READ_BE(64, bswap64);
 }
 cbin_err_t cbin_read_i8(cbin_reader_t *reader, int8_t *value) {
     return cbin_read(reader, value, sizeof(uint8_t));
@@ -159,13 +511,193 @@ cbin_err_t cbin_read_bool(cbin_reader_t *reader, bool *value) {
     return CBIN_ERR_OK;
 }
 
-cbin_err_t cbin_reader_find(cbin_reader_t *reader, uint8_t byte,
-                            size_t *position) {
-    for (size_t i = reader->_position; i < reader->_size; i++) {
-        if (*((const uint8_t *)(reader->_buffer) + i) == byte) {
-            *position = i;
+static cbin_err_t cbin_read_array(cbin_reader_t *reader, void *values,
+                                  size_t count, size_t size,
+                                  cbin_bswap_array_fn swap) {
+    if (reader->_error)
+        return reader->_error;
+    uint8_t *out = (uint8_t *)values;
+    while (count > (reader->_size - reader->_position) / size) {
+        // Streaming readers convert the buffered part and refill for the
+        // rest, an element straddling the window edge is pulled in whole.
+        cbin_err_t err = CBIN_ERR_OUT_OF_BOUNDS;
+        if (reader->_refill)
+            err = cbin_reader_fill(reader, size);
+        if (err)
+            return CBIN_ERROR(reader, err);
+        size_t chunk = (reader->_size - reader->_position) / size;
+        if (chunk > count)
+            chunk = count;
+        cbin_read_array(reader, out, chunk, size, swap);
+        if (out)
+            out += chunk * size;
+        count -= chunk;
+    }
+    const uint8_t *src = (const uint8_t *)reader->_buffer + reader->_position;
+    if (CBIN_LIKELY(out != NULL)) {
+        if (swap)
+            swap(out, src, count);
+        else
+            memcpy(out, src, count * size);
+    }
+    CBIN_STAT_ADD(reader, bytes_read, count * size);
+    reader->_position += count * size;
+    return CBIN_ERR_OK;
+}
+
+#ifdef __LITTLE_ENDIAN__
+#    define READ_ARRAY_LE(size)                                                \
+        return cbin_read_array(reader, values, count, (size) / 8, NULL)
+#    define READ_ARRAY_BE(size)                                                \
+        return cbin_read_array(reader, values, count, (size) / 8,             \
+                               cbin_bswap##size##_array)
+#elif defined(__BIG_ENDIAN__)
+#    define READ_ARRAY_LE(size)                                                \
+        return cbin_read_array(reader, values, count, (size) / 8,             \
+                               cbin_bswap##size##_array)
+#    define READ_ARRAY_BE(size)                                                \
+        return cbin_read_array(reader, values, count, (size) / 8, NULL)
+#endif
+
+cbin_err_t cbin_read_u16_le_array(cbin_reader_t *reader, uint16_t *values,
+                                  size_t count) {
+    READ_ARRAY_LE(16);
+}
+cbin_err_t cbin_read_u16_be_array(cbin_reader_t *reader, uint16_t *values,
+                                  size_t count) {
+    READ_ARRAY_BE(16);
+}
+
+cbin_err_t cbin_read_u32_le_array(cbin_reader_t *reader, uint32_t *values,
+                                  size_t count) {
+    READ_ARRAY_LE(32);
+}
+cbin_err_t cbin_read_u32_be_array(cbin_reader_t *reader, uint32_t *values,
+                                  size_t count) {
+    READ_ARRAY_BE(32);
+}
+
+cbin_err_t cbin_read_u64_le_array(cbin_reader_t *reader, uint64_t *values,
+                                  size_t count) {
+    READ_ARRAY_LE(64);
+}
+cbin_err_t cbin_read_u64_be_array(cbin_reader_t *reader, uint64_t *values,
+                                  size_t count) {
+    READ_ARRAY_BE(64);
+}
+
+cbin_err_t cbin_read_i16_le_array(cbin_reader_t *reader, int16_t *values,
+                                  size_t count) {
+    READ_ARRAY_LE(16);
+}
+cbin_err_t cbin_read_i16_be_array(cbin_reader_t *reader, int16_t *values,
+                                  size_t count) {
+    READ_ARRAY_BE(16);
+}
+
+cbin_err_t cbin_read_i32_le_array(cbin_reader_t *reader, int32_t *values,
+                                  size_t count) {
+    READ_ARRAY_LE(32);
+}
+cbin_err_t cbin_read_i32_be_array(cbin_reader_t *reader, int32_t *values,
+                                  size_t count) {
+    READ_ARRAY_BE(32);
+}
+
+cbin_err_t cbin_read_i64_le_array(cbin_reader_t *reader, int64_t *values,
+                                  size_t count) {
+    READ_ARRAY_LE(64);
+}
+cbin_err_t cbin_read_i64_be_array(cbin_reader_t *reader, int64_t *values,
+                                  size_t count) {
+    READ_ARRAY_BE(64);
+}
+
+cbin_err_t cbin_read_f32_le_array(cbin_reader_t *reader, float *values,
+                                  size_t count) {
+    READ_ARRAY_LE(32);
+}
+cbin_err_t cbin_read_f32_be_array(cbin_reader_t *reader, float *values,
+                                  size_t count) {
+    READ_ARRAY_BE(32);
+}
+
+cbin_err_t cbin_read_f64_le_array(cbin_reader_t *reader, double *values,
+                                  size_t count) {
+    READ_ARRAY_LE(64);
+}
+cbin_err_t cbin_read_f64_be_array(cbin_reader_t *reader, double *values,
+                                  size_t count) {
+    READ_ARRAY_BE(64);
+}
+
+typedef size_t (*cbin_scan_fn)(const uint8_t *buffer, size_t size,
+                               const uint8_t *needle, size_t needle_size);
+
+static size_t cbin_scan_byte_fn(const uint8_t *buffer, size_t size,
+                                const uint8_t *needle, size_t needle_size) {
+    (void)needle_size;
+    return cbin_scan_byte(buffer, size, *needle);
+}
+
+// Runs a scan kernel from the current position. Streaming readers keep
+// refilling, retaining the last overlap bytes that could still start a
+// match, and skip everything before them once the window is full.
+static cbin_err_t cbin_reader_scan(cbin_reader_t *reader, cbin_scan_fn scan,
+                                   const uint8_t *needle, size_t needle_size,
+                                   size_t overlap, size_t *position) {
+    size_t i = reader->_position;
+    for (;;) {
+        const uint8_t *buffer = (const uint8_t *)reader->_buffer;
+        size_t match =
+            i + scan(buffer + i, reader->_size - i, needle, needle_size);
+        if (match < reader->_size) {
+            *position = reader->_base + match;
             return CBIN_ERR_OK;
         }
+        if (!reader->_refill || reader->_error || reader->_eof)
+            return CBIN_ERR_FAILED;
+        size_t next = reader->_size > i + overlap ? reader->_size - overlap : i;
+        if (reader->_size - reader->_position == reader->_window_capacity) {
+            if (next == reader->_position)
+                return CBIN_ERR_FAILED;
+            reader->_position = next;
+        }
+        size_t scanned = next - reader->_position;
+        if (cbin_reader_fill(reader, reader->_size - reader->_position + 1))
+            return CBIN_ERR_FAILED;
+        i = reader->_position + scanned;
     }
-    return CBIN_ERR_FAILED;
+}
+
+cbin_err_t cbin_reader_find(cbin_reader_t *reader, uint8_t byte,
+                            size_t *position) {
+    return cbin_reader_scan(reader, cbin_scan_byte_fn, &byte, 1, 0, position);
+}
+
+cbin_err_t cbin_reader_find_any(cbin_reader_t *reader, const uint8_t *bytes,
+                                size_t count, size_t *position) {
+    return cbin_reader_scan(reader, cbin_scan_any, bytes, count, 0, position);
+}
+
+cbin_err_t cbin_reader_find_pattern(cbin_reader_t *reader,
+                                    const void *pattern, size_t size,
+                                    size_t *position) {
+    if (size > 0 && reader->_refill && size > reader->_window_capacity)
+        return CBIN_ERR_FAILED;
+    return cbin_reader_scan(reader, cbin_scan_pattern,
+                            (const uint8_t *)pattern, size,
+                            size > 0 ? size - 1 : 0, position);
+}
+
+cbin_err_t cbin_reader_find_reverse(cbin_reader_t *reader, uint8_t byte,
+                                    size_t *position) {
+    size_t size = reader->_size - reader->_position;
+    const uint8_t *buffer =
+        (const uint8_t *)reader->_buffer + reader->_position;
+    size_t match = cbin_scan_byte_reverse(buffer, size, byte);
+    if (match == size)
+        return CBIN_ERR_FAILED;
+    *position = reader->_base + reader->_position + match;
+    return CBIN_ERR_OK;
 }
@@ -5,17 +5,62 @@
 #ifndef CBIN_SRC_CBIN_READER_H
 #define CBIN_SRC_CBIN_READER_H
 
+#include "bytes.h"
 #include "common.h"
+#include "stats.h"
 #include <stdbool.h>
 #include <stdint.h>
 
+/// Refills a streaming reader.
+/// \param user_data The user data given when initializing the reader.
+/// \param buffer The buffer to read into.
+/// \param size The number of bytes available in the buffer.
+/// \param read Receives the number of bytes read, 0 at the end of the input.
+/// \return \code CBIN_ERR_OK \endcode or an error to make the reader fail.
+typedef cbin_err_t (*cbin_reader_refill_fn)(void *user_data, void *buffer,
+                                            size_t size, size_t *read);
+
 typedef struct cbin_reader_s {
     const void *_buffer;
     size_t _position;
     size_t _size;
     cbin_err_t _error;
+    bool _mapped;
+
+    // Streaming state, _window is only set for streaming readers.
+    void *_window;
+    size_t _window_capacity;
+    size_t _base;
+    cbin_reader_refill_fn _refill;
+    void *_refill_user;
+    bool _eof;
+
+    // Ring state, _ring is only set for readers fed through
+    // cbin_reader_append. The ring is _window, mapped twice back to back when
+    // _mirrored so that the buffered bytes are always contiguous.
+    bool _ring;
+    bool _mirrored;
+
+    // The absolute position saved by cbin_reader_checkpoint, or (size_t)-1
+    // when no checkpoint is open, and the checksummed region open then.
+    size_t _checkpoint;
+    struct cbin_checksum_s *_checkpoint_checksum;
+
+    // Checksum state, _checksum is only set inside a checksummed region and
+    // covers the bytes from its start up to _checksum_mark.
+    struct cbin_checksum_s *_checksum;
+    size_t _checksum_mark;
+
+#if defined(CBIN_STATS)
+    cbin_reader_stats_t _stats;
+#endif
 } cbin_reader_t;
 
+#define CBIN_MMAP_SEQUENTIAL (1u << 0)
+#define CBIN_MMAP_RANDOM (1u << 1)
+#define CBIN_MMAP_POPULATE (1u << 2)
+#define CBIN_MMAP_HUGE_PAGES (1u << 3)
+
 CBIN_HEADER_BEGIN
 
 /// Initializes a reader with a buffer and a size.
@@ -24,7 +69,103 @@ CBIN_HEADER_BEGIN
 /// \param size The size of the buffer.
 void cbin_reader_init(cbin_reader_t *reader, const void *buffer, size_t size);
 
-/// Resets a reader to a clean state.
+/// Initializes a reader over a read-only memory mapping of a file.
+/// \param reader The reader to initialize.
+/// \param path The path of the file to map.
+/// \param flags A combination of CBIN_MMAP_* flags, see cbin_reader_advise.
+/// Advice the kernel refuses is ignored.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_IO \endcode if the file cannot be mapped.
+cbin_err_t cbin_reader_init_mmap(cbin_reader_t *reader, const char *path,
+                                 unsigned flags);
+
+/// Initializes a streaming reader that pulls its input through a callback
+/// into a fixed-size window. Reads transparently refill the window, so
+/// memory use is bounded by \p window_size regardless of the input size.
+/// Positions are absolute offsets in the stream, but only the bytes still
+/// in the window can be sought back to, and a single value accessed in
+/// place (e.g. through cbin_reader_ensure) cannot be larger than the window.
+/// \param reader The reader to initialize.
+/// \param window_size The size of the window to allocate.
+/// \param refill The callback that provides the input.
+/// \param user_data The user data passed to the callback.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_reader_init_stream(cbin_reader_t *reader, size_t window_size,
+                                   cbin_reader_refill_fn refill,
+                                   void *user_data);
+
+/// Initializes a streaming reader over a file descriptor, such as a pipe or
+/// a socket. The descriptor is not closed by cbin_reader_destroy.
+/// \param reader The reader to initialize.
+/// \param fd The file descriptor to read from.
+/// \param window_size The size of the window to allocate.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_reader_init_fd(cbin_reader_t *reader, int fd,
+                               size_t window_size);
+
+/// Initializes a reader over a ring buffer that is fed by the caller, for
+/// messages that arrive in pieces such as from a non-blocking socket. Reads
+/// past the bytes appended so far fail with CBIN_ERR_OUT_OF_BOUNDS; combined
+/// with cbin_reader_checkpoint a parser can then roll back, wait for more
+/// input and resume. Consumed bytes are released when more space is
+/// requested. Where the platform allows it, rings of at least a page are
+/// mapped twice back to back, so that the buffered bytes are contiguous
+/// without ever being moved. Otherwise the ring is a heap buffer: the free
+/// space is the tail after the buffered bytes, which are moved down once
+/// more than half the free space is behind them.
+/// \param reader The reader to initialize.
+/// \param capacity The size of the ring, rounded up to a whole number of
+/// pages when mapped. It bounds the bytes buffered at once, so it must hold
+/// the largest message with its checkpoint.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_reader_init_ring(cbin_reader_t *reader, size_t capacity);
+
+/// Returns the free space of a ring reader, where the next bytes can be
+/// received in place, for example with recv. Consumed bytes before the
+/// current position and the open checkpoint are released first.
+/// \param reader The reader to get the space of.
+/// \param size Receives the number of bytes available, 0 if the ring is
+/// full or the reader is not a ring reader.
+/// \return The start of the free space.
+void *cbin_reader_ring_space(cbin_reader_t *reader, size_t *size);
+
+/// Makes bytes received into the free space of a ring reader readable.
+/// \param reader The ring reader.
+/// \param size The number of bytes received.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if the size exceeds the free space.
+cbin_err_t cbin_reader_ring_commit(cbin_reader_t *reader, size_t size);
+
+/// Copies bytes at the end of a ring reader.
+/// \param reader The ring reader.
+/// \param data The bytes to append.
+/// \param size The number of bytes to append.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode if the ring cannot hold them.
+cbin_err_t cbin_reader_append(cbin_reader_t *reader, const void *data,
+                              size_t size);
+
+/// Gives the kernel a hint about how a mapped reader will be accessed.
+/// CBIN_MMAP_SEQUENTIAL and CBIN_MMAP_RANDOM select the read-ahead policy,
+/// CBIN_MMAP_POPULATE prefetches the whole file and CBIN_MMAP_HUGE_PAGES
+/// requests transparent huge pages where the filesystem supports them.
+/// Hints are best effort and a no-op for readers that are not mapped.
+/// \param reader The reader to advise.
+/// \param flags A combination of CBIN_MMAP_* flags.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_IO \endcode
+cbin_err_t cbin_reader_advise(cbin_reader_t *reader, unsigned flags);
+
+/// Destroys a reader, only required if the reader owns its buffer or to
+/// publish its counters.
+/// \param reader The reader to destroy.
+void cbin_reader_destroy(cbin_reader_t *reader);
+
+/// Resets a reader to a clean state, streaming readers can only rewind to
+/// the start of their current window.
 /// \param reader The reader to reset.
 void cbin_reader_reset(cbin_reader_t *reader);
 
@@ -32,6 +173,30 @@ void cbin_reader_reset(cbin_reader_t *reader);
 /// \param reader The reader to discard the error state of.
 void cbin_reader_discard_error(cbin_reader_t *reader);
 
+/// Saves the current position, so that a parse attempt that runs out of
+/// input can be undone with cbin_reader_rollback. Until the checkpoint is
+/// committed or rolled back, streaming and ring readers keep every byte
+/// after it buffered and checksummed regions only hash up to it. A new
+/// checkpoint replaces the open one, so a parser can checkpoint after each
+/// complete element and only redo the last one.
+/// \param reader The reader to checkpoint.
+/// \return \code CBIN_ERR_OK \endcode or the current error state.
+cbin_err_t cbin_reader_checkpoint(cbin_reader_t *reader);
+
+/// Returns to the open checkpoint and clears the error state, closing the
+/// checksummed region if it was started after the checkpoint. A region
+/// started before it must still be open.
+/// \param reader The reader to roll back.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no checkpoint is open.
+cbin_err_t cbin_reader_rollback(cbin_reader_t *reader);
+
+/// Closes the open checkpoint, keeping the current position.
+/// \param reader The reader to commit.
+/// \return \code CBIN_ERR_OK \endcode or the current error state.
+/// \code CBIN_ERR_FAILED \endcode if no checkpoint is open.
+cbin_err_t cbin_reader_commit(cbin_reader_t *reader);
+
 /// Skips a number of bytes in the reader.
 /// \param reader The reader to skip bytes in.
 /// \param count The number of bytes to skip.
@@ -56,7 +221,8 @@ const void *cbin_reader_buffer(const cbin_reader_t *reader);
 /// \return The current position of the reader.
 size_t cbin_reader_position(const cbin_reader_t *reader);
 
-/// Returns the size of the reader.
+/// Returns the size of the reader, for streaming readers this is the end of
+/// the current window.
 /// \param reader The reader to get the size from.
 /// \return The size of the reader.
 size_t cbin_reader_size(const cbin_reader_t *reader);
@@ -66,7 +232,8 @@ size_t cbin_reader_size(const cbin_reader_t *reader);
 /// \return The current error state of the reader.
 cbin_err_t cbin_reader_error(const cbin_reader_t *reader);
 
-/// Returns the number of bytes left to read in the reader.
+/// Returns the number of bytes left to read in the reader, for streaming
+/// readers only the bytes currently buffered are counted.
 /// \param reader The reader to get the number of bytes left to read from
 /// \return The number of bytes left to read in the reader.
 size_t cbin_reader_remaining(const cbin_reader_t *reader);
@@ -79,6 +246,26 @@ size_t cbin_reader_remaining(const cbin_reader_t *reader);
 /// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
 cbin_err_t cbin_read(cbin_reader_t *reader, void *buffer, size_t size);
 
+/// Reads bytes in place: instead of copying them out, returns a pointer to
+/// them inside the reader's buffer. For streaming readers the view is only
+/// valid until the next operation on the reader, and cannot be larger than
+/// the window.
+/// \param reader The reader to read from.
+/// \param size The number of bytes to read.
+/// \param out Receives a pointer to the bytes.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_read_view(cbin_reader_t *reader, size_t size,
+                          const void **out);
+
+/// Checks that a number of bytes can be read from the reader, so that they
+/// can be consumed with the unchecked accessors.
+/// \param reader The reader to check.
+/// \param count The number of bytes that will be read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_reader_ensure(cbin_reader_t *reader, size_t count);
+
 
 cbin_err_t cbin_read_u8(cbin_reader_t *reader, uint8_t *value);
 
@@ -110,7 +297,260 @@ cbin_err_t cbin_read_f64_be(cbin_reader_t *reader, double *value);
 
 cbin_err_t cbin_read_bool(cbin_reader_t *reader, bool *value);
 
-cbin_err_t cbin_reader_find(cbin_reader_t* reader, uint8_t byte, size_t* position);
+/// Reads an array of values with a single bounds check, byte-swapping the
+/// whole span with vectorized kernels when the endianness differs.
+/// \param reader The reader to read from.
+/// \param values The array to read into, may be NULL to skip the values.
+/// \param count The number of values to read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_read_u16_le_array(cbin_reader_t *reader, uint16_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_u16_be_array(cbin_reader_t *reader, uint16_t *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_u32_le_array(cbin_reader_t *reader, uint32_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_u32_be_array(cbin_reader_t *reader, uint32_t *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_u64_le_array(cbin_reader_t *reader, uint64_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_u64_be_array(cbin_reader_t *reader, uint64_t *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_i16_le_array(cbin_reader_t *reader, int16_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_i16_be_array(cbin_reader_t *reader, int16_t *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_i32_le_array(cbin_reader_t *reader, int32_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_i32_be_array(cbin_reader_t *reader, int32_t *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_i64_le_array(cbin_reader_t *reader, int64_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_i64_be_array(cbin_reader_t *reader, int64_t *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_f32_le_array(cbin_reader_t *reader, float *values,
+                                  size_t count);
+cbin_err_t cbin_read_f32_be_array(cbin_reader_t *reader, float *values,
+                                  size_t count);
+
+cbin_err_t cbin_read_f64_le_array(cbin_reader_t *reader, double *values,
+                                  size_t count);
+cbin_err_t cbin_read_f64_be_array(cbin_reader_t *reader, double *values,
+                                  size_t count);
+
+/// Finds the next occurrence of a byte, starting at the current position.
+/// Streaming readers keep refilling until the byte is found; when the window
+/// fills up without a match the scanned bytes are skipped to make room.
+/// \param reader The reader to search in.
+/// \param byte The byte to search for.
+/// \param position Receives the absolute position of the byte.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the byte was not found.
+cbin_err_t cbin_reader_find(cbin_reader_t *reader, uint8_t byte,
+                            size_t *position);
+
+/// Finds the next byte that belongs to a set, such as a group of frame
+/// delimiters. Behaves like cbin_reader_find on streaming readers.
+/// \param reader The reader to search in.
+/// \param bytes The set of bytes to search for.
+/// \param count The number of bytes in the set.
+/// \param position Receives the absolute position of the byte.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no byte of the set was found.
+cbin_err_t cbin_reader_find_any(cbin_reader_t *reader, const uint8_t *bytes,
+                                size_t count, size_t *position);
+
+/// Finds the next occurrence of a multi-byte pattern, such as a sync word.
+/// Streaming readers keep the last bytes of the window that could start a
+/// match across refills, so the pattern cannot be larger than the window.
+/// \param reader The reader to search in.
+/// \param pattern The pattern to search for.
+/// \param size The size of the pattern.
+/// \param position Receives the absolute position of the pattern.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the pattern was not found.
+cbin_err_t cbin_reader_find_pattern(cbin_reader_t *reader,
+                                    const void *pattern, size_t size,
+                                    size_t *position);
+
+/// Finds the last occurrence of a byte between the current position and the
+/// end of the reader, or of the current window for streaming readers.
+/// \param reader The reader to search in.
+/// \param byte The byte to search for.
+/// \param position Receives the absolute position of the byte.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if the byte was not found.
+cbin_err_t cbin_reader_find_reverse(cbin_reader_t *reader, uint8_t byte,
+                                    size_t *position);
+
+/// Copies the counters of a reader, see stats.h.
+/// \param reader The reader to get the counters of.
+/// \param stats Receives the counters, all 0 without CBIN_STATS.
+/// \return Whether the library was built with CBIN_STATS.
+bool cbin_reader_get_stats(const cbin_reader_t *reader,
+                           cbin_reader_stats_t *stats);
+
+/// Adds the counters of a reader to the global registry and clears them.
+/// cbin_reader_destroy publishes them as well.
+/// \param reader The reader to publish the counters of.
+void cbin_reader_publish_stats(cbin_reader_t *reader);
+
+/// Starts a checksummed region at the current position. Every byte consumed
+/// until the region ends is added to the checksum, in blocks as reading goes
+/// on. Bytes read again after seeking back are only counted once.
+/// \param reader The reader to checksum.
+/// \param checksum The checksum to update, which must outlive the region.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if a region is already open.
+cbin_err_t cbin_reader_begin_checksum(cbin_reader_t *reader,
+                                      struct cbin_checksum_s *checksum);
+
+/// Ends the checksummed region, adding the bytes up to the current position
+/// to the checksum.
+/// \param reader The reader to stop checksumming.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no region is open.
+cbin_err_t cbin_reader_end_checksum(cbin_reader_t *reader);
+
+/// Ends the checksummed region and reads the checksum stored right after
+/// it, as a u32_le for CRC-32C or a u64_le for xxHash64.
+/// \param reader The reader to verify.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no region is open.
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CHECKSUM \endcode if the stored checksum does not match.
+cbin_err_t cbin_reader_verify_checksum(cbin_reader_t *reader);
+
+// Unchecked accessors, only valid after a successful cbin_reader_ensure
+// covering every byte they consume.
+
+static inline uint8_t cbin_read_u8_unchecked(cbin_reader_t *reader) {
+    return ((const uint8_t *)reader->_buffer)[reader->_position++];
+}
+static inline int8_t cbin_read_i8_unchecked(cbin_reader_t *reader) {
+    return (int8_t)cbin_read_u8_unchecked(reader);
+}
+static inline bool cbin_read_bool_unchecked(cbin_reader_t *reader) {
+    return cbin_read_u8_unchecked(reader) != 0;
+}
+
+static inline uint16_t cbin_read_u16_le_unchecked(cbin_reader_t *reader) {
+    uint16_t value = (uint16_t)cbin_load_u16_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 2;
+    return value;
+}
+static inline uint16_t cbin_read_u16_be_unchecked(cbin_reader_t *reader) {
+    uint16_t value = (uint16_t)cbin_load_u16_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 2;
+    return value;
+}
+
+static inline int16_t cbin_read_i16_le_unchecked(cbin_reader_t *reader) {
+    int16_t value = (int16_t)cbin_load_u16_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 2;
+    return value;
+}
+static inline int16_t cbin_read_i16_be_unchecked(cbin_reader_t *reader) {
+    int16_t value = (int16_t)cbin_load_u16_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 2;
+    return value;
+}
+
+static inline uint32_t cbin_read_u32_le_unchecked(cbin_reader_t *reader) {
+    uint32_t value = (uint32_t)cbin_load_u32_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 4;
+    return value;
+}
+static inline uint32_t cbin_read_u32_be_unchecked(cbin_reader_t *reader) {
+    uint32_t value = (uint32_t)cbin_load_u32_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 4;
+    return value;
+}
+
+static inline int32_t cbin_read_i32_le_unchecked(cbin_reader_t *reader) {
+    int32_t value = (int32_t)cbin_load_u32_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 4;
+    return value;
+}
+static inline int32_t cbin_read_i32_be_unchecked(cbin_reader_t *reader) {
+    int32_t value = (int32_t)cbin_load_u32_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 4;
+    return value;
+}
+
+static inline uint64_t cbin_read_u64_le_unchecked(cbin_reader_t *reader) {
+    uint64_t value = (uint64_t)cbin_load_u64_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 8;
+    return value;
+}
+static inline uint64_t cbin_read_u64_be_unchecked(cbin_reader_t *reader) {
+    uint64_t value = (uint64_t)cbin_load_u64_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 8;
+    return value;
+}
+
+static inline int64_t cbin_read_i64_le_unchecked(cbin_reader_t *reader) {
+    int64_t value = (int64_t)cbin_load_u64_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 8;
+    return value;
+}
+static inline int64_t cbin_read_i64_be_unchecked(cbin_reader_t *reader) {
+    int64_t value = (int64_t)cbin_load_u64_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    reader->_position += 8;
+    return value;
+}
+
+static inline float cbin_read_f32_le_unchecked(cbin_reader_t *reader) {
+    uint32_t bits = cbin_load_u32_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    reader->_position += 4;
+    return value;
+}
+static inline float cbin_read_f32_be_unchecked(cbin_reader_t *reader) {
+    uint32_t bits = cbin_load_u32_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    reader->_position += 4;
+    return value;
+}
+
+static inline double cbin_read_f64_le_unchecked(cbin_reader_t *reader) {
+    uint64_t bits = cbin_load_u64_le(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    reader->_position += 8;
+    return value;
+}
+static inline double cbin_read_f64_be_unchecked(cbin_reader_t *reader) {
+    uint64_t bits = cbin_load_u64_be(
+        (const uint8_t *)reader->_buffer + reader->_position);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    reader->_position += 8;
+    return value;
+}
 
 CBIN_HEADER_END
 
@@ -0,0 +1,285 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE
+#endif
+#include "scan.h"
+#include "cpu.h"
+#include <string.h>
+
+#if defined(CBIN_HAVE_SSE2)
+#    include <emmintrin.h>
+#endif
+#if defined(CBIN_HAVE_DISPATCH)
+#    include <immintrin.h>
+#endif
+#if defined(CBIN_ARCH_NEON)
+#    include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define CTZ(x) ((size_t)__builtin_ctz(x))
+#    define CLZ(x) ((size_t)__builtin_clz(x))
+#else
+static size_t CTZ(unsigned x) {
+    size_t n = 0;
+    while (!(x & 1))
+        x >>= 1, n++;
+    return n;
+}
+static size_t CLZ(unsigned x) {
+    size_t n = 0;
+    while (!(x & 0x80000000u))
+        x <<= 1, n++;
+    return n;
+}
+#endif
+
+size_t cbin_scan_byte(const uint8_t *buffer, size_t size, uint8_t byte) {
+    // The C library's memchr is already vectorized on every platform that
+    // matters, nothing hand written beats it.
+    const void *match = size ? memchr(buffer, byte, size) : NULL;
+    return match ? (size_t)((const uint8_t *)match - buffer) : size;
+}
+
+size_t cbin_scan_byte_reverse(const uint8_t *buffer, size_t size,
+                              uint8_t byte) {
+#if defined(__GLIBC__)
+    const void *match = size ? memrchr(buffer, byte, size) : NULL;
+    return match ? (size_t)((const uint8_t *)match - buffer) : size;
+#else
+    size_t i = size;
+#    if defined(CBIN_HAVE_SSE2)
+    const __m128i needle = _mm_set1_epi8((char)byte);
+    while (i >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(buffer + i - 16));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(block, needle));
+        if (mask)
+            return i - 16 + (31 - CLZ(mask));
+        i -= 16;
+    }
+#    endif
+    while (i > 0) {
+        if (buffer[--i] == byte)
+            return i;
+    }
+    return size;
+#endif
+}
+
+#if defined(CBIN_ARCH_NEON)
+// NEON has no movemask, narrowing the comparison to 4 bits per byte gives a
+// 64-bit mask where match i sits at bit 4 * i.
+static inline uint64_t neon_mask(uint8x16_t hits) {
+    return vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+}
+#endif
+
+// The vector kernels below return the offset of the first match, or size
+// with *tail set to where the vector loop stopped so that the remaining
+// bytes can be finished by the scalar code.
+
+#if defined(CBIN_HAVE_DISPATCH)
+CBIN_TARGET("avx2")
+static size_t scan_any_avx2(const uint8_t *buffer, size_t size,
+                            const uint8_t *set, size_t set_size,
+                            size_t *tail) {
+    __m256i needles[CBIN_FIND_ANY_MAX];
+    for (size_t k = 0; k < set_size; k++)
+        needles[k] = _mm256_set1_epi8((char)set[k]);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(buffer + i));
+        __m256i hits = _mm256_cmpeq_epi8(block, needles[0]);
+        for (size_t k = 1; k < set_size; k++)
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[k]));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        if (mask)
+            return i + CTZ(mask);
+    }
+    *tail = i;
+    return size;
+}
+
+CBIN_TARGET("avx2")
+static size_t scan_pattern_avx2(const uint8_t *buffer, size_t size,
+                                const uint8_t *pattern, size_t pattern_size,
+                                size_t *tail) {
+    const __m256i first = _mm256_set1_epi8((char)pattern[0]);
+    const __m256i last = _mm256_set1_epi8((char)pattern[pattern_size - 1]);
+    size_t i = 0;
+    for (; i + pattern_size - 1 + 32 <= size; i += 32) {
+        __m256i head = _mm256_loadu_si256((const __m256i *)(buffer + i));
+        __m256i tail_block = _mm256_loadu_si256(
+            (const __m256i *)(buffer + i + pattern_size - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first),
+                             _mm256_cmpeq_epi8(tail_block, last)));
+        while (mask) {
+            size_t offset = i + CTZ(mask);
+            if (!memcmp(buffer + offset + 1, pattern + 1, pattern_size - 2))
+                return offset;
+            mask &= mask - 1;
+        }
+    }
+    *tail = i;
+    return size;
+}
+#endif
+
+#if defined(CBIN_HAVE_SSE2)
+static size_t scan_any_sse2(const uint8_t *buffer, size_t size,
+                            const uint8_t *set, size_t set_size,
+                            size_t *tail) {
+    __m128i needles[CBIN_FIND_ANY_MAX];
+    for (size_t k = 0; k < set_size; k++)
+        needles[k] = _mm_set1_epi8((char)set[k]);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(buffer + i));
+        __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+        for (size_t k = 1; k < set_size; k++)
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[k]));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask)
+            return i + CTZ(mask);
+    }
+    *tail = i;
+    return size;
+}
+
+static size_t scan_pattern_sse2(const uint8_t *buffer, size_t size,
+                                const uint8_t *pattern, size_t pattern_size,
+                                size_t *tail) {
+    const __m128i first = _mm_set1_epi8((char)pattern[0]);
+    const __m128i last = _mm_set1_epi8((char)pattern[pattern_size - 1]);
+    size_t i = 0;
+    for (; i + pattern_size - 1 + 16 <= size; i += 16) {
+        __m128i head = _mm_loadu_si128((const __m128i *)(buffer + i));
+        __m128i tail_block =
+            _mm_loadu_si128((const __m128i *)(buffer + i + pattern_size - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail_block, last)));
+        while (mask) {
+            size_t offset = i + CTZ(mask);
+            if (!memcmp(buffer + offset + 1, pattern + 1, pattern_size - 2))
+                return offset;
+            mask &= mask - 1;
+        }
+    }
+    *tail = i;
+    return size;
+}
+#elif defined(CBIN_ARCH_NEON)
+static size_t scan_any_neon(const uint8_t *buffer, size_t size,
+                            const uint8_t *set, size_t set_size,
+                            size_t *tail) {
+    uint8x16_t needles[CBIN_FIND_ANY_MAX];
+    for (size_t k = 0; k < set_size; k++)
+        needles[k] = vdupq_n_u8(set[k]);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t block = vld1q_u8(buffer + i);
+        uint8x16_t hits = vceqq_u8(block, needles[0]);
+        for (size_t k = 1; k < set_size; k++)
+            hits = vorrq_u8(hits, vceqq_u8(block, needles[k]));
+        uint64_t mask = neon_mask(hits);
+        if (mask)
+            return i + (size_t)__builtin_ctzll(mask) / 4;
+    }
+    *tail = i;
+    return size;
+}
+
+static size_t scan_pattern_neon(const uint8_t *buffer, size_t size,
+                                const uint8_t *pattern, size_t pattern_size,
+                                size_t *tail) {
+    const uint8x16_t first = vdupq_n_u8(pattern[0]);
+    const uint8x16_t last = vdupq_n_u8(pattern[pattern_size - 1]);
+    size_t i = 0;
+    for (; i + pattern_size - 1 + 16 <= size; i += 16) {
+        uint8x16_t head = vld1q_u8(buffer + i);
+        uint8x16_t tail_block = vld1q_u8(buffer + i + pattern_size - 1);
+        uint64_t mask = neon_mask(
+            vandq_u8(vceqq_u8(head, first), vceqq_u8(tail_block, last)));
+        while (mask) {
+            size_t offset = i + (size_t)__builtin_ctzll(mask) / 4;
+            if (!memcmp(buffer + offset + 1, pattern + 1, pattern_size - 2))
+                return offset;
+            mask &= ~((uint64_t)0xf << (4 * (offset - i)));
+        }
+    }
+    *tail = i;
+    return size;
+}
+#endif
+
+size_t cbin_scan_any(const uint8_t *buffer, size_t size, const uint8_t *set,
+                     size_t set_size) {
+    if (set_size == 0)
+        return size;
+    if (set_size == 1)
+        return cbin_scan_byte(buffer, size, set[0]);
+    size_t tail = 0;
+    if (set_size <= CBIN_FIND_ANY_MAX) {
+        size_t match = size;
+#if defined(CBIN_HAVE_DISPATCH)
+        if (cbin_cpu_features() & CBIN_CPU_AVX2)
+            match = scan_any_avx2(buffer, size, set, set_size, &tail);
+#    if defined(CBIN_HAVE_SSE2)
+        else
+            match = scan_any_sse2(buffer, size, set, set_size, &tail);
+#    endif
+#elif defined(CBIN_HAVE_SSE2)
+        match = scan_any_sse2(buffer, size, set, set_size, &tail);
+#elif defined(CBIN_ARCH_NEON)
+        match = scan_any_neon(buffer, size, set, set_size, &tail);
+#endif
+        if (match < size)
+            return match;
+    }
+    uint8_t table[256] = {0};
+    for (size_t k = 0; k < set_size; k++)
+        table[set[k]] = 1;
+    for (size_t i = tail; i < size; i++) {
+        if (table[buffer[i]])
+            return i;
+    }
+    return size;
+}
+
+size_t cbin_scan_pattern(const uint8_t *buffer, size_t size,
+                         const uint8_t *pattern, size_t pattern_size) {
+    if (pattern_size == 0)
+        return 0;
+    if (pattern_size > size)
+        return size;
+    if (pattern_size == 1)
+        return cbin_scan_byte(buffer, size, pattern[0]);
+    // Candidates are positions where both the first and the last byte of
+    // the pattern match, which filters out nearly everything before the
+    // full comparison.
+    size_t tail = 0;
+    size_t match = size;
+#if defined(CBIN_HAVE_DISPATCH)
+    if (cbin_cpu_features() & CBIN_CPU_AVX2)
+        match = scan_pattern_avx2(buffer, size, pattern, pattern_size, &tail);
+#    if defined(CBIN_HAVE_SSE2)
+    else
+        match = scan_pattern_sse2(buffer, size, pattern, pattern_size, &tail);
+#    endif
+#elif defined(CBIN_HAVE_SSE2)
+    match = scan_pattern_sse2(buffer, size, pattern, pattern_size, &tail);
+#elif defined(CBIN_ARCH_NEON)
+    match = scan_pattern_neon(buffer, size, pattern, pattern_size, &tail);
+#endif
+    if (match < size)
+        return match;
+    for (size_t i = tail; i + pattern_size <= size; i++) {
+        if (buffer[i] == pattern[0] &&
+            buffer[i + pattern_size - 1] == pattern[pattern_size - 1] &&
+            !memcmp(buffer + i + 1, pattern + 1, pattern_size - 2))
+            return i;
+    }
+    return size;
+}
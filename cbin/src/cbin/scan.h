@@ -0,0 +1,28 @@
+#ifndef CBIN_SRC_CBIN_SCAN_H
+#define CBIN_SRC_CBIN_SCAN_H
+#include "common.h"
+#include <stdint.h>
+
+/// Sets up to this size are matched with vector compares, larger ones fall
+/// back to a lookup table.
+#define CBIN_FIND_ANY_MAX 16
+
+CBIN_HEADER_BEGIN
+
+/// Vectorized search kernels behind cbin_reader_find and friends. Each one
+/// returns the offset of the match in the buffer, or \p size if none.
+
+size_t cbin_scan_byte(const uint8_t *buffer, size_t size, uint8_t byte);
+
+size_t cbin_scan_byte_reverse(const uint8_t *buffer, size_t size,
+                              uint8_t byte);
+
+size_t cbin_scan_any(const uint8_t *buffer, size_t size, const uint8_t *set,
+                     size_t set_size);
+
+size_t cbin_scan_pattern(const uint8_t *buffer, size_t size,
+                         const uint8_t *pattern, size_t pattern_size);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_SCAN_H
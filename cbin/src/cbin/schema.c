@@ -0,0 +1,401 @@
+#include "schema.h"
+#include <endianness/byte_swap.h>
+#include <endianness/detection.h>
+#include <string.h>
+
+// Records are processed in blocks, one step at a time over the whole block,
+// so each inner loop has a single fixed job and the block stays in cache.
+#define SCHEMA_BLOCK 64
+
+enum {
+    OP_COPY,
+    OP_SWAP16,
+    OP_SWAP32,
+    OP_SWAP64,
+    OP_BOOL,
+    OP_ZERO,
+};
+
+// A step of a compiled schema. The length is in bytes for copies and
+// zeroing, in values for swaps and booleans.
+typedef struct cbin_schema_op_s {
+    unsigned kind;
+    size_t wire;
+    size_t mem;
+    size_t length;
+} cbin_schema_op_t;
+
+enum { ORDER_NONE, ORDER_LE, ORDER_BE };
+
+#ifdef __LITTLE_ENDIAN__
+#    define ORDER_NATIVE ORDER_LE
+#else
+#    define ORDER_NATIVE ORDER_BE
+#endif
+
+static const struct {
+    unsigned char size;
+    unsigned char order;
+} cbin_field_info[] = {
+    [CBIN_FIELD_U8] = {1, ORDER_NONE},     [CBIN_FIELD_I8] = {1, ORDER_NONE},
+    [CBIN_FIELD_BOOL] = {1, ORDER_NONE},   [CBIN_FIELD_U16_LE] = {2, ORDER_LE},
+    [CBIN_FIELD_U16_BE] = {2, ORDER_BE},   [CBIN_FIELD_I16_LE] = {2, ORDER_LE},
+    [CBIN_FIELD_I16_BE] = {2, ORDER_BE},   [CBIN_FIELD_U32_LE] = {4, ORDER_LE},
+    [CBIN_FIELD_U32_BE] = {4, ORDER_BE},   [CBIN_FIELD_I32_LE] = {4, ORDER_LE},
+    [CBIN_FIELD_I32_BE] = {4, ORDER_BE},   [CBIN_FIELD_U64_LE] = {8, ORDER_LE},
+    [CBIN_FIELD_U64_BE] = {8, ORDER_BE},   [CBIN_FIELD_I64_LE] = {8, ORDER_LE},
+    [CBIN_FIELD_I64_BE] = {8, ORDER_BE},   [CBIN_FIELD_F32_LE] = {4, ORDER_LE},
+    [CBIN_FIELD_F32_BE] = {4, ORDER_BE},   [CBIN_FIELD_F64_LE] = {8, ORDER_LE},
+    [CBIN_FIELD_F64_BE] = {8, ORDER_BE},   [CBIN_FIELD_BYTES] = {0, ORDER_NONE},
+    [CBIN_FIELD_PADDING] = {0, ORDER_NONE},
+};
+
+// Returns the size in memory of the values handled by an op.
+static size_t cbin_schema_op_width(unsigned kind) {
+    switch (kind) {
+    case OP_SWAP16:
+        return 2;
+    case OP_SWAP32:
+        return 4;
+    case OP_SWAP64:
+        return 8;
+    case OP_BOOL:
+        return sizeof(bool);
+    default:
+        return 1;
+    }
+}
+
+// Appends a step, or extends the previous one when the new step continues
+// it both on the wire and in memory.
+static cbin_err_t cbin_schema_push(cbin_schema_t *schema, size_t *capacity,
+                                   unsigned kind, size_t wire, size_t mem,
+                                   size_t length) {
+    if (schema->_op_count > 0) {
+        cbin_schema_op_t *last = &schema->_ops[schema->_op_count - 1];
+        size_t width = cbin_schema_op_width(kind);
+        size_t wire_width = kind == OP_BOOL ? 1 : width;
+        if (last->kind == kind &&
+            last->wire + last->length * wire_width == wire &&
+            (kind == OP_ZERO || last->mem + last->length * width == mem)) {
+            last->length += length;
+            return CBIN_ERR_OK;
+        }
+    }
+    if (schema->_op_count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 8;
+        void *ops = CBIN_REALLOC(schema->_ops,
+                                 new_capacity * sizeof(cbin_schema_op_t));
+        if (!ops)
+            return CBIN_ERR_OUT_OF_MEMORY;
+        schema->_ops = (cbin_schema_op_t *)ops;
+        *capacity = new_capacity;
+    }
+    cbin_schema_op_t *op = &schema->_ops[schema->_op_count++];
+    op->kind = kind;
+    op->wire = wire;
+    op->mem = mem;
+    op->length = length;
+    return CBIN_ERR_OK;
+}
+
+// Checks whether a whole batch can be handled at once, see _flat.
+static void cbin_schema_flatten(cbin_schema_t *schema) {
+    schema->_flat = false;
+    schema->_flat_swap = NULL;
+    if (schema->_op_count == 0 || schema->_wire_size != schema->_record_size)
+        return;
+    unsigned kind = schema->_ops[0].kind;
+    if (kind == OP_BOOL || kind == OP_ZERO)
+        return;
+    for (size_t i = 0; i < schema->_op_count; i++) {
+        if (schema->_ops[i].kind != kind ||
+            schema->_ops[i].mem != schema->_ops[i].wire)
+            return;
+    }
+    schema->_flat = true;
+    if (kind == OP_SWAP16)
+        schema->_flat_swap = cbin_bswap16_array;
+    else if (kind == OP_SWAP32)
+        schema->_flat_swap = cbin_bswap32_array;
+    else if (kind == OP_SWAP64)
+        schema->_flat_swap = cbin_bswap64_array;
+}
+
+cbin_err_t cbin_schema_init(cbin_schema_t *schema, const cbin_field_t *fields,
+                            size_t count, size_t record_size) {
+    size_t capacity = 0;
+    cbin_err_t err = CBIN_ERR_OK;
+    schema->_ops = NULL;
+    schema->_op_count = 0;
+    schema->_wire_size = 0;
+    schema->_record_size = record_size;
+    for (size_t i = 0; i < count && !err; i++) {
+        const cbin_field_t *field = &fields[i];
+        if ((unsigned)field->type > CBIN_FIELD_PADDING) {
+            err = CBIN_ERR_FAILED;
+            break;
+        }
+        size_t size = cbin_field_info[field->type].size;
+        unsigned order = cbin_field_info[field->type].order;
+        if (field->type == CBIN_FIELD_BYTES ||
+            field->type == CBIN_FIELD_PADDING)
+            size = field->size;
+        if (size == 0)
+            continue;
+
+        unsigned kind = OP_COPY;
+        size_t length = size;
+        size_t mem_size = size;
+        if (field->type == CBIN_FIELD_PADDING) {
+            kind = OP_ZERO;
+        } else if (field->type == CBIN_FIELD_BOOL) {
+            kind = OP_BOOL;
+            length = 1;
+            mem_size = sizeof(bool);
+        } else if (order != ORDER_NONE && order != ORDER_NATIVE) {
+            kind = size == 2 ? OP_SWAP16 : size == 4 ? OP_SWAP32 : OP_SWAP64;
+            length = 1;
+        }
+        if (kind != OP_ZERO && (field->offset > record_size ||
+                                mem_size > record_size - field->offset)) {
+            err = CBIN_ERR_OUT_OF_BOUNDS;
+            break;
+        }
+        err = cbin_schema_push(schema, &capacity, kind, schema->_wire_size,
+                               field->offset, length);
+        schema->_wire_size += size;
+    }
+    if (err) {
+        cbin_schema_destroy(schema);
+        return err;
+    }
+    cbin_schema_flatten(schema);
+    return CBIN_ERR_OK;
+}
+
+void cbin_schema_destroy(cbin_schema_t *schema) {
+    if (schema->_ops)
+        CBIN_FREE(schema->_ops);
+    schema->_ops = NULL;
+    schema->_op_count = 0;
+}
+
+size_t cbin_schema_wire_size(const cbin_schema_t *schema) {
+    return schema->_wire_size;
+}
+
+// Copies a run of bytes out of every record of a block, with the common
+// member sizes unrolled into plain loads and stores.
+#define COPY_LOOP(size)                                                        \
+    for (size_t i = 0; i < count; i++)                                         \
+        memcpy(dst + i * dst_stride, src + i * src_stride, (size));            \
+    break
+
+static void cbin_schema_copy(uint8_t *dst, size_t dst_stride,
+                             const uint8_t *src, size_t src_stride,
+                             size_t length, size_t count) {
+    switch (length) {
+    case 1:
+        COPY_LOOP(1);
+    case 2:
+        COPY_LOOP(2);
+    case 4:
+        COPY_LOOP(4);
+    case 8:
+        COPY_LOOP(8);
+    case 16:
+        COPY_LOOP(16);
+    default:
+        COPY_LOOP(length);
+    }
+}
+
+#define SWAP_LOOP(type, swap)                                                  \
+    for (size_t i = 0; i < count; i++) {                                       \
+        for (size_t j = 0; j < length; j++) {                                  \
+            type value;                                                        \
+            memcpy(&value, src + i * src_stride + j * sizeof(type),            \
+                   sizeof(type));                                              \
+            value = swap(value);                                               \
+            memcpy(dst + i * dst_stride + j * sizeof(type), &value,            \
+                   sizeof(type));                                              \
+        }                                                                      \
+    }                                                                          \
+    break
+
+// Byte-swaps the values of a step, in either direction.
+static void cbin_schema_swap(unsigned kind, uint8_t *dst, size_t dst_stride,
+                             const uint8_t *src, size_t src_stride,
+                             size_t length, size_t count) {
+    switch (kind) {
+    case OP_SWAP16:
+        SWAP_LOOP(uint16_t, bswap16);
+    case OP_SWAP32:
+        SWAP_LOOP(uint32_t, bswap32);
+    default:
+        SWAP_LOOP(uint64_t, bswap64);
+    }
+}
+
+static void cbin_schema_decode(const cbin_schema_t *schema, uint8_t *records,
+                               const uint8_t *wire, size_t count) {
+    size_t wire_size = schema->_wire_size;
+    size_t record_size = schema->_record_size;
+    if (schema->_flat) {
+        if (!schema->_flat_swap) {
+            memcpy(records, wire, count * wire_size);
+            return;
+        }
+        size_t width = cbin_schema_op_width(schema->_ops[0].kind);
+        schema->_flat_swap(records, wire, count * wire_size / width);
+        return;
+    }
+    for (size_t base = 0; base < count; base += SCHEMA_BLOCK) {
+        size_t block = count - base;
+        if (block > SCHEMA_BLOCK)
+            block = SCHEMA_BLOCK;
+        const uint8_t *src_block = wire + base * wire_size;
+        uint8_t *dst_block = records + base * record_size;
+        for (size_t k = 0; k < schema->_op_count; k++) {
+            const cbin_schema_op_t *op = &schema->_ops[k];
+            const uint8_t *src = src_block + op->wire;
+            uint8_t *dst = dst_block + op->mem;
+            switch (op->kind) {
+            case OP_COPY:
+                cbin_schema_copy(dst, record_size, src, wire_size, op->length,
+                                 block);
+                break;
+            case OP_BOOL:
+                for (size_t i = 0; i < block; i++) {
+                    for (size_t j = 0; j < op->length; j++) {
+                        bool value = src[i * wire_size + j] != 0;
+                        memcpy(dst + i * record_size + j * sizeof(bool),
+                               &value, sizeof(bool));
+                    }
+                }
+                break;
+            case OP_ZERO:
+                break;
+            default:
+                cbin_schema_swap(op->kind, dst, record_size, src, wire_size,
+                                 op->length, block);
+                break;
+            }
+        }
+    }
+}
+
+static void cbin_schema_encode(const cbin_schema_t *schema, uint8_t *wire,
+                               const uint8_t *records, size_t count) {
+    size_t wire_size = schema->_wire_size;
+    size_t record_size = schema->_record_size;
+    if (schema->_flat) {
+        if (!schema->_flat_swap) {
+            memcpy(wire, records, count * wire_size);
+            return;
+        }
+        size_t width = cbin_schema_op_width(schema->_ops[0].kind);
+        schema->_flat_swap(wire, records, count * wire_size / width);
+        return;
+    }
+    for (size_t base = 0; base < count; base += SCHEMA_BLOCK) {
+        size_t block = count - base;
+        if (block > SCHEMA_BLOCK)
+            block = SCHEMA_BLOCK;
+        const uint8_t *src_block = records + base * record_size;
+        uint8_t *dst_block = wire + base * wire_size;
+        for (size_t k = 0; k < schema->_op_count; k++) {
+            const cbin_schema_op_t *op = &schema->_ops[k];
+            const uint8_t *src = src_block + op->mem;
+            uint8_t *dst = dst_block + op->wire;
+            switch (op->kind) {
+            case OP_COPY:
+                cbin_schema_copy(dst, wire_size, src, record_size, op->length,
+                                 block);
+                break;
+            case OP_BOOL:
+                for (size_t i = 0; i < block; i++) {
+                    for (size_t j = 0; j < op->length; j++) {
+                        bool value;
+                        memcpy(&value,
+                               src + i * record_size + j * sizeof(bool),
+                               sizeof(bool));
+                        dst[i * wire_size + j] = value ? 1 : 0;
+                    }
+                }
+                break;
+            case OP_ZERO:
+                for (size_t i = 0; i < block; i++)
+                    memset(dst + i * wire_size, 0, op->length);
+                break;
+            default:
+                cbin_schema_swap(op->kind, dst, wire_size, src, record_size,
+                                 op->length, block);
+                break;
+            }
+        }
+    }
+}
+
+cbin_err_t cbin_read_records(cbin_reader_t *reader,
+                             const cbin_schema_t *schema, void *records,
+                             size_t count) {
+    if (reader->_error)
+        return reader->_error;
+    size_t wire_size = schema->_wire_size;
+    if (wire_size == 0)
+        return CBIN_ERR_OK;
+    if (count > (size_t)-1 / wire_size)
+        return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
+    uint8_t *out = (uint8_t *)records;
+    while (count > 0) {
+        // Streaming readers decode a window at a time.
+        size_t batch = count;
+        if (reader->_refill) {
+            size_t fit = reader->_window_capacity / wire_size;
+            if (fit == 0)
+                return CBIN_ERROR(reader, CBIN_ERR_OUT_OF_BOUNDS);
+            if (batch > fit)
+                batch = fit;
+        }
+        const void *src;
+        if (cbin_read_view(reader, batch * wire_size, &src))
+            return reader->_error;
+        cbin_schema_decode(schema, out, (const uint8_t *)src, batch);
+        out += batch * schema->_record_size;
+        count -= batch;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_write_records(cbin_writer_t *writer,
+                              const cbin_schema_t *schema,
+                              const void *records, size_t count) {
+    if (writer->_error)
+        return writer->_error;
+    size_t wire_size = schema->_wire_size;
+    if (wire_size == 0)
+        return CBIN_ERR_OK;
+    if (count > (size_t)-1 / wire_size)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    const uint8_t *in = (const uint8_t *)records;
+    while (count > 0) {
+        // Flushing writers encode a buffer at a time.
+        size_t batch = count;
+        if (writer->_sink) {
+            size_t fit = writer->_capacity / wire_size;
+            if (fit == 0)
+                return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+            if (batch > fit)
+                batch = fit;
+        }
+        void *dst;
+        if (cbin_writer_reserve(writer, batch * wire_size, &dst))
+            return writer->_error;
+        cbin_schema_encode(schema, (uint8_t *)dst, in, batch);
+        in += batch * schema->_record_size;
+        count -= batch;
+    }
+    return CBIN_ERR_OK;
+}
@@ -0,0 +1,127 @@
+#ifndef CBIN_SRC_CBIN_SCHEMA_H
+#define CBIN_SRC_CBIN_SCHEMA_H
+#include "bswap_array.h"
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+#include <stddef.h>
+
+/// The wire type of a schema field.
+typedef enum cbin_field_type_e {
+    CBIN_FIELD_U8,
+    CBIN_FIELD_I8,
+    CBIN_FIELD_BOOL,
+    CBIN_FIELD_U16_LE,
+    CBIN_FIELD_U16_BE,
+    CBIN_FIELD_I16_LE,
+    CBIN_FIELD_I16_BE,
+    CBIN_FIELD_U32_LE,
+    CBIN_FIELD_U32_BE,
+    CBIN_FIELD_I32_LE,
+    CBIN_FIELD_I32_BE,
+    CBIN_FIELD_U64_LE,
+    CBIN_FIELD_U64_BE,
+    CBIN_FIELD_I64_LE,
+    CBIN_FIELD_I64_BE,
+    CBIN_FIELD_F32_LE,
+    CBIN_FIELD_F32_BE,
+    CBIN_FIELD_F64_LE,
+    CBIN_FIELD_F64_BE,
+    /// Raw bytes copied as they are, the size is given by the field.
+    CBIN_FIELD_BYTES,
+    /// Bytes on the wire that are not mapped to a member, skipped when
+    /// decoding and zeroed when encoding. The size is given by the field.
+    CBIN_FIELD_PADDING,
+} cbin_field_type_t;
+
+/// A field of a fixed-size record, mapping a value on the wire to a member
+/// of a struct. Fields are laid out on the wire in the order they are
+/// given, without gaps.
+typedef struct cbin_field_s {
+    cbin_field_type_t type;
+    /// The offset of the member in the struct.
+    size_t offset;
+    /// The size of CBIN_FIELD_BYTES and CBIN_FIELD_PADDING fields, ignored
+    /// for the other types.
+    size_t size;
+} cbin_field_t;
+
+/// Describes a member of a struct as a field of the given type, e.g.
+/// CBIN_FIELD(U32_BE, struct point, x).
+#define CBIN_FIELD(type, record, member)                                       \
+    { CBIN_FIELD_##type, offsetof(record, member), 0 }
+
+/// Describes an array member of a struct as raw bytes.
+#define CBIN_FIELD_RAW(record, member)                                         \
+    {                                                                          \
+        CBIN_FIELD_BYTES, offsetof(record, member),                            \
+            sizeof(((record *)0)->member)                                      \
+    }
+
+/// Describes bytes on the wire that are not mapped to a member.
+#define CBIN_FIELD_PAD(size) { CBIN_FIELD_PADDING, 0, (size) }
+
+/// A list of fields compiled into a plan of copy and byte-swap steps, with
+/// adjacent fields that need the same treatment merged into a single step.
+typedef struct cbin_schema_s {
+    struct cbin_schema_op_s *_ops;
+    size_t _op_count;
+    size_t _wire_size;
+    size_t _record_size;
+    // Set when records have the same layout in memory and on the wire, so
+    // a whole batch is handled by a single copy or array swap.
+    bool _flat;
+    cbin_bswap_array_fn _flat_swap;
+} cbin_schema_t;
+
+CBIN_HEADER_BEGIN
+
+/// Compiles a list of fields into a schema.
+/// \param schema The schema to initialize.
+/// \param fields The fields of a record, in wire order.
+/// \param count The number of fields.
+/// \param record_size The size of the struct holding a record in memory,
+/// usually sizeof the struct.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode if a field lies outside the struct.
+/// \code CBIN_ERR_FAILED \endcode if a field type is unknown.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_schema_init(cbin_schema_t *schema, const cbin_field_t *fields,
+                            size_t count, size_t record_size);
+
+/// Destroys a schema.
+/// \param schema The schema to destroy.
+void cbin_schema_destroy(cbin_schema_t *schema);
+
+/// Returns the size of an encoded record.
+/// \param schema The schema to get the size of.
+/// \return The size of a record on the wire.
+size_t cbin_schema_wire_size(const cbin_schema_t *schema);
+
+/// Decodes records into an array of structs, with a single bounds check
+/// per batch. Members that are not described by a field are left
+/// untouched.
+/// \param reader The reader to read from.
+/// \param schema The schema of the records.
+/// \param records The array of structs to decode into.
+/// \param count The number of records to read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_read_records(cbin_reader_t *reader,
+                             const cbin_schema_t *schema, void *records,
+                             size_t count);
+
+/// Encodes an array of structs, with a single reservation per batch.
+/// \param writer The writer to write to.
+/// \param schema The schema of the records.
+/// \param records The array of structs to encode.
+/// \param count The number of records to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_records(cbin_writer_t *writer,
+                              const cbin_schema_t *schema,
+                              const void *records, size_t count);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_SCHEMA_H
@@ -0,0 +1,506 @@
+#include "series.h"
+#include "bytes.h"
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define CLZ64(x) ((unsigned)__builtin_clzll(x))
+#    define CTZ64(x) ((unsigned)__builtin_ctzll(x))
+#else
+static unsigned CLZ64(uint64_t x) {
+    unsigned n = 0;
+    while (!(x & 0x8000000000000000ull))
+        x <<= 1, n++;
+    return n;
+}
+static unsigned CTZ64(uint64_t x) {
+    unsigned n = 0;
+    while (!(x & 1))
+        x >>= 1, n++;
+    return n;
+}
+#endif
+
+// The width of the leading zero count and of the meaningful bit count of a
+// new XOR window. Both fit the full range of the sample width, a count
+// equal to the width is stored as 0.
+#define XOR64_FIELD 6
+#define XOR32_FIELD 5
+
+// Array readers decode straight from the buffer while this many bytes are
+// left past the current one, more than the 10 bytes of the longest sample
+// plus the 8-byte loads that read it.
+#define SERIES_MARGIN 24
+
+void cbin_xor_state_init(cbin_xor_state_t *state) {
+    state->_previous = 0;
+    state->_leading = 0;
+    state->_trailing = 0;
+    state->_started = false;
+}
+
+void cbin_dod_state_init(cbin_dod_state_t *state) {
+    state->_previous = 0;
+    state->_delta = 0;
+    state->_started = false;
+}
+
+// Control prefixes are given in stream order, most significant bit first,
+// and reversed for an LSB-first stream so that their bits are read back one
+// at a time in the same order.
+static inline uint64_t cbin_series_prefix(const cbin_bitwriter_t *bits,
+                                          uint64_t prefix, unsigned width) {
+    if (bits->_order == CBIN_BITS_MSB_FIRST)
+        return prefix;
+    uint64_t reversed = 0;
+    for (unsigned i = 0; i < width; i++)
+        reversed |= (prefix >> i & 1) << (width - 1 - i);
+    return reversed;
+}
+
+// Writes two consecutive fields, as one when they fit in 64 bits. b must
+// fit in wb bits.
+static inline cbin_err_t cbin_series_write2(cbin_bitwriter_t *bits,
+                                            unsigned wa, uint64_t a,
+                                            unsigned wb, uint64_t b) {
+    if (wa + wb > 64) {
+        if (cbin_bitwriter_write(bits, wa, a))
+            return bits->_writer->_error;
+        return cbin_bitwriter_write(bits, wb, b);
+    }
+    if (bits->_order == CBIN_BITS_MSB_FIRST)
+        return cbin_bitwriter_write(bits, wa + wb, a << wb | b);
+    return cbin_bitwriter_write(bits, wa + wb, a | b << wa);
+}
+
+static inline cbin_err_t cbin_xor_write(cbin_bitwriter_t *bits,
+                                        cbin_xor_state_t *state,
+                                        uint64_t value, unsigned width,
+                                        unsigned field) {
+    if (CBIN_UNLIKELY(!state->_started)) {
+        state->_started = true;
+        state->_previous = value;
+        return cbin_bitwriter_write(bits, width, value);
+    }
+    uint64_t x = value ^ state->_previous;
+    state->_previous = value;
+    if (x == 0)
+        return cbin_bitwriter_write(bits, 1, 0);
+    unsigned leading = CLZ64(x) - (64 - width);
+    unsigned trailing = CTZ64(x);
+    if (leading >= state->_leading && trailing >= state->_trailing &&
+        state->_leading + state->_trailing != 0) {
+        unsigned length = width - state->_leading - state->_trailing;
+        return cbin_series_write2(bits, 2, cbin_series_prefix(bits, 2, 2),
+                                  length, x >> state->_trailing);
+    }
+    unsigned length = width - leading - trailing;
+    uint64_t stored = length & ((1u << field) - 1);
+    // The 11 prefix and both counts, in the order they are read back.
+    uint64_t header;
+    if (bits->_order == CBIN_BITS_MSB_FIRST)
+        header = (uint64_t)3 << (2 * field) | (uint64_t)leading << field |
+                 stored;
+    else
+        header = 3 | (uint64_t)leading << 2 | stored << (2 + field);
+    state->_leading = leading;
+    state->_trailing = trailing;
+    if (cbin_bitwriter_write(bits, 2 + 2 * field, header))
+        return bits->_writer->_error;
+    return cbin_bitwriter_write(bits, length, x >> trailing);
+}
+
+// Reads two consecutive fields written by cbin_series_write2.
+static inline cbin_err_t cbin_series_read2(cbin_bitreader_t *bits,
+                                           unsigned wa, uint64_t *a,
+                                           unsigned wb, uint64_t *b) {
+    uint64_t value;
+    if (cbin_bitreader_read(bits, wa + wb, &value))
+        return bits->_reader->_error;
+    if (bits->_order == CBIN_BITS_MSB_FIRST) {
+        *a = value >> wb;
+        *b = value & (((uint64_t)1 << wb) - 1);
+    } else {
+        *a = value & (((uint64_t)1 << wa) - 1);
+        *b = value >> wa;
+    }
+    return CBIN_ERR_OK;
+}
+
+static inline cbin_err_t cbin_xor_read(cbin_bitreader_t *bits,
+                                       cbin_xor_state_t *state,
+                                       uint64_t *value, unsigned width,
+                                       unsigned field) {
+    uint64_t bit;
+    if (CBIN_UNLIKELY(!state->_started)) {
+        if (cbin_bitreader_read(bits, width, value))
+            return bits->_reader->_error;
+        state->_started = true;
+        state->_previous = *value;
+        return CBIN_ERR_OK;
+    }
+    if (cbin_bitreader_read(bits, 1, &bit))
+        return bits->_reader->_error;
+    if (bit == 0) {
+        *value = state->_previous;
+        return CBIN_ERR_OK;
+    }
+    if (cbin_bitreader_read(bits, 1, &bit))
+        return bits->_reader->_error;
+    if (bit) {
+        uint64_t leading = 0, length = 0;
+        if (cbin_series_read2(bits, field, &leading, field, &length))
+            return bits->_reader->_error;
+        if (length == 0)
+            length = width;
+        if (leading + length > width)
+            return CBIN_ERROR(bits->_reader, CBIN_ERR_CORRUPT);
+        state->_leading = (unsigned)leading;
+        state->_trailing = width - (unsigned)(leading + length);
+    } else if (state->_leading + state->_trailing == 0) {
+        // The writer never reuses a window that was not set.
+        return CBIN_ERROR(bits->_reader, CBIN_ERR_CORRUPT);
+    }
+    uint64_t x;
+    if (cbin_bitreader_read(bits, width - state->_leading - state->_trailing,
+                            &x))
+        return bits->_reader->_error;
+    state->_previous ^= x << state->_trailing;
+    *value = state->_previous;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_bitwriter_write_xor_f64(cbin_bitwriter_t *bits,
+                                        cbin_xor_state_t *state,
+                                        double value) {
+    uint64_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return cbin_xor_write(bits, state, raw, 64, XOR64_FIELD);
+}
+
+cbin_err_t cbin_bitwriter_write_xor_f32(cbin_bitwriter_t *bits,
+                                        cbin_xor_state_t *state, float value) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return cbin_xor_write(bits, state, raw, 32, XOR32_FIELD);
+}
+
+cbin_err_t cbin_bitreader_read_xor_f64(cbin_bitreader_t *bits,
+                                       cbin_xor_state_t *state,
+                                       double *value) {
+    uint64_t raw;
+    if (cbin_xor_read(bits, state, &raw, 64, XOR64_FIELD))
+        return bits->_reader->_error;
+    memcpy(value, &raw, sizeof(raw));
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_bitreader_read_xor_f32(cbin_bitreader_t *bits,
+                                       cbin_xor_state_t *state, float *value) {
+    uint64_t raw;
+    if (cbin_xor_read(bits, state, &raw, 32, XOR32_FIELD))
+        return bits->_reader->_error;
+    uint32_t narrow = (uint32_t)raw;
+    memcpy(value, &narrow, sizeof(narrow));
+    return CBIN_ERR_OK;
+}
+
+static inline cbin_err_t cbin_dod_write(cbin_bitwriter_t *bits,
+                                        cbin_dod_state_t *state,
+                                        uint64_t value) {
+    if (CBIN_UNLIKELY(!state->_started)) {
+        state->_started = true;
+        state->_previous = value;
+        state->_delta = 0;
+        return cbin_bitwriter_write(bits, 64, value);
+    }
+    uint64_t delta = value - state->_previous;
+    uint64_t dod = delta - state->_delta;
+    state->_previous = value;
+    state->_delta = delta;
+    // Each range is biased so that its field holds a non-negative value.
+    if (dod == 0)
+        return cbin_bitwriter_write(bits, 1, 0);
+    if (dod + 63 < 128)
+        return cbin_series_write2(bits, 2, cbin_series_prefix(bits, 2, 2), 7,
+                                  dod + 63);
+    if (dod + 255 < 512)
+        return cbin_series_write2(bits, 3, cbin_series_prefix(bits, 6, 3), 9,
+                                  dod + 255);
+    if (dod + 2047 < 4096)
+        return cbin_series_write2(bits, 4, cbin_series_prefix(bits, 14, 4), 12,
+                                  dod + 2047);
+    return cbin_series_write2(bits, 4, 15, 64, dod);
+}
+
+static inline cbin_err_t cbin_dod_read(cbin_bitreader_t *bits,
+                                       cbin_dod_state_t *state,
+                                       uint64_t *value) {
+    if (CBIN_UNLIKELY(!state->_started)) {
+        if (cbin_bitreader_read(bits, 64, value))
+            return bits->_reader->_error;
+        state->_started = true;
+        state->_previous = *value;
+        state->_delta = 0;
+        return CBIN_ERR_OK;
+    }
+    // The prefix is a run of up to four 1 bits ended by a 0.
+    unsigned ones = 0;
+    uint64_t bit = 1;
+    while (ones < 4) {
+        if (cbin_bitreader_read(bits, 1, &bit))
+            return bits->_reader->_error;
+        if (!bit)
+            break;
+        ones++;
+    }
+    uint64_t dod = 0;
+    if (ones > 0) {
+        static const unsigned widths[4] = {7, 9, 12, 64};
+        static const uint64_t biases[4] = {63, 255, 2047, 0};
+        if (cbin_bitreader_read(bits, widths[ones - 1], &dod))
+            return bits->_reader->_error;
+        dod -= biases[ones - 1];
+    }
+    state->_delta += dod;
+    state->_previous += state->_delta;
+    *value = state->_previous;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_bitwriter_write_dod_i64(cbin_bitwriter_t *bits,
+                                        cbin_dod_state_t *state,
+                                        int64_t value) {
+    return cbin_dod_write(bits, state, (uint64_t)value);
+}
+
+cbin_err_t cbin_bitreader_read_dod_i64(cbin_bitreader_t *bits,
+                                       cbin_dod_state_t *state,
+                                       int64_t *value) {
+    uint64_t raw;
+    if (cbin_dod_read(bits, state, &raw))
+        return bits->_reader->_error;
+    *value = (int64_t)raw;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_write_xor_f64_array(cbin_writer_t *writer,
+                                    const double *values, size_t count) {
+    cbin_bitwriter_t bits;
+    cbin_xor_state_t state;
+    cbin_bitwriter_init(&bits, writer, CBIN_BITS_MSB_FIRST);
+    cbin_xor_state_init(&state);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t raw;
+        memcpy(&raw, &values[i], sizeof(raw));
+        if (cbin_xor_write(&bits, &state, raw, 64, XOR64_FIELD))
+            return writer->_error;
+    }
+    return cbin_bitwriter_finish(&bits);
+}
+
+cbin_err_t cbin_write_xor_f32_array(cbin_writer_t *writer,
+                                    const float *values, size_t count) {
+    cbin_bitwriter_t bits;
+    cbin_xor_state_t state;
+    cbin_bitwriter_init(&bits, writer, CBIN_BITS_MSB_FIRST);
+    cbin_xor_state_init(&state);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t raw;
+        memcpy(&raw, &values[i], sizeof(raw));
+        if (cbin_xor_write(&bits, &state, raw, 32, XOR32_FIELD))
+            return writer->_error;
+    }
+    return cbin_bitwriter_finish(&bits);
+}
+
+cbin_err_t cbin_write_dod_i64_array(cbin_writer_t *writer,
+                                    const int64_t *values, size_t count) {
+    cbin_bitwriter_t bits;
+    cbin_dod_state_t state;
+    cbin_bitwriter_init(&bits, writer, CBIN_BITS_MSB_FIRST);
+    cbin_dod_state_init(&state);
+    for (size_t i = 0; i < count; i++) {
+        if (cbin_dod_write(&bits, &state, (uint64_t)values[i]))
+            return writer->_error;
+    }
+    return cbin_bitwriter_finish(&bits);
+}
+
+// Loads the 57 or more bits following a bit position.
+static inline uint64_t cbin_series_peek(const uint8_t *data, size_t pos) {
+    return cbin_load_u64_be(data + (pos >> 3)) << (pos & 7);
+}
+
+// Consumes a field of 1 to 64 bits.
+static inline uint64_t cbin_series_take(const uint8_t *data, size_t *pos,
+                                        unsigned width) {
+    uint64_t value;
+    if (width <= 56) {
+        value = cbin_series_peek(data, *pos) >> (64 - width);
+    } else {
+        value = cbin_series_peek(data, *pos) >> 32 << (width - 32);
+        value |= cbin_series_peek(data, *pos + 32) >> (96 - width);
+    }
+    *pos += width;
+    return value;
+}
+
+static inline void cbin_series_store(void *values, size_t index,
+                                     uint64_t value, unsigned width) {
+    if (width == 64) {
+        memcpy((uint8_t *)values + index * 8, &value, 8);
+    } else {
+        uint32_t narrow = (uint32_t)value;
+        memcpy((uint8_t *)values + index * 4, &narrow, 4);
+    }
+}
+
+// Decodes samples of a started float series from the buffer until the
+// position reaches end, returning the index of the next sample.
+static inline size_t cbin_xor_decode(cbin_xor_state_t *state,
+                                     const uint8_t *data, size_t *position,
+                                     size_t end, void *values, size_t index,
+                                     size_t count, unsigned width,
+                                     unsigned field) {
+    uint64_t previous = state->_previous;
+    unsigned leading = state->_leading;
+    unsigned trailing = state->_trailing;
+    size_t pos = *position;
+    for (; index < count && pos < end; index++) {
+        uint64_t word = cbin_series_peek(data, pos);
+        if (word >> 63 == 0) {
+            pos++;
+        } else {
+            if (word >> 62 & 1) {
+                uint64_t mask = ((uint64_t)1 << field) - 1;
+                unsigned length =
+                    (unsigned)(word >> (62 - 2 * field) & mask);
+                leading = (unsigned)(word >> (62 - field) & mask);
+                if (length == 0)
+                    length = width;
+                if (leading + length > width)
+                    break;
+                trailing = width - leading - length;
+                pos += 2 + 2 * field;
+            } else {
+                if (leading + trailing == 0)
+                    break;
+                pos += 2;
+            }
+            previous ^= cbin_series_take(data, &pos,
+                                         width - leading - trailing)
+                        << trailing;
+        }
+        cbin_series_store(values, index, previous, width);
+    }
+    state->_previous = previous;
+    state->_leading = leading;
+    state->_trailing = trailing;
+    *position = pos;
+    return index;
+}
+
+// Decodes samples of a started timestamp series, see cbin_xor_decode.
+static inline size_t cbin_dod_decode(cbin_dod_state_t *state,
+                                     const uint8_t *data, size_t *position,
+                                     size_t end, int64_t *values,
+                                     size_t index, size_t count) {
+    uint64_t previous = state->_previous;
+    uint64_t delta = state->_delta;
+    size_t pos = *position;
+    for (; index < count && pos < end; index++) {
+        uint64_t word = cbin_series_peek(data, pos);
+        if (word >> 63 == 0) {
+            pos++;
+        } else if (word >> 62 == 2) {
+            delta += (word >> 55 & 0x7f) - 63;
+            pos += 9;
+        } else if (word >> 61 == 6) {
+            delta += (word >> 52 & 0x1ff) - 255;
+            pos += 12;
+        } else if (word >> 60 == 14) {
+            delta += (word >> 48 & 0xfff) - 2047;
+            pos += 16;
+        } else {
+            pos += 4;
+            delta += cbin_series_take(data, &pos, 64);
+        }
+        previous += delta;
+        values[index] = (int64_t)previous;
+    }
+    state->_previous = previous;
+    state->_delta = delta;
+    *position = pos;
+    return index;
+}
+
+// Reads the samples of an array, straight from the buffer while enough
+// bytes are left in it and one at a time through a bit reader otherwise.
+// shift counts the bits of the byte at the position already consumed.
+static inline cbin_err_t cbin_series_read_array(cbin_reader_t *reader, bool dod,
+                                         void *values, size_t count,
+                                         unsigned width, unsigned field) {
+    cbin_xor_state_t xor_state;
+    cbin_dod_state_t dod_state;
+    size_t index = 0;
+    unsigned shift = 0;
+    if (reader->_error)
+        return reader->_error;
+    cbin_xor_state_init(&xor_state);
+    cbin_dod_state_init(&dod_state);
+    while (index < count) {
+        size_t available = reader->_size - reader->_position;
+        bool started = dod ? dod_state._started : xor_state._started;
+        if (started && available > SERIES_MARGIN) {
+            const uint8_t *data =
+                (const uint8_t *)reader->_buffer + reader->_position;
+            size_t pos = shift;
+            size_t end = (available - SERIES_MARGIN) * 8;
+            index = dod ? cbin_dod_decode(&dod_state, data, &pos, end,
+                                          (int64_t *)values, index, count)
+                        : cbin_xor_decode(&xor_state, data, &pos, end,
+                                          values, index, count, width,
+                                          field);
+            reader->_position += pos >> 3;
+            shift = pos & 7;
+            if (index == count)
+                break;
+        }
+        // The first sample, the end of the buffer, or a malformed sample
+        // left for the checked decoder to report.
+        cbin_bitreader_t bits;
+        uint64_t raw;
+        cbin_bitreader_init(&bits, reader, CBIN_BITS_MSB_FIRST);
+        if (shift && cbin_bitreader_read(&bits, shift, NULL))
+            return reader->_error;
+        if (dod ? cbin_dod_read(&bits, &dod_state, &raw)
+                : cbin_xor_read(&bits, &xor_state, &raw, width, field))
+            return reader->_error;
+        cbin_series_store(values, index++, raw, width);
+        // The bytes read ahead are still in the buffer, as for
+        // cbin_bitreader_finish.
+        size_t pos = reader->_position * 8 - bits._count;
+        reader->_position = pos >> 3;
+        shift = pos & 7;
+    }
+    if (shift)
+        reader->_position++;
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_read_xor_f64_array(cbin_reader_t *reader, double *values,
+                                   size_t count) {
+    return cbin_series_read_array(reader, false, values, count, 64,
+                                  XOR64_FIELD);
+}
+
+cbin_err_t cbin_read_xor_f32_array(cbin_reader_t *reader, float *values,
+                                   size_t count) {
+    return cbin_series_read_array(reader, false, values, count, 32,
+                                  XOR32_FIELD);
+}
+
+cbin_err_t cbin_read_dod_i64_array(cbin_reader_t *reader, int64_t *values,
+                                   size_t count) {
+    return cbin_series_read_array(reader, true, values, count, 64, 0);
+}
@@ -0,0 +1,121 @@
+#ifndef CBIN_SRC_CBIN_SERIES_H
+#define CBIN_SRC_CBIN_SERIES_H
+#include "bits.h"
+#include "common.h"
+
+// Time series codecs of the Gorilla paper, over a bit stream:
+//
+// - Floats are XORed with the previous sample. An unchanged value takes a
+//   single 0 bit, otherwise the meaningful bits of the XOR are written
+//   either inside the window of leading and trailing zeros of the previous
+//   one (prefix 10), or with a new window (prefix 11, then the number of
+//   leading zeros and of meaningful bits).
+// - Timestamps, or any slowly drifting integer, store the difference of
+//   consecutive deltas: 0 for a regular interval, then 10, 110 and 1110
+//   for 7, 9 and 12-bit differences, and 1111 with the 64-bit difference.
+//
+// The first sample is written in full. Both codecs keep their state in a
+// small struct, so samples can be appended one at a time or as arrays.
+
+/// The state of the XOR float codec, one per series.
+typedef struct cbin_xor_state_s {
+    uint64_t _previous;
+    unsigned _leading;
+    unsigned _trailing;
+    bool _started;
+} cbin_xor_state_t;
+
+/// The state of the delta-of-delta codec, one per series.
+typedef struct cbin_dod_state_s {
+    uint64_t _previous;
+    uint64_t _delta;
+    bool _started;
+} cbin_dod_state_t;
+
+CBIN_HEADER_BEGIN
+
+/// Initializes the state of a float series, before its first sample.
+/// \param state The state to initialize.
+void cbin_xor_state_init(cbin_xor_state_t *state);
+
+/// Initializes the state of a timestamp series, before its first sample.
+/// \param state The state to initialize.
+void cbin_dod_state_init(cbin_dod_state_t *state);
+
+/// Writes the next sample of a float series.
+/// \param bits The bit writer to write to.
+/// \param state The state of the series.
+/// \param value The sample to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_bitwriter_write_xor_f64(cbin_bitwriter_t *bits,
+                                        cbin_xor_state_t *state,
+                                        double value);
+cbin_err_t cbin_bitwriter_write_xor_f32(cbin_bitwriter_t *bits,
+                                        cbin_xor_state_t *state, float value);
+
+/// Reads the next sample of a float series.
+/// \param bits The bit reader to read from.
+/// \param state The state of the series.
+/// \param value The value to read into.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_bitreader_read_xor_f64(cbin_bitreader_t *bits,
+                                       cbin_xor_state_t *state,
+                                       double *value);
+cbin_err_t cbin_bitreader_read_xor_f32(cbin_bitreader_t *bits,
+                                       cbin_xor_state_t *state, float *value);
+
+/// Writes the next sample of a timestamp series. Differences wrap around,
+/// so any sequence of values round-trips.
+/// \param bits The bit writer to write to.
+/// \param state The state of the series.
+/// \param value The sample to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_bitwriter_write_dod_i64(cbin_bitwriter_t *bits,
+                                        cbin_dod_state_t *state,
+                                        int64_t value);
+
+/// Reads the next sample of a timestamp series.
+/// \param bits The bit reader to read from.
+/// \param state The state of the series.
+/// \param value The value to read into.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_bitreader_read_dod_i64(cbin_bitreader_t *bits,
+                                       cbin_dod_state_t *state,
+                                       int64_t *value);
+
+/// Writes an array as a whole series, most significant bit first and padded
+/// to a byte. The count is not stored, it has to be known to the reader.
+/// \param writer The writer to write to.
+/// \param values The values to write.
+/// \param count The number of values to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_xor_f64_array(cbin_writer_t *writer,
+                                    const double *values, size_t count);
+cbin_err_t cbin_write_xor_f32_array(cbin_writer_t *writer,
+                                    const float *values, size_t count);
+cbin_err_t cbin_write_dod_i64_array(cbin_writer_t *writer,
+                                    const int64_t *values, size_t count);
+
+/// Reads an array written by the matching array writer.
+/// \param reader The reader to read from.
+/// \param values The array to read into.
+/// \param count The number of values to read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_read_xor_f64_array(cbin_reader_t *reader, double *values,
+                                   size_t count);
+cbin_err_t cbin_read_xor_f32_array(cbin_reader_t *reader, float *values,
+                                   size_t count);
+cbin_err_t cbin_read_dod_i64_array(cbin_reader_t *reader, int64_t *values,
+                                   size_t count);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_SERIES_H
@@ -0,0 +1,52 @@
+#include "stats.h"
+#include "thread.h"
+
+// Every field of the registry is a uint64_t, so it is updated as an array
+// of atomic counters.
+#define STATS_FIELDS (sizeof(cbin_stats_t) / sizeof(uint64_t))
+
+static cbin_stats_t g_stats;
+
+static inline void cbin_stats_add(uint64_t *field, uint64_t value) {
+    if (value)
+        cbin_atomic_add_u64(field, value);
+}
+
+static size_t cbin_stats_bucket(uint64_t capacity) {
+    size_t bucket = 0;
+    while (bucket + 1 < CBIN_STATS_BUCKETS &&
+           ((uint64_t)1 << bucket) < capacity)
+        bucket++;
+    return bucket;
+}
+
+void cbin_stats_publish_writer(const cbin_writer_stats_t *stats) {
+    cbin_stats_add(&g_stats.writers, 1);
+    cbin_stats_add(&g_stats.grow_count, stats->grow_count);
+    cbin_stats_add(&g_stats.grow_bytes_copied, stats->grow_bytes_copied);
+    cbin_stats_add(&g_stats.bytes_written, stats->bytes_written);
+    cbin_stats_add(&g_stats.flush_count, stats->flush_count);
+    cbin_stats_add(&g_stats.writer_seeks, stats->seek_count);
+    cbin_stats_add(&g_stats.writer_errors, stats->first_error.code != 0);
+    cbin_stats_add(
+        &g_stats.peak_capacity[cbin_stats_bucket(stats->peak_capacity)], 1);
+}
+void cbin_stats_publish_reader(const cbin_reader_stats_t *stats) {
+    cbin_stats_add(&g_stats.readers, 1);
+    cbin_stats_add(&g_stats.bytes_read, stats->bytes_read);
+    cbin_stats_add(&g_stats.refill_count, stats->refill_count);
+    cbin_stats_add(&g_stats.bytes_refilled, stats->bytes_refilled);
+    cbin_stats_add(&g_stats.reader_seeks, stats->seek_count);
+    cbin_stats_add(&g_stats.reader_errors, stats->first_error.code != 0);
+}
+void cbin_stats_snapshot(cbin_stats_t *stats) {
+    uint64_t *from = (uint64_t *)&g_stats;
+    uint64_t *to = (uint64_t *)stats;
+    for (size_t i = 0; i < STATS_FIELDS; i++)
+        to[i] = cbin_atomic_load_u64(&from[i]);
+}
+void cbin_stats_reset(void) {
+    uint64_t *fields = (uint64_t *)&g_stats;
+    for (size_t i = 0; i < STATS_FIELDS; i++)
+        cbin_atomic_store_u64(&fields[i], 0);
+}
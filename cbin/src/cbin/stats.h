@@ -0,0 +1,119 @@
+#ifndef CBIN_SRC_CBIN_STATS_H
+#define CBIN_SRC_CBIN_STATS_H
+#include "common.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Instrumentation counters of readers and writers, compiled in by defining
+// CBIN_STATS (the CBIN_STATS CMake option) for the library and its users
+// alike. Without it readers and writers carry no counters and every hook
+// compiles to nothing. Counters cover the checked API, the unchecked
+// accessors are not counted.
+
+/// Where the first error of a reader or writer was raised.
+typedef struct cbin_error_site_s {
+    /// The error, CBIN_ERR_OK if none was raised.
+    cbin_err_t code;
+    const char *file;
+    int line;
+    const char *function;
+} cbin_error_site_t;
+
+/// The counters of a writer.
+typedef struct cbin_writer_stats_s {
+    /// Buffer reallocations and chunks allocated to make room.
+    uint64_t grow_count;
+    /// Bytes moved to another buffer while growing.
+    uint64_t grow_bytes_copied;
+    /// The largest capacity of the buffer.
+    uint64_t peak_capacity;
+    uint64_t bytes_written;
+    /// Buffers handed to the sink of a flushing writer.
+    uint64_t flush_count;
+    uint64_t seek_count;
+    cbin_error_site_t first_error;
+} cbin_writer_stats_t;
+
+/// The counters of a reader.
+typedef struct cbin_reader_stats_s {
+    /// Bytes consumed, skipped ones included.
+    uint64_t bytes_read;
+    /// Calls to the refill callback of a streaming reader.
+    uint64_t refill_count;
+    uint64_t bytes_refilled;
+    uint64_t seek_count;
+    cbin_error_site_t first_error;
+} cbin_reader_stats_t;
+
+/// The number of buckets of the peak capacity histogram.
+#define CBIN_STATS_BUCKETS 48
+
+/// The counters of every reader and writer published so far.
+typedef struct cbin_stats_s {
+    uint64_t writers;
+    uint64_t grow_count;
+    uint64_t grow_bytes_copied;
+    uint64_t bytes_written;
+    uint64_t flush_count;
+    uint64_t writer_seeks;
+    uint64_t writer_errors;
+    uint64_t readers;
+    uint64_t bytes_read;
+    uint64_t refill_count;
+    uint64_t bytes_refilled;
+    uint64_t reader_seeks;
+    uint64_t reader_errors;
+    /// Writers by peak capacity: bucket i counts the peaks in
+    /// (2^(i-1), 2^i], the last bucket also counts every larger peak.
+    uint64_t peak_capacity[CBIN_STATS_BUCKETS];
+} cbin_stats_t;
+
+#if defined(CBIN_STATS)
+#    define CBIN_STAT_ADD(stream, field, value)                                \
+        ((stream)->_stats.field += (value))
+#    define CBIN_ERROR(stream, err)                                            \
+        cbin_stats_error(&(stream)->_error, &(stream)->_stats.first_error,     \
+                         (err), __FILE__, __LINE__, __func__)
+#else
+#    define CBIN_STAT_ADD(stream, field, value) ((void)0)
+#    define CBIN_ERROR(stream, err) ((stream)->_error = (err))
+#endif
+
+CBIN_HEADER_BEGIN
+
+#if defined(CBIN_STATS)
+// Sets the error of a stream, recording where the first one was raised.
+static inline cbin_err_t cbin_stats_error(cbin_err_t *error,
+                                          cbin_error_site_t *site,
+                                          cbin_err_t err, const char *file,
+                                          int line, const char *function) {
+    if (err && !site->code) {
+        site->code = err;
+        site->file = file;
+        site->line = line;
+        site->function = function;
+    }
+    return *error = err;
+}
+#endif
+
+/// Adds the counters of a writer to the global registry.
+/// \param stats The counters to add.
+void cbin_stats_publish_writer(const cbin_writer_stats_t *stats);
+
+/// Adds the counters of a reader to the global registry.
+/// \param stats The counters to add.
+void cbin_stats_publish_reader(const cbin_reader_stats_t *stats);
+
+/// Copies the global registry. Readers and writers are published when
+/// destroyed, when a writer goes back to its pool, or explicitly. Without
+/// CBIN_STATS every counter stays 0.
+/// \param stats Receives the counters.
+void cbin_stats_snapshot(cbin_stats_t *stats);
+
+/// Clears the global registry.
+void cbin_stats_reset(void);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_STATS_H
@@ -0,0 +1,312 @@
+#ifndef CBIN_SRC_CBIN_THREAD_H
+#define CBIN_SRC_CBIN_THREAD_H
+#include "common.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Thin portability layer over the platform threading primitives.
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+typedef SRWLOCK cbin_mutex_t;
+typedef CONDITION_VARIABLE cbin_cond_t;
+typedef DWORD cbin_tls_t;
+typedef HANDLE cbin_thread_t;
+// Thread-local destructors are fiber-local callbacks on Windows.
+#    define CBIN_TLS_CALL NTAPI
+#else
+#    include <pthread.h>
+#    include <sched.h>
+#    include <unistd.h>
+typedef pthread_mutex_t cbin_mutex_t;
+typedef pthread_cond_t cbin_cond_t;
+typedef pthread_key_t cbin_tls_t;
+typedef pthread_t cbin_thread_t;
+#    define CBIN_TLS_CALL
+#endif
+
+/// Called with the value of a thread-local slot when its thread exits.
+typedef void(CBIN_TLS_CALL *cbin_tls_destructor_fn)(void *value);
+
+/// The entry point of a thread started by cbin_thread_create.
+typedef void (*cbin_thread_fn)(void *arg);
+
+// Threads start through a trampoline so that both platforms share the
+// same entry point signature.
+typedef struct cbin_thread_start_s {
+    cbin_thread_fn fn;
+    void *arg;
+} cbin_thread_start_t;
+
+CBIN_HEADER_BEGIN
+
+#if defined(_WIN32)
+
+static inline void cbin_mutex_init(cbin_mutex_t *mutex) {
+    InitializeSRWLock(mutex);
+}
+static inline void cbin_mutex_destroy(cbin_mutex_t *mutex) { (void)mutex; }
+static inline void cbin_mutex_lock(cbin_mutex_t *mutex) {
+    AcquireSRWLockExclusive(mutex);
+}
+static inline void cbin_mutex_unlock(cbin_mutex_t *mutex) {
+    ReleaseSRWLockExclusive(mutex);
+}
+
+static inline void cbin_cond_init(cbin_cond_t *cond) {
+    InitializeConditionVariable(cond);
+}
+static inline void cbin_cond_destroy(cbin_cond_t *cond) { (void)cond; }
+static inline void cbin_cond_wait(cbin_cond_t *cond, cbin_mutex_t *mutex) {
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+static inline void cbin_cond_broadcast(cbin_cond_t *cond) {
+    WakeAllConditionVariable(cond);
+}
+
+static inline bool cbin_tls_create(cbin_tls_t *key,
+                                   cbin_tls_destructor_fn destructor) {
+    *key = FlsAlloc(destructor);
+    return *key != FLS_OUT_OF_INDEXES;
+}
+static inline void cbin_tls_delete(cbin_tls_t key) { FlsFree(key); }
+static inline void *cbin_tls_get(cbin_tls_t key) { return FlsGetValue(key); }
+static inline bool cbin_tls_set(cbin_tls_t key, void *value) {
+    return FlsSetValue(key, value) != 0;
+}
+
+static inline DWORD WINAPI cbin_thread_trampoline(LPVOID param) {
+    cbin_thread_start_t start = *(cbin_thread_start_t *)param;
+    CBIN_FREE(param);
+    start.fn(start.arg);
+    return 0;
+}
+static inline bool cbin_thread_create(cbin_thread_t *thread,
+                                      cbin_thread_fn fn, void *arg) {
+    cbin_thread_start_t *start =
+        (cbin_thread_start_t *)CBIN_REALLOC(NULL, sizeof(*start));
+    if (!start)
+        return false;
+    start->fn = fn;
+    start->arg = arg;
+    *thread = CreateThread(NULL, 0, cbin_thread_trampoline, start, 0, NULL);
+    if (!*thread) {
+        CBIN_FREE(start);
+        return false;
+    }
+    return true;
+}
+static inline void cbin_thread_join(cbin_thread_t thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+static inline void cbin_thread_yield(void) { SwitchToThread(); }
+static inline size_t cbin_thread_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+static inline void cbin_mutex_init(cbin_mutex_t *mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+static inline void cbin_mutex_destroy(cbin_mutex_t *mutex) {
+    pthread_mutex_destroy(mutex);
+}
+static inline void cbin_mutex_lock(cbin_mutex_t *mutex) {
+    pthread_mutex_lock(mutex);
+}
+static inline void cbin_mutex_unlock(cbin_mutex_t *mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+static inline void cbin_cond_init(cbin_cond_t *cond) {
+    pthread_cond_init(cond, NULL);
+}
+static inline void cbin_cond_destroy(cbin_cond_t *cond) {
+    pthread_cond_destroy(cond);
+}
+static inline void cbin_cond_wait(cbin_cond_t *cond, cbin_mutex_t *mutex) {
+    pthread_cond_wait(cond, mutex);
+}
+static inline void cbin_cond_broadcast(cbin_cond_t *cond) {
+    pthread_cond_broadcast(cond);
+}
+
+static inline bool cbin_tls_create(cbin_tls_t *key,
+                                   cbin_tls_destructor_fn destructor) {
+    return pthread_key_create(key, destructor) == 0;
+}
+static inline void cbin_tls_delete(cbin_tls_t key) { pthread_key_delete(key); }
+static inline void *cbin_tls_get(cbin_tls_t key) {
+    return pthread_getspecific(key);
+}
+static inline bool cbin_tls_set(cbin_tls_t key, void *value) {
+    return pthread_setspecific(key, value) == 0;
+}
+
+static inline void *cbin_thread_trampoline(void *param) {
+    cbin_thread_start_t start = *(cbin_thread_start_t *)param;
+    CBIN_FREE(param);
+    start.fn(start.arg);
+    return NULL;
+}
+static inline bool cbin_thread_create(cbin_thread_t *thread,
+                                      cbin_thread_fn fn, void *arg) {
+    cbin_thread_start_t *start =
+        (cbin_thread_start_t *)CBIN_REALLOC(NULL, sizeof(*start));
+    if (!start)
+        return false;
+    start->fn = fn;
+    start->arg = arg;
+    if (pthread_create(thread, NULL, cbin_thread_trampoline, start) != 0) {
+        CBIN_FREE(start);
+        return false;
+    }
+    return true;
+}
+static inline void cbin_thread_join(cbin_thread_t thread) {
+    pthread_join(thread, NULL);
+}
+static inline void cbin_thread_yield(void) { sched_yield(); }
+static inline size_t cbin_thread_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+#endif
+
+// Relaxed atomics, enough for work counters and stop flags whose results
+// are published by joining the threads.
+#if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+static inline size_t cbin_atomic_fetch_add(volatile size_t *value,
+                                           size_t add) {
+#    if defined(_WIN64)
+    return (size_t)_InterlockedExchangeAdd64((volatile __int64 *)value,
+                                             (__int64)add);
+#    else
+    return (size_t)_InterlockedExchangeAdd((volatile long *)value,
+                                           (long)add);
+#    endif
+}
+static inline int cbin_atomic_load(volatile int *value) {
+    return _InterlockedOr((volatile long *)value, 0);
+}
+static inline size_t cbin_atomic_load_size(volatile size_t *value) {
+    return cbin_atomic_fetch_add(value, 0);
+}
+static inline bool cbin_atomic_cas_size(volatile size_t *value,
+                                        size_t expected, size_t desired) {
+#    if defined(_WIN64)
+    return (size_t)_InterlockedCompareExchange64(
+               (volatile __int64 *)value, (__int64)desired,
+               (__int64)expected) == expected;
+#    else
+    return (size_t)_InterlockedCompareExchange(
+               (volatile long *)value, (long)desired, (long)expected) ==
+           expected;
+#    endif
+}
+static inline int cbin_atomic_cas(volatile int *value, int expected,
+                                  int desired) {
+    return _InterlockedCompareExchange((volatile long *)value, desired,
+                                       expected) == expected;
+}
+static inline void cbin_atomic_add_u64(volatile uint64_t *value,
+                                       uint64_t add) {
+    _InterlockedExchangeAdd64((volatile __int64 *)value, (__int64)add);
+}
+static inline uint64_t cbin_atomic_load_u64(volatile uint64_t *value) {
+    return (uint64_t)_InterlockedOr64((volatile __int64 *)value, 0);
+}
+static inline void cbin_atomic_store_u64(volatile uint64_t *value,
+                                         uint64_t desired) {
+    _InterlockedExchange64((volatile __int64 *)value, (__int64)desired);
+}
+// Function pointers do not convert to void *, they are loaded and stored
+// through their own volatile type, which is a single access when aligned.
+#    define cbin_atomic_load_fn(value) (*(value))
+#    define cbin_atomic_store_fn(value, desired) ((void)(*(value) = (desired)))
+#else
+static inline size_t cbin_atomic_fetch_add(volatile size_t *value,
+                                           size_t add) {
+    return __atomic_fetch_add(value, add, __ATOMIC_RELAXED);
+}
+static inline int cbin_atomic_load(volatile int *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+static inline size_t cbin_atomic_load_size(volatile size_t *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+static inline bool cbin_atomic_cas_size(volatile size_t *value,
+                                        size_t expected, size_t desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+static inline int cbin_atomic_cas(volatile int *value, int expected,
+                                  int desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+static inline void cbin_atomic_add_u64(volatile uint64_t *value,
+                                       uint64_t add) {
+    __atomic_fetch_add(value, add, __ATOMIC_RELAXED);
+}
+static inline uint64_t cbin_atomic_load_u64(volatile uint64_t *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+static inline void cbin_atomic_store_u64(volatile uint64_t *value,
+                                         uint64_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELAXED);
+}
+// Function pointers do not convert to void *, the builtins take any type.
+#    define cbin_atomic_load_fn(value) __atomic_load_n(value, __ATOMIC_RELAXED)
+#    define cbin_atomic_store_fn(value, desired)                              \
+        __atomic_store_n(value, desired, __ATOMIC_RELAXED)
+#endif
+
+// Acquire and release atomics, for positions and flags that publish the
+// memory written before them to another thread.
+#if defined(_MSC_VER) && !defined(__clang__)
+static inline size_t cbin_atomic_load_acquire(volatile size_t *value) {
+    return cbin_atomic_fetch_add(value, 0);
+}
+static inline void cbin_atomic_store_release(volatile size_t *value,
+                                             size_t desired) {
+#    if defined(_WIN64)
+    _InterlockedExchange64((volatile __int64 *)value, (__int64)desired);
+#    else
+    _InterlockedExchange((volatile long *)value, (long)desired);
+#    endif
+}
+static inline uint32_t cbin_atomic_load_acquire_u32(volatile uint32_t *value) {
+    return (uint32_t)_InterlockedOr((volatile long *)value, 0);
+}
+static inline void cbin_atomic_store_release_u32(volatile uint32_t *value,
+                                                 uint32_t desired) {
+    _InterlockedExchange((volatile long *)value, (long)desired);
+}
+#else
+static inline size_t cbin_atomic_load_acquire(volatile size_t *value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+static inline void cbin_atomic_store_release(volatile size_t *value,
+                                             size_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+}
+static inline uint32_t cbin_atomic_load_acquire_u32(volatile uint32_t *value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+static inline void cbin_atomic_store_release_u32(volatile uint32_t *value,
+                                                 uint32_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+}
+#endif
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_THREAD_H
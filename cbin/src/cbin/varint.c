@@ -0,0 +1,930 @@
+#include "varint.h"
+#include "cpu.h"
+
+#if defined(CBIN_HAVE_DISPATCH)
+#    include <immintrin.h>
+#endif
+#if defined(CBIN_ARCH_NEON) && defined(__aarch64__)
+#    include <arm_neon.h>
+#endif
+
+static size_t cbin_varint_encode(uint8_t *out, uint64_t value) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        out[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = (uint8_t)value;
+    return size;
+}
+
+// Decodes a varint of up to 8 bytes from a full 8-byte load, without a loop:
+// the terminator is found with a bit scan and the 7-bit groups are packed
+// together with a fixed sequence of shifts. Longer varints return 0.
+static size_t cbin_varint_decode8(const uint8_t *in, uint64_t *value) {
+    uint64_t word = cbin_load_u64_le(in);
+    uint64_t stops = ~word & 0x8080808080808080ull;
+    if (CBIN_UNLIKELY(stops == 0))
+        return 0;
+#if defined(__GNUC__) || defined(__clang__)
+    size_t size = (size_t)__builtin_ctzll(stops) / 8 + 1;
+#else
+    size_t size = 1;
+    while (!(stops & 0x80))
+        stops >>= 8, size++;
+#endif
+    if (size < 8)
+        word &= (1ull << (size * 8)) - 1;
+    *value = (word & 0x7full) | ((word >> 1) & (0x7full << 7)) |
+             ((word >> 2) & (0x7full << 14)) |
+             ((word >> 3) & (0x7full << 21)) |
+             ((word >> 4) & (0x7full << 28)) |
+             ((word >> 5) & (0x7full << 35)) |
+             ((word >> 6) & (0x7full << 42)) |
+             ((word >> 7) & (0x7full << 49));
+    return size;
+}
+
+// Decodes a complete varint from a buffer of at least CBIN_VARINT_MAX bytes.
+static size_t cbin_varint_decode(const uint8_t *in, uint64_t *value) {
+    size_t size = cbin_varint_decode8(in, value);
+    if (CBIN_LIKELY(size))
+        return size;
+    uint64_t result = 0;
+    for (size = 0; size < CBIN_VARINT_MAX; size++) {
+        uint64_t byte = in[size];
+        result |= (byte & 0x7f) << (7 * size);
+        if (!(byte & 0x80)) {
+            // The tenth byte only has room for the top bit.
+            if (size == CBIN_VARINT_MAX - 1 && byte > 1)
+                return 0;
+            *value = result;
+            return size + 1;
+        }
+    }
+    return 0;
+}
+
+cbin_err_t cbin_write_varu64(cbin_writer_t *writer, uint64_t value) {
+    uint8_t buffer[CBIN_VARINT_MAX];
+    return cbin_write(writer, buffer, cbin_varint_encode(buffer, value));
+}
+cbin_err_t cbin_write_vari64(cbin_writer_t *writer, int64_t value) {
+    return cbin_write_varu64(writer, cbin_zigzag_encode(value));
+}
+
+cbin_err_t cbin_read_varu64(cbin_reader_t *reader, uint64_t *value) {
+    if (reader->_error)
+        return reader->_error;
+    uint64_t result;
+    if (CBIN_LIKELY(reader->_size - reader->_position >= CBIN_VARINT_MAX)) {
+        size_t size = cbin_varint_decode(
+            (const uint8_t *)reader->_buffer + reader->_position, &result);
+        if (!size)
+            return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+        reader->_position += size;
+    } else {
+        // Near the end of the buffer (or window), one byte at a time.
+        result = 0;
+        for (size_t i = 0;; i++) {
+            uint8_t byte;
+            if (i == CBIN_VARINT_MAX)
+                return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+            if (cbin_read_u8(reader, &byte))
+                return reader->_error;
+            result |= (uint64_t)(byte & 0x7f) << (7 * i);
+            if (!(byte & 0x80)) {
+                if (i == CBIN_VARINT_MAX - 1 && byte > 1)
+                    return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+                break;
+            }
+        }
+    }
+    if (value)
+        *value = result;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_read_vari64(cbin_reader_t *reader, int64_t *value) {
+    uint64_t result = 0;
+    if (cbin_read_varu64(reader, &result))
+        return reader->_error;
+    if (value)
+        *value = cbin_zigzag_decode(result);
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_write_varu64_array(cbin_writer_t *writer,
+                                   const uint64_t *values, size_t count) {
+    // Encodes in runs through a stack buffer so each run is a single write.
+    uint8_t buffer[64 * CBIN_VARINT_MAX];
+    while (count > 0) {
+        size_t run = count < 64 ? count : 64;
+        size_t size = 0;
+        for (size_t i = 0; i < run; i++)
+            size += cbin_varint_encode(buffer + size, values[i]);
+        if (cbin_write(writer, buffer, size))
+            return writer->_error;
+        values += run;
+        count -= run;
+    }
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_write_vari64_array(cbin_writer_t *writer,
+                                   const int64_t *values, size_t count) {
+    uint8_t buffer[64 * CBIN_VARINT_MAX];
+    while (count > 0) {
+        size_t run = count < 64 ? count : 64;
+        size_t size = 0;
+        for (size_t i = 0; i < run; i++)
+            size += cbin_varint_encode(buffer + size,
+                                       cbin_zigzag_encode(values[i]));
+        if (cbin_write(writer, buffer, size))
+            return writer->_error;
+        values += run;
+        count -= run;
+    }
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_read_varu64_array(cbin_reader_t *reader, uint64_t *values,
+                                  size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (reader->_error)
+            return reader->_error;
+        const uint8_t *buffer = (const uint8_t *)reader->_buffer;
+        size_t position = reader->_position;
+        // Decode straight from the buffer while a worst case value fits.
+        while (i < count && reader->_size - position >= CBIN_VARINT_MAX) {
+            uint64_t value;
+            size_t size = cbin_varint_decode(buffer + position, &value);
+            if (!size) {
+                reader->_position = position;
+                return CBIN_ERROR(reader, CBIN_ERR_CORRUPT);
+            }
+            if (values)
+                values[i] = value;
+            position += size;
+            i++;
+        }
+        reader->_position = position;
+        if (i < count && cbin_read_varu64(reader, values ? &values[i] : NULL))
+            return reader->_error;
+    }
+    return reader->_error;
+}
+cbin_err_t cbin_read_vari64_array(cbin_reader_t *reader, int64_t *values,
+                                  size_t count) {
+    // Zigzag decoding is done in place on the unsigned values.
+    if (cbin_read_varu64_array(reader, (uint64_t *)values, count))
+        return reader->_error;
+    if (values) {
+        for (size_t i = 0; i < count; i++)
+            values[i] = cbin_zigzag_decode((uint64_t)values[i]);
+    }
+    return CBIN_ERR_OK;
+}
+
+// Stream VByte: every value takes 1 to 4 bytes, with the lengths kept apart
+// in control bytes (2 bits per value) so that four values can be decoded
+// with one table-driven byte shuffle.
+
+// Shuffle masks expanding the data bytes of four values, indexed by their
+// control byte.
+static const uint8_t svb_shuffle[256][16] = {
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0xff, 0xff, 0xff, 0x03, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0xff, 0xff, 0xff, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0xff, 0xff, 0x04, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0xff, 0xff, 0x0a, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0xff, 0x05, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0xff, 0x0b, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0x05, 0x06, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0xff, 0xff, 0xff, 0x03, 0x04, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0x05, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0x05, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0xff, 0xff, 0xff, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0xff, 0xff, 0x04, 0x05, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0x06, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0x06, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0xff, 0xff, 0x0a, 0x0b, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0xff, 0x05, 0x06, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0x0b, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0x0b, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0xff, 0x0b, 0x0c, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0xff, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0xff, 0xff, 0xff, 0x03, 0x04, 0x05, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0x05, 0x06, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0x07, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0x05, 0x06, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0x07, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0x07, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0xff, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0xff, 0xff, 0x04, 0x05, 0x06, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0x06, 0x07, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0x06, 0x07, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0xff, 0xff, 0x0a, 0x0b, 0x0c, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0xff, 0x05, 0x06, 0x07, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0x0b, 0x0c, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0x0b, 0x0c, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0xff, 0x0b, 0x0c, 0x0d, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0xff},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0xff},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0xff, 0xff, 0xff, 0x03, 0x04, 0x05, 0x06},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0x05, 0x06, 0x07},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0x07, 0x08},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0xff, 0xff, 0xff, 0x04, 0x05, 0x06, 0x07},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0x07, 0x08},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0xff, 0xff, 0xff, 0x05, 0x06, 0x07, 0x08},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0xff, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0xff, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0xff, 0xff, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0xff, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0xff, 0xff, 0x04, 0x05, 0x06, 0x07},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0x06, 0x07, 0x08},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0xff, 0xff, 0x05, 0x06, 0x07, 0x08},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0xff, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0xff, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0xff, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0xff, 0xff, 0x0a, 0x0b, 0x0c, 0x0d},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0xff, 0x05, 0x06, 0x07, 0x08},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0xff, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0xff, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0x0b, 0x0c, 0x0d},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0xff, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0xff, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0xff, 0x0a, 0x0b, 0x0c, 0x0d},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0xff, 0x0b, 0x0c, 0x0d, 0x0e},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff,
+     0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0xff, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0xff, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0xff, 0xff,
+     0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0xff, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0xff, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0xff, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0xff,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0xff,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0xff,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xff,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e},
+    {0x00, 0xff, 0xff, 0xff, 0x01, 0x02, 0x03, 0x04,
+     0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c},
+    {0x00, 0x01, 0xff, 0xff, 0x02, 0x03, 0x04, 0x05,
+     0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d},
+    {0x00, 0x01, 0x02, 0xff, 0x03, 0x04, 0x05, 0x06,
+     0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+};
+
+// Number of data bytes described by each control byte.
+static const uint8_t svb_length[256] = {
+    4, 5, 6, 7, 5, 6, 7, 8, 6, 7, 8, 9, 7, 8, 9, 10, 5, 6, 7, 8, 6, 7, 8, 9, 7,
+    8, 9, 10, 8, 9, 10, 11, 6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11,
+    12, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 5, 6, 7, 8, 6,
+    7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11, 6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11,
+    9, 10, 11, 12, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 8,
+    9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14, 6, 7, 8, 9, 7, 8,
+    9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11,
+    12, 10, 11, 12, 13, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13,
+    14, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14, 12, 13, 14, 15, 7, 8, 9,
+    10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 8, 9, 10, 11, 9, 10, 11,
+    12, 10, 11, 12, 13, 11, 12, 13, 14, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12,
+    13, 14, 12, 13, 14, 15, 10, 11, 12, 13, 11, 12, 13, 14, 12, 13, 14, 15, 13,
+    14, 15, 16
+};
+
+// Groups of four values encoded or decoded per run when the whole array does
+// not fit in the buffer of a flushing writer or the window of a streaming
+// reader.
+#define SVB_RUN 64
+
+static size_t svb_control_size(size_t count) { return (count + 3) / 4; }
+
+static size_t svb_value_size(uint32_t value) {
+    if (value < (1u << 8))
+        return 1;
+    if (value < (1u << 16))
+        return 2;
+    return value < (1u << 24) ? 3 : 4;
+}
+
+// Data bytes used by count values, the last control byte may describe fewer
+// than four values.
+static size_t svb_data_size(const uint8_t *control, size_t count) {
+    size_t size = 0;
+    size_t full = count / 4;
+    for (size_t i = 0; i < full; i++)
+        size += svb_length[control[i]];
+    for (size_t i = 0; i < count % 4; i++)
+        size += ((control[full] >> (2 * i)) & 3) + 1;
+    return size;
+}
+
+static const uint8_t *svb_decode_scalar(uint32_t *out, const uint8_t *control,
+                                        const uint8_t *data, size_t begin,
+                                        size_t count) {
+    for (size_t i = begin; i < count; i++) {
+        size_t size = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+        for (size_t b = 0; b < size; b++)
+            value |= (uint32_t)data[b] << (8 * b);
+        data += size;
+        if (out)
+            out[i] = value;
+    }
+    return data;
+}
+
+#if defined(CBIN_HAVE_DISPATCH)
+CBIN_TARGET("ssse3")
+static size_t svb_decode_ssse3(uint32_t *out, const uint8_t *control,
+                               const uint8_t **data, const uint8_t *end,
+                               size_t count) {
+    const uint8_t *in = *data;
+    size_t i = 0;
+    // Every step loads 16 bytes, so stop while that stays inside the input.
+    for (; i + 4 <= count && end - in >= 16; i += 4) {
+        uint8_t key = control[i / 4];
+        __m128i bytes = _mm_loadu_si128((const __m128i *)in);
+        __m128i mask = _mm_loadu_si128((const __m128i *)svb_shuffle[key]);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_shuffle_epi8(bytes, mask));
+        in += svb_length[key];
+    }
+    *data = in;
+    return i;
+}
+#endif
+
+#if defined(CBIN_ARCH_NEON) && defined(__aarch64__)
+static size_t svb_decode_neon(uint32_t *out, const uint8_t *control,
+                              const uint8_t **data, const uint8_t *end,
+                              size_t count) {
+    const uint8_t *in = *data;
+    size_t i = 0;
+    for (; i + 4 <= count && end - in >= 16; i += 4) {
+        uint8_t key = control[i / 4];
+        uint8x16_t bytes = vld1q_u8(in);
+        uint8x16_t mask = vld1q_u8(svb_shuffle[key]);
+        vst1q_u8((uint8_t *)(out + i), vqtbl1q_u8(bytes, mask));
+        in += svb_length[key];
+    }
+    *data = in;
+    return i;
+}
+#endif
+
+// Encodes the control bytes of count values, the data bytes go to data if
+// it is set. Returns the size of the data.
+static size_t svb_encode(uint8_t *control, uint8_t *data,
+                         const uint32_t *values, size_t count) {
+    size_t data_size = 0;
+    // An empty array may come with no buffer at all.
+    if (!count)
+        return 0;
+    memset(control, 0, svb_control_size(count));
+    for (size_t i = 0; i < count; i++) {
+        size_t size = svb_value_size(values[i]);
+        control[i / 4] |= (uint8_t)((size - 1) << (2 * (i % 4)));
+        if (data) {
+            uint8_t bytes[4];
+            cbin_store_u32_le(bytes, values[i]);
+            memcpy(data + data_size, bytes, size);
+        }
+        data_size += size;
+    }
+    return data_size;
+}
+
+cbin_err_t cbin_write_svb_u32_array(cbin_writer_t *writer,
+                                    const uint32_t *values, size_t count) {
+    if (!writer->_sink) {
+        size_t control_size = svb_control_size(count);
+        size_t data_size = 0;
+        for (size_t i = 0; i < count; i++)
+            data_size += svb_value_size(values[i]);
+        void *out;
+        if (cbin_writer_reserve(writer, control_size + data_size, &out))
+            return writer->_error;
+        svb_encode((uint8_t *)out, (uint8_t *)out + control_size, values,
+                   count);
+        return CBIN_ERR_OK;
+    }
+    // A flushing writer gets the control bytes, then the data, in runs
+    // through a stack buffer so that each run is a single write.
+    uint8_t control[SVB_RUN];
+    uint8_t data[SVB_RUN * 16];
+    for (size_t pass = 0; pass < 2; pass++) {
+        for (size_t first = 0; first < count;) {
+            size_t run = count - first;
+            if (run > SVB_RUN * 4)
+                run = SVB_RUN * 4;
+            size_t size = svb_encode(control, pass ? data : NULL,
+                                     values + first, run);
+            if (pass ? cbin_write(writer, data, size)
+                     : cbin_write(writer, control, svb_control_size(run)))
+                return writer->_error;
+            first += run;
+        }
+    }
+    return CBIN_ERR_OK;
+}
+
+// Decodes count values whose control bytes are already known, with data
+// pointing at their data in the buffer of the reader.
+static void svb_decode(cbin_reader_t *reader, uint32_t *values,
+                       const uint8_t *control, const uint8_t *data,
+                       size_t count) {
+    const uint8_t *end = (const uint8_t *)reader->_buffer + reader->_size;
+    size_t done = 0;
+#if defined(CBIN_ARCH_NEON) && defined(__aarch64__)
+    done = svb_decode_neon(values, control, &data, end, count);
+#elif defined(CBIN_HAVE_DISPATCH)
+    if (cbin_cpu_features() & CBIN_CPU_SSSE3)
+        done = svb_decode_ssse3(values, control, &data, end, count);
+#else
+    (void)end;
+#endif
+    svb_decode_scalar(values, control, data, done, count);
+}
+
+cbin_err_t cbin_read_svb_u32_array(cbin_reader_t *reader, uint32_t *values,
+                                   size_t count) {
+    size_t control_size = svb_control_size(count);
+    if (reader->_error)
+        return reader->_error;
+    const uint8_t *control =
+        (const uint8_t *)reader->_buffer + reader->_position;
+    size_t available = reader->_size - reader->_position;
+    if (control_size <= available) {
+        size_t data_size = svb_data_size(control, count);
+        if (data_size <= available - control_size) {
+            if (values)
+                svb_decode(reader, values, control, control + control_size,
+                           count);
+            reader->_position += control_size + data_size;
+            return CBIN_ERR_OK;
+        }
+    }
+    // The array is not all in view: the control bytes are read first and
+    // parked in the first value of their group, then the data is decoded in
+    // runs.
+    uint8_t keys[SVB_RUN];
+    size_t data_size = 0;
+    for (size_t first = 0; first < count;) {
+        size_t run = count - first;
+        if (run > SVB_RUN * 4)
+            run = SVB_RUN * 4;
+        if (cbin_read(reader, keys, svb_control_size(run)))
+            return reader->_error;
+        data_size += svb_data_size(keys, run);
+        for (size_t i = 0; values && i < run; i += 4)
+            values[first + i] = keys[i / 4];
+        first += run;
+    }
+    if (!values)
+        return cbin_reader_skip(reader, data_size);
+    for (size_t first = 0; first < count;) {
+        size_t run = count - first;
+        if (run > SVB_RUN * 4)
+            run = SVB_RUN * 4;
+        for (size_t i = 0; i < run; i += 4)
+            keys[i / 4] = (uint8_t)values[first + i];
+        size_t size = svb_data_size(keys, run);
+        if (cbin_reader_ensure(reader, size))
+            return reader->_error;
+        svb_decode(reader, values + first, keys,
+                   (const uint8_t *)reader->_buffer + reader->_position, run);
+        reader->_position += size;
+        first += run;
+    }
+    return CBIN_ERR_OK;
+}
@@ -0,0 +1,100 @@
+#ifndef CBIN_SRC_CBIN_VARINT_H
+#define CBIN_SRC_CBIN_VARINT_H
+#include "common.h"
+#include "reader.h"
+#include "writer.h"
+
+/// The maximum size of an encoded 64-bit varint.
+#define CBIN_VARINT_MAX 10
+
+CBIN_HEADER_BEGIN
+
+/// Maps signed values to unsigned ones so that small magnitudes of either
+/// sign get short varints.
+static inline uint64_t cbin_zigzag_encode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+static inline int64_t cbin_zigzag_decode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/// Writes an unsigned LEB128 varint.
+/// \param writer The writer to write to.
+/// \param value The value to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_varu64(cbin_writer_t *writer, uint64_t value);
+
+/// Writes a signed value as a zigzag encoded LEB128 varint.
+/// \param writer The writer to write to.
+/// \param value The value to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_vari64(cbin_writer_t *writer, int64_t value);
+
+/// Reads an unsigned LEB128 varint.
+/// \param reader The reader to read from.
+/// \param value The value to read into, may be NULL to skip it.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode if the varint is longer than 64 bits.
+cbin_err_t cbin_read_varu64(cbin_reader_t *reader, uint64_t *value);
+
+/// Reads a zigzag encoded LEB128 varint.
+/// \param reader The reader to read from.
+/// \param value The value to read into, may be NULL to skip it.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode if the varint is longer than 64 bits.
+cbin_err_t cbin_read_vari64(cbin_reader_t *reader, int64_t *value);
+
+/// Writes an array of LEB128 varints, zigzag encoded for the signed variant.
+/// \param writer The writer to write to.
+/// \param values The values to write.
+/// \param count The number of values to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_varu64_array(cbin_writer_t *writer,
+                                   const uint64_t *values, size_t count);
+cbin_err_t cbin_write_vari64_array(cbin_writer_t *writer,
+                                   const int64_t *values, size_t count);
+
+/// Reads an array of LEB128 varints, zigzag encoded for the signed variant.
+/// Values are decoded straight from the buffer with a branch-light 8-byte
+/// kernel, only the last few bytes of the input go through the checked path.
+/// \param reader The reader to read from.
+/// \param values The array to read into, may be NULL to skip the values.
+/// \param count The number of values to read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+/// \code CBIN_ERR_CORRUPT \endcode
+cbin_err_t cbin_read_varu64_array(cbin_reader_t *reader, uint64_t *values,
+                                  size_t count);
+cbin_err_t cbin_read_vari64_array(cbin_reader_t *reader, int64_t *values,
+                                  size_t count);
+
+/// Writes an array of 32-bit values in the Stream VByte layout: the 2-bit
+/// lengths of all values come first, followed by their 1 to 4 data bytes.
+/// The count is not stored, it has to be known to the reader.
+/// \param writer The writer to write to.
+/// \param values The values to write.
+/// \param count The number of values to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_svb_u32_array(cbin_writer_t *writer,
+                                    const uint32_t *values, size_t count);
+
+/// Reads an array written by cbin_write_svb_u32_array, four values per
+/// byte shuffle with SSSE3 or NEON. Values are decoded in runs, so
+/// streaming readers only need a small window.
+/// \param reader The reader to read from.
+/// \param values The array to read into, may be NULL to skip the values.
+/// \param count The number of values to read.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
+cbin_err_t cbin_read_svb_u32_array(cbin_reader_t *reader, uint32_t *values,
+                                   size_t count);
+
+CBIN_HEADER_END
+
+#endif // CBIN_SRC_CBIN_VARINT_H
@@ -3,10 +3,156 @@
 //
 
 #include "writer.h"
+#include "bswap_array.h"
+#include "checksum.h"
+#include "file.h"
 #include <endianness/endianness.h>
 #include <string.h>
 
+// Clears the state of the optional writer modes.
+static void cbin_writer_init_modes(cbin_writer_t *writer) {
+    writer->_allocator = NULL;
+    writer->_inline = false;
+    writer->_sink = NULL;
+    writer->_sink_user = NULL;
+    writer->_flushed = 0;
+    writer->_segments = NULL;
+    writer->_segment_count = 0;
+    writer->_segment_capacity = 0;
+    writer->_chunk_size = 0;
+    writer->_chunk_start = 0;
+    writer->_checksum = NULL;
+    writer->_checksum_mark = 0;
+    writer->_frames = NULL;
+    writer->_frame_count = 0;
+    writer->_frame_capacity = 0;
+    writer->_gaps = NULL;
+    writer->_gap_count = 0;
+    writer->_gap_capacity = 0;
+    writer->_gap_bytes = 0;
+#if defined(CBIN_STATS)
+    memset(&writer->_stats, 0, sizeof(writer->_stats));
+#endif
+}
+
+// Returns the end of the bytes that are final. Bytes from the first open
+// frame on are still patched or moved when frames end, so they are neither
+// flushed nor hashed until then.
+static size_t cbin_writer_settled(const cbin_writer_t *writer) {
+    if (!writer->_frame_count)
+        return writer->_position;
+    size_t pin = writer->_frames[0].position - writer->_flushed +
+                 writer->_chunk_start;
+    return pin < writer->_position ? pin : writer->_position;
+}
+
+// Adds the bytes written since the last update to the checksum of the open
+// region. Bytes are hashed in blocks, while they are still in cache, and
+// only once they leave the buffer or are behind the position, so that the
+// bytes the caller patches in place are hashed with their final value.
+static void cbin_writer_hash(cbin_writer_t *writer) {
+    size_t end = cbin_writer_settled(writer);
+    if (end > writer->_checksum_mark) {
+        cbin_checksum_update(writer->_checksum,
+                             (const uint8_t *)writer->_buffer +
+                                 writer->_checksum_mark,
+                             end - writer->_checksum_mark);
+        writer->_checksum_mark = end;
+    }
+}
+
+// Chunks of a segmented writer are chained through a header holding the
+// previous chunk, _buffer points just past it.
+#define CHUNK_HEADER sizeof(void *)
+#define CHUNK_PREV(buffer) (((void **)(buffer))[-1])
+
+static void *cbin_chunk_alloc(void *prev, size_t size) {
+    uint8_t *chunk = (uint8_t *)CBIN_REALLOC(NULL, CHUNK_HEADER + size);
+    if (!chunk)
+        return NULL;
+    memcpy(chunk, &prev, sizeof(prev));
+    return chunk + CHUNK_HEADER;
+}
+
+// Frees every chunk older than the given one.
+static void cbin_chunk_free_chain(void *buffer) {
+    void *chunk = CHUNK_PREV(buffer);
+    while (chunk) {
+        void *prev = CHUNK_PREV(chunk);
+        CBIN_FREE((uint8_t *)chunk - CHUNK_HEADER);
+        chunk = prev;
+    }
+    CHUNK_PREV(buffer) = NULL;
+}
+
+// Appends a segment to a segmented writer, merging it with the previous one
+// when they are adjacent in memory.
+static cbin_err_t cbin_writer_push_segment(cbin_writer_t *writer,
+                                           const void *data, size_t size) {
+    if (size == 0)
+        return CBIN_ERR_OK;
+    if (writer->_segment_count > 0) {
+        cbin_iovec_t *last = &writer->_segments[writer->_segment_count - 1];
+        if ((const uint8_t *)last->iov_base + last->iov_len ==
+            (const uint8_t *)data) {
+            last->iov_len += size;
+            writer->_flushed += size;
+            return CBIN_ERR_OK;
+        }
+    }
+    // One slot is always kept spare for the open segment, see
+    // cbin_writer_segments.
+    if (writer->_segment_count + 2 > writer->_segment_capacity) {
+        size_t capacity =
+            writer->_segment_capacity ? writer->_segment_capacity * 2 : 8;
+        void *segments =
+            CBIN_REALLOC(writer->_segments, capacity * sizeof(cbin_iovec_t));
+        if (!segments)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+        writer->_segments = (cbin_iovec_t *)segments;
+        writer->_segment_capacity = capacity;
+    }
+    cbin_iovec_t *segment = &writer->_segments[writer->_segment_count++];
+    segment->iov_base = (void *)data;
+    segment->iov_len = size;
+    writer->_flushed += size;
+    return CBIN_ERR_OK;
+}
+
+// Closes the open segment at the current position and moves on to a new
+// chunk. Pending bytes past the position move along with it, like in
+// cbin_writer_flush.
+static cbin_err_t cbin_writer_next_chunk(cbin_writer_t *writer,
+                                         size_t count) {
+    if (writer->_checksum)
+        cbin_writer_hash(writer);
+    uint8_t *buffer = (uint8_t *)writer->_buffer;
+    size_t pending = writer->_written - writer->_position;
+    size_t size = writer->_chunk_size;
+    if (size < count + pending)
+        size = count + pending;
+    void *chunk = cbin_chunk_alloc(buffer, size);
+    if (!chunk)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    if (cbin_writer_push_segment(writer, buffer + writer->_chunk_start,
+                                 writer->_position - writer->_chunk_start)) {
+        CBIN_FREE((uint8_t *)chunk - CHUNK_HEADER);
+        return writer->_error;
+    }
+    memcpy(chunk, buffer + writer->_position, pending);
+    CBIN_STAT_ADD(writer, grow_count, 1);
+    CBIN_STAT_ADD(writer, grow_bytes_copied, pending);
+    writer->_buffer = chunk;
+    writer->_capacity = size;
+    writer->_chunk_start = 0;
+    writer->_position = 0;
+    writer->_written = pending;
+    writer->_checksum_mark = 0;
+    return CBIN_ERR_OK;
+}
+
 void cbin_writer_init_fixed(cbin_writer_t *writer, void *buffer, size_t size) {
+    cbin_writer_init_modes(writer);
     writer->_buffer = buffer;
     writer->_capacity = buffer ? size : 0;
     writer->_position = 0;
@@ -14,12 +160,25 @@ void cbin_writer_init_fixed(cbin_writer_t *writer, void *buffer, size_t size) {
     writer->_owns_buffer = false;
     writer->_error = CBIN_ERR_OK;
 }
+void cbin_writer_init_inline(cbin_writer_t *writer, void *buffer,
+                             size_t size) {
+    cbin_writer_init_fixed(writer, buffer, size);
+    writer->_inline = true;
+}
 cbin_err_t cbin_writer_init_dynamic(cbin_writer_t *writer,
                                     size_t initial_capacity) {
+    return cbin_writer_init_allocator(writer, initial_capacity, NULL);
+}
+cbin_err_t cbin_writer_init_allocator(cbin_writer_t *writer,
+                                      size_t initial_capacity,
+                                      const cbin_allocator_t *allocator) {
+    cbin_writer_init_modes(writer);
+    writer->_allocator = allocator;
     if (initial_capacity > 0) {
-        writer->_buffer = CBIN_REALLOC(writer->_buffer, initial_capacity);
+        writer->_buffer =
+            cbin_allocator_realloc(allocator, NULL, 0, initial_capacity);
         if (!writer->_buffer) {
-            return writer->_error = CBIN_ERR_OUT_OF_MEMORY;
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
         }
     } else {
         writer->_buffer = 0;
@@ -30,16 +189,92 @@ cbin_err_t cbin_writer_init_dynamic(cbin_writer_t *writer,
     writer->_owns_buffer = true;
     return writer->_error = CBIN_ERR_OK;
 }
+cbin_err_t cbin_writer_init_sink(cbin_writer_t *writer, size_t buffer_size,
+                                 cbin_writer_sink_fn sink, void *user_data) {
+    writer->_buffer = NULL;
+    if (buffer_size == 0) {
+        cbin_writer_init_dynamic(writer, 0);
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    if (cbin_writer_init_dynamic(writer, buffer_size))
+        return writer->_error;
+    writer->_sink = sink;
+    writer->_sink_user = user_data;
+    return CBIN_ERR_OK;
+}
+cbin_err_t cbin_writer_init_fd(cbin_writer_t *writer, int fd,
+                               size_t buffer_size) {
+    return cbin_writer_init_sink(writer, buffer_size, cbin_fd_sink,
+                                 (void *)(intptr_t)fd);
+}
+cbin_err_t cbin_writer_init_segmented(cbin_writer_t *writer,
+                                      size_t chunk_size) {
+    cbin_writer_init_fixed(writer, NULL, 0);
+    if (chunk_size == 0)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    writer->_segments =
+        (cbin_iovec_t *)CBIN_REALLOC(NULL, 8 * sizeof(cbin_iovec_t));
+    writer->_buffer = cbin_chunk_alloc(NULL, chunk_size);
+    if (!writer->_buffer || !writer->_segments) {
+        if (writer->_buffer)
+            CBIN_FREE((uint8_t *)writer->_buffer - CHUNK_HEADER);
+        if (writer->_segments)
+            CBIN_FREE(writer->_segments);
+        writer->_buffer = NULL;
+        writer->_segments = NULL;
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    writer->_segment_capacity = 8;
+    writer->_capacity = chunk_size;
+    writer->_chunk_size = chunk_size;
+    writer->_owns_buffer = true;
+    return CBIN_ERR_OK;
+}
+void cbin_writer_destroy_frames(cbin_writer_t *writer) {
+    if (writer->_frames)
+        CBIN_FREE(writer->_frames);
+    if (writer->_gaps)
+        CBIN_FREE(writer->_gaps);
+    writer->_frames = NULL;
+    writer->_frame_count = 0;
+    writer->_frame_capacity = 0;
+    writer->_gaps = NULL;
+    writer->_gap_count = 0;
+    writer->_gap_capacity = 0;
+    writer->_gap_bytes = 0;
+}
 void cbin_writer_destroy(cbin_writer_t *writer) {
+#if defined(CBIN_STATS)
+    cbin_writer_publish_stats(writer);
+#endif
+    cbin_writer_destroy_frames(writer);
+    if (writer->_chunk_size) {
+        cbin_chunk_free_chain(writer->_buffer);
+        CBIN_FREE((uint8_t *)writer->_buffer - CHUNK_HEADER);
+        if (writer->_segments)
+            CBIN_FREE(writer->_segments);
+        return;
+    }
     if (writer->_owns_buffer && writer->_buffer) {
-        CBIN_FREE(writer->_buffer);
+        cbin_allocator_free(writer->_allocator, writer->_buffer,
+                            writer->_capacity);
     }
 }
 
 void cbin_writer_reset(cbin_writer_t *writer) {
+    if (writer->_chunk_size) {
+        cbin_chunk_free_chain(writer->_buffer);
+        writer->_segment_count = 0;
+        writer->_chunk_start = 0;
+        writer->_flushed = 0;
+    }
     writer->_position = 0;
     writer->_written = 0;
     writer->_error = CBIN_ERR_OK;
+    writer->_checksum = NULL;
+    writer->_frame_count = 0;
+    writer->_gap_count = 0;
+    writer->_gap_bytes = 0;
 }
 void cbin_writer_discard_error(cbin_writer_t *writer) {
     writer->_error = CBIN_ERR_OK;
@@ -47,11 +282,91 @@ void cbin_writer_discard_error(cbin_writer_t *writer) {
 cbin_err_t cbin_writer_seek(cbin_writer_t *writer, size_t position) {
     if (writer->_error)
         return writer->_error;
-    if (position > writer->_written) {
-        return writer->_error = CBIN_ERR_OUT_OF_BOUNDS;
+    if (position < writer->_flushed ||
+        position - writer->_flushed >
+            writer->_written - writer->_chunk_start) {
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
     }
+    position = position - writer->_flushed + writer->_chunk_start;
+    // Bytes already added to a checksum cannot be changed anymore.
+    if (writer->_checksum && position < writer->_checksum_mark)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_BOUNDS);
 
     writer->_position = position;
+    CBIN_STAT_ADD(writer, seek_count, 1);
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_writer_flush(cbin_writer_t *writer) {
+    if (writer->_error)
+        return writer->_error;
+    if (!writer->_sink)
+        return CBIN_ERR_OK;
+    if (writer->_checksum)
+        cbin_writer_hash(writer);
+    size_t size = cbin_writer_settled(writer);
+    if (size == 0)
+        return CBIN_ERR_OK;
+    cbin_err_t err = writer->_sink(writer->_sink_user, writer->_buffer, size);
+    if (err)
+        return CBIN_ERROR(writer, err);
+    // Bytes past the position were sought over and are still pending, they
+    // stay in the buffer for the writes that will overwrite them, as do the
+    // bytes of open frames.
+    uint8_t *buffer = (uint8_t *)writer->_buffer;
+    memmove(buffer, buffer + size, writer->_written - size);
+    writer->_flushed += size;
+    writer->_written -= size;
+    writer->_position -= size;
+    writer->_checksum_mark =
+        writer->_checksum_mark > size ? writer->_checksum_mark - size : 0;
+    CBIN_STAT_ADD(writer, flush_count, 1);
+    return CBIN_ERR_OK;
+}
+
+static cbin_err_t cbin_writer_grow(cbin_writer_t *writer, size_t count) {
+    if (writer->_chunk_size)
+        return cbin_writer_next_chunk(writer, count);
+    if (writer->_sink) {
+        if (cbin_writer_flush(writer))
+            return writer->_error;
+        if (writer->_position + count <= writer->_capacity)
+            return CBIN_ERR_OK;
+        // Open frames keep their bytes in the buffer, which then grows to
+        // make room like a dynamic one.
+        if (!writer->_frame_count)
+            return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    if (!writer->_owns_buffer && !writer->_inline)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    size_t new_capacity = writer->_capacity ? writer->_capacity : 8;
+    // Align count to pointer size
+    new_capacity += (count + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    new_capacity *= 2;
+    void *new_buffer;
+    if (writer->_owns_buffer) {
+        new_buffer =
+            cbin_allocator_realloc(writer->_allocator, writer->_buffer,
+                                   writer->_capacity, new_capacity);
+    } else {
+        // An inline writer spills: only the written bytes are copied and
+        // the inline buffer is left to the caller.
+        new_buffer =
+            cbin_allocator_realloc(writer->_allocator, NULL, 0, new_capacity);
+        if (new_buffer && writer->_written)
+            memcpy(new_buffer, writer->_buffer, writer->_written);
+    }
+    if (!new_buffer) {
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    }
+    CBIN_STAT_ADD(writer, grow_count, 1);
+    if (new_buffer != writer->_buffer)
+        CBIN_STAT_ADD(writer, grow_bytes_copied,
+                      writer->_owns_buffer ? writer->_capacity
+                                           : writer->_written);
+    writer->_owns_buffer = true;
+    writer->_buffer = new_buffer;
+    writer->_capacity = new_capacity;
     return CBIN_ERR_OK;
 }
 
@@ -59,24 +374,18 @@ cbin_err_t cbin_writer_reserve(cbin_writer_t *writer, size_t count,
                                void **out) {
     if (writer->_error)
         return writer->_error;
+    if (CBIN_UNLIKELY(writer->_checksum != NULL) &&
+        writer->_position - writer->_checksum_mark >= CBIN_CHECKSUM_BLOCK)
+        cbin_writer_hash(writer);
     if (writer->_position + count > writer->_capacity) {
-        if (!writer->_owns_buffer)
-            return writer->_error = CBIN_ERR_OUT_OF_MEMORY;
-        size_t new_capacity = writer->_capacity ? writer->_capacity : 8;
-        // Align count to pointer size
-        new_capacity += (count + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
-        new_capacity *= 2;
-        void *new_buffer = CBIN_REALLOC(writer->_buffer, new_capacity);
-        if (!new_buffer) {
-            return writer->_error = CBIN_ERR_OUT_OF_MEMORY;
-        }
-        writer->_buffer = new_buffer;
-        writer->_capacity = new_capacity;
+        if (cbin_writer_grow(writer, count))
+            return writer->_error;
     }
 
     if (out) {
         *out = (uint8_t *)writer->_buffer + writer->_position;
     }
+    CBIN_STAT_ADD(writer, bytes_written, count);
     writer->_position += count;
     if (writer->_position > writer->_written) {
         writer->_written = writer->_position;
@@ -84,9 +393,27 @@ cbin_err_t cbin_writer_reserve(cbin_writer_t *writer, size_t count,
     return CBIN_ERR_OK;
 }
 
+cbin_err_t cbin_writer_ensure(cbin_writer_t *writer, size_t count) {
+    if (writer->_error)
+        return writer->_error;
+    if (writer->_position + count > writer->_capacity) {
+        if (cbin_writer_grow(writer, count))
+            return writer->_error;
+    }
+    return CBIN_ERR_OK;
+}
+
 cbin_err_t cbin_writer_fill(cbin_writer_t *writer, uint8_t value,
                             size_t count) {
     void *buffer = NULL;
+    if (writer->_sink) {
+        // Larger than the buffer, fill it repeatedly.
+        while (count > writer->_capacity) {
+            if (cbin_writer_fill(writer, value, writer->_capacity))
+                return writer->_error;
+            count -= writer->_capacity;
+        }
+    }
     if (cbin_writer_reserve(writer, count, &buffer))
         return writer->_error;
     memset(buffer, value, count);
@@ -96,10 +423,10 @@ const void *cbin_writer_buffer(const cbin_writer_t *writer) {
     return writer->_buffer;
 }
 size_t cbin_writer_position(const cbin_writer_t *writer) {
-    return writer->_position;
+    return writer->_flushed + writer->_position - writer->_chunk_start;
 }
 size_t cbin_writer_written(const cbin_writer_t *writer) {
-    return writer->_written;
+    return writer->_flushed + writer->_written - writer->_chunk_start;
 }
 size_t cbin_writer_capacity(const cbin_writer_t *writer) {
     return writer->_capacity;
@@ -109,11 +436,123 @@ cbin_err_t cbin_writer_error(const cbin_writer_t *writer) {
 }
 cbin_err_t cbin_write(cbin_writer_t *writer, const void *data, size_t size) {
     void *buffer = NULL;
+    if (writer->_sink && size > writer->_capacity && !writer->_frame_count &&
+        !writer->_error) {
+        // Too large to buffer, hand it to the sink directly. Any pending
+        // bytes past the position are overwritten by it anyway.
+        writer->_written = writer->_position;
+        if (cbin_writer_flush(writer))
+            return writer->_error;
+        cbin_err_t err = writer->_sink(writer->_sink_user, data, size);
+        if (err)
+            return CBIN_ERROR(writer, err);
+        if (writer->_checksum)
+            cbin_checksum_update(writer->_checksum, data, size);
+        CBIN_STAT_ADD(writer, bytes_written, size);
+        CBIN_STAT_ADD(writer, flush_count, 1);
+        writer->_flushed += size;
+        return CBIN_ERR_OK;
+    }
     if (cbin_writer_reserve(writer, size, &buffer))
         return writer->_error;
-    memcpy(buffer, data, size);
+    // An empty dynamic writer has no buffer yet.
+    if (size)
+        memcpy(buffer, data, size);
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_writer_splice(cbin_writer_t *writer, const void *data,
+                              size_t size) {
+    if (writer->_error)
+        return writer->_error;
+    if (!writer->_chunk_size || size < CBIN_SPLICE_MIN)
+        return cbin_write(writer, data, size);
+    if (writer->_position != writer->_written)
+        return CBIN_ERROR(writer, CBIN_ERR_FAILED);
+    if (writer->_checksum) {
+        cbin_writer_hash(writer);
+        cbin_checksum_update(writer->_checksum, data, size);
+    }
+    uint8_t *buffer = (uint8_t *)writer->_buffer;
+    if (cbin_writer_push_segment(writer, buffer + writer->_chunk_start,
+                                 writer->_position - writer->_chunk_start))
+        return writer->_error;
+    if (cbin_writer_push_segment(writer, data, size))
+        return writer->_error;
+    // The rest of the chunk is reused for the bytes after the blob.
+    writer->_chunk_start = writer->_position;
+    CBIN_STAT_ADD(writer, bytes_written, size);
+    return CBIN_ERR_OK;
+}
+
+cbin_err_t cbin_writer_begin_checksum(cbin_writer_t *writer,
+                                      cbin_checksum_t *checksum) {
+    if (writer->_error)
+        return writer->_error;
+    if (writer->_checksum)
+        return CBIN_ERR_FAILED;
+    writer->_checksum = checksum;
+    writer->_checksum_mark = writer->_position;
     return CBIN_ERR_OK;
 }
+cbin_err_t cbin_writer_end_checksum(cbin_writer_t *writer) {
+    if (!writer->_checksum || writer->_frame_count)
+        return CBIN_ERR_FAILED;
+    cbin_writer_hash(writer);
+    writer->_checksum = NULL;
+    return writer->_error;
+}
+cbin_err_t cbin_writer_write_checksum(cbin_writer_t *writer) {
+    cbin_checksum_t *checksum = writer->_checksum;
+    cbin_err_t err = cbin_writer_end_checksum(writer);
+    if (err)
+        return err;
+    uint64_t digest = cbin_checksum_digest(checksum);
+    if (cbin_checksum_size(checksum) == 4)
+        return cbin_write_u32_le(writer, (uint32_t)digest);
+    return cbin_write_u64_le(writer, digest);
+}
+
+bool cbin_writer_get_stats(const cbin_writer_t *writer,
+                           cbin_writer_stats_t *stats) {
+#if defined(CBIN_STATS)
+    *stats = writer->_stats;
+    if (writer->_capacity > stats->peak_capacity)
+        stats->peak_capacity = writer->_capacity;
+    return true;
+#else
+    (void)writer;
+    memset(stats, 0, sizeof(*stats));
+    return false;
+#endif
+}
+void cbin_writer_publish_stats(cbin_writer_t *writer) {
+#if defined(CBIN_STATS)
+    cbin_writer_stats_t stats;
+    cbin_writer_get_stats(writer, &stats);
+    cbin_stats_publish_writer(&stats);
+    memset(&writer->_stats, 0, sizeof(writer->_stats));
+#else
+    (void)writer;
+#endif
+}
+
+const cbin_iovec_t *cbin_writer_segments(cbin_writer_t *writer,
+                                         size_t *count) {
+    *count = writer->_segment_count;
+    if (!writer->_chunk_size)
+        return NULL;
+    size_t open = writer->_written - writer->_chunk_start;
+    if (open > 0) {
+        // The open segment goes into the spare slot kept by push_segment
+        // without being closed, so later writes can still extend it.
+        cbin_iovec_t *segment = &writer->_segments[writer->_segment_count];
+        segment->iov_base = (uint8_t *)writer->_buffer + writer->_chunk_start;
+        segment->iov_len = open;
+        (*count)++;
+    }
+    return writer->_segments;
+}
 
 #ifdef __LITTLE_ENDIAN__
 #    define WRITE_LE(size, swap) (cbin_write(writer, &value, (size) / 8))
@@ -194,3 +633,114 @@ cbin_err_t cbin_write_f64_be(cbin_writer_t *writer, double value) {
 cbin_err_t cbin_write_bool(cbin_writer_t *writer, bool value) {
     return cbin_write_u8(writer, value);
 }
+
+static cbin_err_t cbin_write_array(cbin_writer_t *writer, const void *values,
+                                   size_t count, size_t size,
+                                   cbin_bswap_array_fn swap) {
+    void *buffer = NULL;
+    if (writer->_sink) {
+        // Larger than the buffer, write it in buffer-sized runs.
+        size_t run = writer->_capacity / size;
+        while (count > run && run > 0) {
+            if (cbin_write_array(writer, values, run, size, swap))
+                return writer->_error;
+            values = (const uint8_t *)values + run * size;
+            count -= run;
+        }
+    }
+    if (count > SIZE_MAX / size)
+        return CBIN_ERROR(writer, CBIN_ERR_OUT_OF_MEMORY);
+    if (cbin_writer_reserve(writer, count * size, &buffer))
+        return writer->_error;
+    if (swap)
+        swap(buffer, values, count);
+    else
+        memcpy(buffer, values, count * size);
+    return CBIN_ERR_OK;
+}
+
+#ifdef __LITTLE_ENDIAN__
+#    define WRITE_ARRAY_LE(size)                                               \
+        (cbin_write_array(writer, values, count, (size) / 8, NULL))
+#    define WRITE_ARRAY_BE(size)                                               \
+        (cbin_write_array(writer, values, count, (size) / 8,                   \
+                          cbin_bswap##size##_array))
+#elif defined(__BIG_ENDIAN__)
+#    define WRITE_ARRAY_LE(size)                                               \
+        (cbin_write_array(writer, values, count, (size) / 8,                   \
+                          cbin_bswap##size##_array))
+#    define WRITE_ARRAY_BE(size)                                               \
+        (cbin_write_array(writer, values, count, (size) / 8, NULL))
+#endif
+
+cbin_err_t cbin_write_u16_le_array(cbin_writer_t *writer,
+                                   const uint16_t *values, size_t count) {
+    return WRITE_ARRAY_LE(16);
+}
+cbin_err_t cbin_write_u16_be_array(cbin_writer_t *writer,
+                                   const uint16_t *values, size_t count) {
+    return WRITE_ARRAY_BE(16);
+}
+
+cbin_err_t cbin_write_u32_le_array(cbin_writer_t *writer,
+                                   const uint32_t *values, size_t count) {
+    return WRITE_ARRAY_LE(32);
+}
+cbin_err_t cbin_write_u32_be_array(cbin_writer_t *writer,
+                                   const uint32_t *values, size_t count) {
+    return WRITE_ARRAY_BE(32);
+}
+
+cbin_err_t cbin_write_u64_le_array(cbin_writer_t *writer,
+                                   const uint64_t *values, size_t count) {
+    return WRITE_ARRAY_LE(64);
+}
+cbin_err_t cbin_write_u64_be_array(cbin_writer_t *writer,
+                                   const uint64_t *values, size_t count) {
+    return WRITE_ARRAY_BE(64);
+}
+
+cbin_err_t cbin_write_i16_le_array(cbin_writer_t *writer,
+                                   const int16_t *values, size_t count) {
+    return WRITE_ARRAY_LE(16);
+}
+cbin_err_t cbin_write_i16_be_array(cbin_writer_t *writer,
+                                   const int16_t *values, size_t count) {
+    return WRITE_ARRAY_BE(16);
+}
+
+cbin_err_t cbin_write_i32_le_array(cbin_writer_t *writer,
+                                   const int32_t *values, size_t count) {
+    return WRITE_ARRAY_LE(32);
+}
+cbin_err_t cbin_write_i32_be_array(cbin_writer_t *writer,
+                                   const int32_t *values, size_t count) {
+    return WRITE_ARRAY_BE(32);
+}
+
+cbin_err_t cbin_write_i64_le_array(cbin_writer_t *writer,
+                                   const int64_t *values, size_t count) {
+    return WRITE_ARRAY_LE(64);
+}
+cbin_err_t cbin_write_i64_be_array(cbin_writer_t *writer,
+                                   const int64_t *values, size_t count) {
+    return WRITE_ARRAY_BE(64);
+}
+
+cbin_err_t cbin_write_f32_le_array(cbin_writer_t *writer,
+                                   const float *values, size_t count) {
+    return WRITE_ARRAY_LE(32);
+}
+cbin_err_t cbin_write_f32_be_array(cbin_writer_t *writer,
+                                   const float *values, size_t count) {
+    return WRITE_ARRAY_BE(32);
+}
+
+cbin_err_t cbin_write_f64_le_array(cbin_writer_t *writer,
+                                   const double *values, size_t count) {
+    return WRITE_ARRAY_LE(64);
+}
+cbin_err_t cbin_write_f64_be_array(cbin_writer_t *writer,
+                                   const double *values, size_t count) {
+    return WRITE_ARRAY_BE(64);
+}
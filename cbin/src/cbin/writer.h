@@ -4,18 +4,96 @@
 
 #ifndef CBIN_SRC_CBIN_WRITER_H
 #define CBIN_SRC_CBIN_WRITER_H
+#include "alloc.h"
+#include "bytes.h"
 #include "common.h"
+#include "stats.h"
 #include <stdbool.h>
 #include <stdint.h>
 
+#if defined(_WIN32)
+typedef struct cbin_iovec_s {
+    void *iov_base;
+    size_t iov_len;
+} cbin_iovec_t;
+#else
+#    include <sys/uio.h>
+typedef struct iovec cbin_iovec_t;
+#endif
+
+/// Blobs smaller than this are copied by cbin_writer_splice, referencing
+/// them would cost more in segments than the copy.
+#ifndef CBIN_SPLICE_MIN
+#    define CBIN_SPLICE_MIN 256
+#endif
+
+/// Receives the output of a flushing writer.
+/// \param user_data The user data given when initializing the writer.
+/// \param data The bytes to consume.
+/// \param size The number of bytes to consume.
+/// \return \code CBIN_ERR_OK \endcode or an error to make the writer fail.
+typedef cbin_err_t (*cbin_writer_sink_fn)(void *user_data, const void *data,
+                                          size_t size);
+
+// An open frame of cbin_writer_begin_frame, positions are absolute.
+typedef struct cbin_writer_frame_s {
+    size_t position;
+    size_t gap_bytes;
+    size_t gap_index;
+    int prefix;
+} cbin_writer_frame_t;
+
+// Unused bytes of a varint length, removed once every frame is closed.
+typedef struct cbin_writer_gap_s {
+    size_t position;
+    size_t size;
+} cbin_writer_gap_t;
+
 typedef struct cbin_writer_s {
     void *_buffer;
     size_t _capacity;
 
     size_t _position;
     size_t _written;
+    // Set for owned buffers, including the heap buffer an inline writer
+    // spilled to. _inline is set for inline writers, whose buffer belongs to
+    // the caller until then.
     bool _owns_buffer;
+    bool _inline;
     cbin_err_t _error;
+    // Allocator of owned buffers, NULL selects CBIN_REALLOC and CBIN_FREE.
+    const cbin_allocator_t *_allocator;
+
+    // Sink state, _sink is only set for flushing writers.
+    cbin_writer_sink_fn _sink;
+    void *_sink_user;
+    size_t _flushed;
+
+    // Segment state, _chunk_size is only set for segmented writers.
+    cbin_iovec_t *_segments;
+    size_t _segment_count;
+    size_t _segment_capacity;
+    size_t _chunk_size;
+    size_t _chunk_start;
+
+    // Checksum state, _checksum is only set inside a checksummed region and
+    // covers the bytes from its start up to _checksum_mark.
+    struct cbin_checksum_s *_checksum;
+    size_t _checksum_mark;
+
+    // Frame state, _frames holds the open frames from the outermost one.
+    // Their bytes stay in the buffer until they are all closed.
+    cbin_writer_frame_t *_frames;
+    size_t _frame_count;
+    size_t _frame_capacity;
+    cbin_writer_gap_t *_gaps;
+    size_t _gap_count;
+    size_t _gap_capacity;
+    size_t _gap_bytes;
+
+#if defined(CBIN_STATS)
+    cbin_writer_stats_t _stats;
+#endif
 } cbin_writer_t;
 
 CBIN_HEADER_BEGIN
@@ -26,6 +104,17 @@ CBIN_HEADER_BEGIN
 /// \param size The size of the buffer.
 void cbin_writer_init_fixed(cbin_writer_t *writer, void *buffer, size_t size);
 
+/// Initializes a writer that starts in a caller-provided buffer, e.g. on the
+/// stack, and moves its bytes to a heap buffer the first time they do not
+/// fit. Small messages never allocate, large ones still succeed. The buffer
+/// returned by cbin_writer_buffer changes when the bytes move, and
+/// cbin_writer_destroy has to be called in case they did.
+/// \param writer The writer to initialize.
+/// \param buffer The buffer to start in, may be NULL.
+/// \param size The size of the buffer.
+void cbin_writer_init_inline(cbin_writer_t *writer, void *buffer,
+                             size_t size);
+
 /// Initializes a resizable writer with a capacity.
 /// \param writer The writer to initialize.
 /// \param initial_capacity The initial capacity of the writer.
@@ -34,11 +123,76 @@ void cbin_writer_init_fixed(cbin_writer_t *writer, void *buffer, size_t size);
 cbin_err_t cbin_writer_init_dynamic(cbin_writer_t *writer,
                                     size_t initial_capacity);
 
-/// Destroys a writer, only required if the writer is dynamic.
+/// Initializes a resizable writer whose buffer is managed by an allocator,
+/// see cbin_writer_init_dynamic.
+/// \param writer The writer to initialize.
+/// \param initial_capacity The initial capacity of the writer.
+/// \param allocator The allocator of the buffer, must outlive the writer.
+/// NULL selects CBIN_REALLOC and CBIN_FREE.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_init_allocator(cbin_writer_t *writer,
+                                      size_t initial_capacity,
+                                      const cbin_allocator_t *allocator);
+
+/// Initializes a flushing writer that buffers into a fixed-size buffer and
+/// hands the buffered bytes to a sink whenever it fills up, so memory use is
+/// constant regardless of the output size.
+///
+/// Positions are absolute offsets in the output. A flush emits every byte
+/// before the current position; bytes after it, which only exist after
+/// seeking back, stay buffered. Seeking is therefore limited to the bytes
+/// that have not been flushed yet, and a single reservation cannot be
+/// larger than the buffer. To patch a placeholder later, cbin_writer_ensure
+/// enough room for it and the bytes up to the patch before writing it.
+/// \param writer The writer to initialize.
+/// \param buffer_size The size of the buffer to allocate.
+/// \param sink The callback that consumes the output.
+/// \param user_data The user data passed to the callback.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_init_sink(cbin_writer_t *writer, size_t buffer_size,
+                                 cbin_writer_sink_fn sink, void *user_data);
+
+/// Initializes a flushing writer over a file descriptor, see
+/// cbin_writer_init_sink. The descriptor is not closed by
+/// cbin_writer_destroy.
+/// \param writer The writer to initialize.
+/// \param fd The file descriptor to write to.
+/// \param buffer_size The size of the buffer to allocate.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_init_fd(cbin_writer_t *writer, int fd,
+                               size_t buffer_size);
+
+/// Initializes a segmented writer, which never reallocates: when a chunk is
+/// full the written bytes are kept where they are and writing continues in
+/// a new chunk. The output is exposed as a list of segments by
+/// cbin_writer_segments, ready for writev or sendmsg without flattening.
+///
+/// Positions are absolute offsets in the output, but seeking is limited to
+/// the bytes written since the last chunk change or splice.
+/// \param writer The writer to initialize.
+/// \param chunk_size The size of each chunk, larger reservations get a
+/// chunk of their own.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_init_segmented(cbin_writer_t *writer,
+                                      size_t chunk_size);
+
+/// Destroys a writer, only required if the writer is dynamic, used frames or
+/// to publish its counters. Flushing writers are not flushed, call
+/// cbin_writer_flush first.
 /// \param writer The writer to destroy.
 void cbin_writer_destroy(cbin_writer_t *writer);
 
-/// Resets a writer to a clean state.
+/// Frees the frames of a writer, open ones are dropped. Called by
+/// cbin_writer_destroy and cbin_pool_release.
+/// \param writer The writer to free the frames of.
+void cbin_writer_destroy_frames(cbin_writer_t *writer);
+
+/// Resets a writer to a clean state, flushing writers discard the bytes that
+/// have not been flushed yet.
 /// \param writer The writer to reset.
 void cbin_writer_reset(cbin_writer_t *writer);
 
@@ -53,6 +207,13 @@ void cbin_writer_discard_error(cbin_writer_t *writer);
 /// \code CBIN_ERR_OUT_OF_BOUNDS \endcode
 cbin_err_t cbin_writer_seek(cbin_writer_t *writer, size_t position);
 
+/// Hands the bytes before the current position to the sink of a flushing
+/// writer, a no-op for other writers.
+/// \param writer The writer to flush.
+/// \return \code CBIN_ERR_OK \endcode
+/// or the error returned by the sink.
+cbin_err_t cbin_writer_flush(cbin_writer_t *writer);
+
 /// Reserves a number of bytes in the writer and advances the position.
 /// \param writer The writer to reserve bytes in.
 /// \param count The number of bytes to reserve.
@@ -61,6 +222,35 @@ cbin_err_t cbin_writer_seek(cbin_writer_t *writer, size_t position);
 /// \code CBIN_ERR_OUT_OF_MEMORY \endcode
 cbin_err_t cbin_writer_reserve(cbin_writer_t *writer, size_t count, void **out);
 
+/// Makes room for a number of bytes in the writer without advancing the
+/// position, so that they can be written with the unchecked accessors.
+/// \param writer The writer to make room in.
+/// \param count The number of bytes that will be written.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_ensure(cbin_writer_t *writer, size_t count);
+
+/// Appends a caller-owned blob to a segmented writer by reference, the blob
+/// must stay alive and unchanged until the output has been consumed. Blobs
+/// smaller than CBIN_SPLICE_MIN, and blobs given to other writers, are
+/// copied with cbin_write instead.
+/// \param writer The writer to append to.
+/// \param data The blob to append.
+/// \param size The size of the blob.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+/// \code CBIN_ERR_FAILED \endcode if the position is not at the end.
+cbin_err_t cbin_writer_splice(cbin_writer_t *writer, const void *data,
+                              size_t size);
+
+/// Returns the output of a segmented writer as a list of segments. The list
+/// stays valid until the next operation on the writer.
+/// \param writer The writer to get the segments of.
+/// \param count Receives the number of segments.
+/// \return The segments, NULL for writers that are not segmented.
+const cbin_iovec_t *cbin_writer_segments(cbin_writer_t *writer,
+                                         size_t *count);
+
 /// Writes a single byte to the writer.
 /// \param writer The writer to write to.
 /// \param value The value to write.
@@ -69,7 +259,9 @@ cbin_err_t cbin_writer_reserve(cbin_writer_t *writer, size_t count, void **out);
 /// \code CBIN_ERR_OUT_OF_MEMORY \endcode
 cbin_err_t cbin_writer_fill(cbin_writer_t *writer, uint8_t value, size_t count);
 
-/// Returns the current buffer of the writer.
+/// Returns the current buffer of the writer, for flushing writers this only
+/// holds the bytes that have not been flushed yet and for segmented writers
+/// it is the current chunk.
 /// \param writer The writer to get the buffer of.
 /// \return The current buffer of the writer.
 const void *cbin_writer_buffer(const cbin_writer_t *writer);
@@ -132,6 +324,225 @@ cbin_err_t cbin_write_f64_be(cbin_writer_t *writer, double value);
 
 cbin_err_t cbin_write_bool(cbin_writer_t *writer, bool value);
 
+/// Writes an array of values with a single reservation, byte-swapping the
+/// whole span with vectorized kernels when the endianness differs.
+/// \param writer The writer to write to.
+/// \param values The values to write.
+/// \param count The number of values to write.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_write_u16_le_array(cbin_writer_t *writer,
+                                   const uint16_t *values, size_t count);
+cbin_err_t cbin_write_u16_be_array(cbin_writer_t *writer,
+                                   const uint16_t *values, size_t count);
+
+cbin_err_t cbin_write_u32_le_array(cbin_writer_t *writer,
+                                   const uint32_t *values, size_t count);
+cbin_err_t cbin_write_u32_be_array(cbin_writer_t *writer,
+                                   const uint32_t *values, size_t count);
+
+cbin_err_t cbin_write_u64_le_array(cbin_writer_t *writer,
+                                   const uint64_t *values, size_t count);
+cbin_err_t cbin_write_u64_be_array(cbin_writer_t *writer,
+                                   const uint64_t *values, size_t count);
+
+cbin_err_t cbin_write_i16_le_array(cbin_writer_t *writer,
+                                   const int16_t *values, size_t count);
+cbin_err_t cbin_write_i16_be_array(cbin_writer_t *writer,
+                                   const int16_t *values, size_t count);
+
+cbin_err_t cbin_write_i32_le_array(cbin_writer_t *writer,
+                                   const int32_t *values, size_t count);
+cbin_err_t cbin_write_i32_be_array(cbin_writer_t *writer,
+                                   const int32_t *values, size_t count);
+
+cbin_err_t cbin_write_i64_le_array(cbin_writer_t *writer,
+                                   const int64_t *values, size_t count);
+cbin_err_t cbin_write_i64_be_array(cbin_writer_t *writer,
+                                   const int64_t *values, size_t count);
+
+cbin_err_t cbin_write_f32_le_array(cbin_writer_t *writer,
+                                   const float *values, size_t count);
+cbin_err_t cbin_write_f32_be_array(cbin_writer_t *writer,
+                                   const float *values, size_t count);
+
+cbin_err_t cbin_write_f64_le_array(cbin_writer_t *writer,
+                                   const double *values, size_t count);
+cbin_err_t cbin_write_f64_be_array(cbin_writer_t *writer,
+                                   const double *values, size_t count);
+
+/// Copies the counters of a writer, see stats.h.
+/// \param writer The writer to get the counters of.
+/// \param stats Receives the counters, all 0 without CBIN_STATS.
+/// \return Whether the library was built with CBIN_STATS.
+bool cbin_writer_get_stats(const cbin_writer_t *writer,
+                           cbin_writer_stats_t *stats);
+
+/// Adds the counters of a writer to the global registry and clears them.
+/// cbin_writer_destroy and cbin_pool_release publish them as well, so this
+/// is only needed for long lived writers.
+/// \param writer The writer to publish the counters of.
+void cbin_writer_publish_stats(cbin_writer_t *writer);
+
+/// Starts a checksummed region at the current position. Every byte written
+/// until the region ends is added to the checksum, in blocks as writing goes
+/// on. Inside a region the writer can only seek back over the bytes that
+/// have not been added yet, at least the last CBIN_CHECKSUM_BLOCK bytes.
+/// \param writer The writer to checksum.
+/// \param checksum The checksum to update, which must outlive the region.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if a region is already open.
+cbin_err_t cbin_writer_begin_checksum(cbin_writer_t *writer,
+                                      struct cbin_checksum_s *checksum);
+
+/// Ends the checksummed region, adding the bytes up to the current position
+/// to the checksum.
+/// \param writer The writer to stop checksumming.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no region is open or a frame is
+/// still open, see cbin_writer_begin_frame.
+cbin_err_t cbin_writer_end_checksum(cbin_writer_t *writer);
+
+/// Ends the checksummed region and writes its checksum right after it, as a
+/// u32_le for CRC-32C or a u64_le for xxHash64.
+/// \param writer The writer to write to.
+/// \return \code CBIN_ERR_OK \endcode
+/// \code CBIN_ERR_FAILED \endcode if no region is open or a frame is
+/// still open.
+/// \code CBIN_ERR_OUT_OF_MEMORY \endcode
+cbin_err_t cbin_writer_write_checksum(cbin_writer_t *writer);
+
+// Unchecked accessors, only valid after a successful cbin_writer_ensure
+// covering every byte they produce.
+
+static inline void cbin_writer_advance_unchecked(cbin_writer_t *writer,
+                                                 size_t count) {
+    writer->_position += count;
+    if (writer->_position > writer->_written)
+        writer->_written = writer->_position;
+}
+static inline void cbin_write_u8_unchecked(cbin_writer_t *writer,
+                                           uint8_t value) {
+    ((uint8_t *)writer->_buffer)[writer->_position] = value;
+    cbin_writer_advance_unchecked(writer, 1);
+}
+static inline void cbin_write_i8_unchecked(cbin_writer_t *writer,
+                                           int8_t value) {
+    cbin_write_u8_unchecked(writer, (uint8_t)value);
+}
+static inline void cbin_write_bool_unchecked(cbin_writer_t *writer,
+                                             bool value) {
+    cbin_write_u8_unchecked(writer, value ? 1 : 0);
+}
+
+static inline void cbin_write_u16_le_unchecked(cbin_writer_t *writer,
+                                               uint16_t value) {
+    cbin_store_u16_le((uint8_t *)writer->_buffer + writer->_position,
+                      (uint16_t)value);
+    cbin_writer_advance_unchecked(writer, 2);
+}
+static inline void cbin_write_u16_be_unchecked(cbin_writer_t *writer,
+                                               uint16_t value) {
+    cbin_store_u16_be((uint8_t *)writer->_buffer + writer->_position,
+                      (uint16_t)value);
+    cbin_writer_advance_unchecked(writer, 2);
+}
+
+static inline void cbin_write_i16_le_unchecked(cbin_writer_t *writer,
+                                               int16_t value) {
+    cbin_store_u16_le((uint8_t *)writer->_buffer + writer->_position,
+                      (uint16_t)value);
+    cbin_writer_advance_unchecked(writer, 2);
+}
+static inline void cbin_write_i16_be_unchecked(cbin_writer_t *writer,
+                                               int16_t value) {
+    cbin_store_u16_be((uint8_t *)writer->_buffer + writer->_position,
+                      (uint16_t)value);
+    cbin_writer_advance_unchecked(writer, 2);
+}
+
+static inline void cbin_write_u32_le_unchecked(cbin_writer_t *writer,
+                                               uint32_t value) {
+    cbin_store_u32_le((uint8_t *)writer->_buffer + writer->_position,
+                      (uint32_t)value);
+    cbin_writer_advance_unchecked(writer, 4);
+}
+static inline void cbin_write_u32_be_unchecked(cbin_writer_t *writer,
+                                               uint32_t value) {
+    cbin_store_u32_be((uint8_t *)writer->_buffer + writer->_position,
+                      (uint32_t)value);
+    cbin_writer_advance_unchecked(writer, 4);
+}
+
+static inline void cbin_write_i32_le_unchecked(cbin_writer_t *writer,
+                                               int32_t value) {
+    cbin_store_u32_le((uint8_t *)writer->_buffer + writer->_position,
+                      (uint32_t)value);
+    cbin_writer_advance_unchecked(writer, 4);
+}
+static inline void cbin_write_i32_be_unchecked(cbin_writer_t *writer,
+                                               int32_t value) {
+    cbin_store_u32_be((uint8_t *)writer->_buffer + writer->_position,
+                      (uint32_t)value);
+    cbin_writer_advance_unchecked(writer, 4);
+}
+
+static inline void cbin_write_u64_le_unchecked(cbin_writer_t *writer,
+                                               uint64_t value) {
+    cbin_store_u64_le((uint8_t *)writer->_buffer + writer->_position,
+                      (uint64_t)value);
+    cbin_writer_advance_unchecked(writer, 8);
+}
+static inline void cbin_write_u64_be_unchecked(cbin_writer_t *writer,
+                                               uint64_t value) {
+    cbin_store_u64_be((uint8_t *)writer->_buffer + writer->_position,
+                      (uint64_t)value);
+    cbin_writer_advance_unchecked(writer, 8);
+}
+
+static inline void cbin_write_i64_le_unchecked(cbin_writer_t *writer,
+                                               int64_t value) {
+    cbin_store_u64_le((uint8_t *)writer->_buffer + writer->_position,
+                      (uint64_t)value);
+    cbin_writer_advance_unchecked(writer, 8);
+}
+static inline void cbin_write_i64_be_unchecked(cbin_writer_t *writer,
+                                               int64_t value) {
+    cbin_store_u64_be((uint8_t *)writer->_buffer + writer->_position,
+                      (uint64_t)value);
+    cbin_writer_advance_unchecked(writer, 8);
+}
+
+static inline void cbin_write_f32_le_unchecked(cbin_writer_t *writer,
+                                               float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    cbin_store_u32_le((uint8_t *)writer->_buffer + writer->_position, bits);
+    cbin_writer_advance_unchecked(writer, 4);
+}
+static inline void cbin_write_f32_be_unchecked(cbin_writer_t *writer,
+                                               float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    cbin_store_u32_be((uint8_t *)writer->_buffer + writer->_position, bits);
+    cbin_writer_advance_unchecked(writer, 4);
+}
+
+static inline void cbin_write_f64_le_unchecked(cbin_writer_t *writer,
+                                               double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    cbin_store_u64_le((uint8_t *)writer->_buffer + writer->_position, bits);
+    cbin_writer_advance_unchecked(writer, 8);
+}
+static inline void cbin_write_f64_be_unchecked(cbin_writer_t *writer,
+                                               double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    cbin_store_u64_be((uint8_t *)writer->_buffer + writer->_position, bits);
+    cbin_writer_advance_unchecked(writer, 8);
+}
+
 CBIN_HEADER_END
 
 #endif // CBIN_SRC_CBIN_WRITER_H
@@ -0,0 +1,137 @@
+// Parallel encoding and decoding of containers.
+#include <cbin/container.h>
+#include <cbin/thread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);    \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+#define FRAME_COUNT 1000
+#define CORRUPT_FRAME 0
+
+// Frames of uneven sizes, some of them empty, so that workers finish them
+// out of order. The first frame is claimed first and holds the others back.
+static size_t frame_values(size_t index) { return (index * 37 + 11) % 200; }
+
+static cbin_err_t encode_frame(void *user_data, size_t index,
+                               cbin_writer_t *writer) {
+    (void)user_data;
+    for (size_t i = 0; i < frame_values(index); i++)
+        cbin_write_u32_le(writer, (uint32_t)(index * 1000 + i));
+    return cbin_writer_error(writer);
+}
+
+typedef struct decode_state_s {
+    volatile size_t decoded;
+    volatile size_t released;
+    size_t seen[FRAME_COUNT];
+} decode_state_t;
+
+static cbin_err_t decode_frame(void *user_data, size_t index,
+                               cbin_reader_t *reader) {
+    decode_state_t *state = (decode_state_t *)user_data;
+    // Every other frame waits until the first one is decoded, so when that
+    // one is corrupt the stop is observed while most frames are unclaimed.
+    while (index != CORRUPT_FRAME && !cbin_atomic_load_size(&state->released))
+        cbin_thread_yield();
+    cbin_err_t err = CBIN_ERR_OK;
+    if (cbin_reader_size(reader) != frame_values(index) * 4)
+        err = CBIN_ERR_CORRUPT;
+    for (size_t i = 0; !err && i < frame_values(index); i++) {
+        uint32_t value = 0;
+        cbin_read_u32_le(reader, &value);
+        if (value != index * 1000 + i)
+            err = CBIN_ERR_CORRUPT;
+    }
+    if (index == CORRUPT_FRAME)
+        cbin_atomic_fetch_add(&state->released, 1);
+    state->seen[index]++;
+    cbin_atomic_fetch_add(&state->decoded, 1);
+    return err;
+}
+
+// The container a single thread writes frame by frame.
+static int encode_serial(cbin_writer_t *writer) {
+    cbin_container_writer_t container;
+    CHECK(!cbin_writer_init_dynamic(writer, 0));
+    CHECK(!cbin_container_writer_init(&container, writer));
+    for (size_t i = 0; i < FRAME_COUNT; i++) {
+        CHECK(!cbin_container_begin_frame(&container));
+        CHECK(!encode_frame(NULL, i, writer));
+        CHECK(!cbin_container_end_frame(&container));
+    }
+    CHECK(!cbin_container_finish(&container));
+    cbin_container_writer_destroy(&container);
+    return 0;
+}
+
+static int test_round_trip(size_t threads, const cbin_writer_t *expected) {
+    cbin_writer_t writer;
+    CHECK(!cbin_writer_init_dynamic(&writer, 0));
+    CHECK(!cbin_container_encode_parallel(&writer, FRAME_COUNT, threads,
+                                          encode_frame, NULL));
+    size_t size = cbin_writer_position(&writer);
+    CHECK(size == cbin_writer_position(expected));
+    CHECK(!memcmp(cbin_writer_buffer(&writer), cbin_writer_buffer(expected),
+                  size));
+
+    cbin_container_t container;
+    CHECK(!cbin_container_open(&container, cbin_writer_buffer(&writer), size));
+    CHECK(cbin_container_frame_count(&container) == FRAME_COUNT);
+    decode_state_t *state = (decode_state_t *)calloc(1, sizeof(*state));
+    CHECK(state);
+    CHECK(!cbin_container_decode_parallel(&container, threads, decode_frame,
+                                          state));
+    CHECK(state->decoded == FRAME_COUNT);
+    for (size_t i = 0; i < FRAME_COUNT; i++)
+        CHECK(state->seen[i] == 1);
+    free(state);
+    cbin_writer_destroy(&writer);
+    return 0;
+}
+
+// A frame whose payload does not decode stops the other workers, and its
+// error is the result.
+static int test_corrupt_frame(size_t threads, const cbin_writer_t *expected) {
+    size_t size = cbin_writer_position(expected);
+    uint8_t *data = (uint8_t *)malloc(size);
+    CHECK(data);
+    memcpy(data, cbin_writer_buffer(expected), size);
+    cbin_container_t container;
+    CHECK(!cbin_container_open(&container, data, size));
+    cbin_reader_t reader;
+    CHECK(!cbin_container_frame(&container, CORRUPT_FRAME, &reader));
+    CHECK(cbin_reader_size(&reader) > 0);
+    data[(const uint8_t *)cbin_reader_buffer(&reader) - data] ^= 0xFF;
+
+    decode_state_t *state = (decode_state_t *)calloc(1, sizeof(*state));
+    CHECK(state);
+    CHECK(cbin_container_decode_parallel(&container, threads, decode_frame,
+                                         state) == CBIN_ERR_CORRUPT);
+    CHECK(state->released == 1);
+    CHECK(state->decoded < FRAME_COUNT);
+    free(state);
+    free(data);
+    return 0;
+}
+
+int main(void) {
+    cbin_writer_t expected;
+    if (encode_serial(&expected))
+        return 1;
+    int failed = 0;
+    const size_t threads[] = {1, 2, 4, 8};
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        failed |= test_round_trip(threads[i], &expected);
+        failed |= test_corrupt_frame(threads[i], &expected);
+    }
+    cbin_writer_destroy(&expected);
+    return failed;
+}
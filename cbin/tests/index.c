@@ -0,0 +1,96 @@
+// Lookups in each index layout, of the keys it holds and of absent ones.
+#include <cbin/index.h>
+#include <stdio.h>
+
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);    \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+// Keys are odd and spread over the whole range, so any even key is absent.
+static uint64_t key_of(size_t i) {
+    uint64_t key = (uint64_t)(i + 1) * 0x9E3779B97F4A7C15ull;
+    return key | 1;
+}
+
+static int test_layout(unsigned layout, size_t count) {
+    cbin_writer_t writer;
+    CHECK(!cbin_writer_init_dynamic(&writer, 0));
+    cbin_index_writer_t builder;
+    cbin_index_writer_init(&builder, &writer);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(!cbin_index_add(&builder, key_of(i)));
+        cbin_write_u64_le(&writer, key_of(i));
+        cbin_write_u32_le(&writer, (uint32_t)i);
+    }
+    CHECK(!cbin_index_finish(&builder, layout));
+    cbin_index_writer_destroy(&builder);
+    CHECK(!cbin_writer_error(&writer));
+
+    size_t size = cbin_writer_position(&writer);
+    cbin_index_t index;
+    CHECK(!cbin_index_open(&index, cbin_writer_buffer(&writer), size));
+    CHECK(cbin_index_count(&index) == count);
+    cbin_reader_t reader;
+    cbin_reader_init(&reader, cbin_writer_buffer(&writer), size);
+    for (size_t i = 0; i < count; i++) {
+        size_t offset = 0;
+        CHECK(!cbin_index_find(&index, key_of(i), &offset));
+        CHECK(offset == i * 12);
+        uint64_t key = 0;
+        uint32_t value = 0;
+        CHECK(!cbin_index_seek(&index, &reader, key_of(i)));
+        CHECK(!cbin_read_u64_le(&reader, &key));
+        CHECK(!cbin_read_u32_le(&reader, &value));
+        CHECK(key == key_of(i) && value == i);
+    }
+
+    // Absent keys between, below and above the present ones.
+    for (size_t i = 0; i < count + 16; i++) {
+        size_t offset = 0;
+        CHECK(cbin_index_find(&index, key_of(i) - 1, &offset) ==
+              CBIN_ERR_FAILED);
+        CHECK(cbin_index_find(&index, key_of(i) + 1, &offset) ==
+              CBIN_ERR_FAILED);
+    }
+    size_t offset = 0;
+    CHECK(cbin_index_find(&index, 0, &offset) == CBIN_ERR_FAILED);
+    CHECK(cbin_index_find(&index, UINT64_MAX - 1, &offset) ==
+          CBIN_ERR_FAILED);
+    size_t position = cbin_reader_position(&reader);
+    CHECK(cbin_index_seek(&index, &reader, 2) == CBIN_ERR_FAILED);
+    CHECK(cbin_reader_position(&reader) == position);
+    cbin_writer_destroy(&writer);
+    return 0;
+}
+
+static int test_duplicate(unsigned layout) {
+    cbin_writer_t writer;
+    CHECK(!cbin_writer_init_dynamic(&writer, 0));
+    cbin_index_writer_t builder;
+    cbin_index_writer_init(&builder, &writer);
+    for (size_t i = 0; i < 10; i++) {
+        CHECK(!cbin_index_add(&builder, key_of(i % 9)));
+        cbin_write_u64_le(&writer, key_of(i));
+    }
+    CHECK(cbin_index_finish(&builder, layout) == CBIN_ERR_FAILED);
+    cbin_index_writer_destroy(&builder);
+    cbin_writer_destroy(&writer);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    const unsigned layouts[] = {CBIN_INDEX_SORTED, CBIN_INDEX_EYTZINGER,
+                                CBIN_INDEX_HASH};
+    const size_t counts[] = {0, 1, 2, 7, 8, 9, 100, 4096, 10000};
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+            failed |= test_layout(layouts[l], counts[c]);
+        failed |= test_duplicate(layouts[l]);
+    }
+    return failed;
+}
@@ -0,0 +1,128 @@
+// Ring readers fed in pieces, on the heap fallback and the mirrored mapping.
+#include <cbin/reader.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);    \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+#define MESSAGE_COUNT 2000
+#define MESSAGE_MAX 40
+
+static uint32_t g_state = 0x12345678;
+
+static uint32_t next_random(void) {
+    g_state ^= g_state << 13;
+    g_state ^= g_state >> 17;
+    g_state ^= g_state << 5;
+    return g_state;
+}
+
+// Consumed bytes of a heap ring are only moved down when enough of them
+// pile up, until then the free space is the tail of the buffer.
+static int test_heap_space(void) {
+    uint8_t data[100];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)i;
+    cbin_reader_t reader;
+    CHECK(!cbin_reader_init_ring(&reader, 100));
+    CHECK(!reader._mirrored);
+    CHECK(!cbin_reader_append(&reader, data, 60));
+    uint8_t out[30];
+    CHECK(!cbin_read(&reader, out, 30));
+    CHECK(!memcmp(out, data, 30));
+
+    size_t space;
+    uint8_t *tail = (uint8_t *)cbin_reader_ring_space(&reader, &space);
+    CHECK(space == 40);
+    CHECK(cbin_reader_ring_commit(&reader, space + 1) ==
+          CBIN_ERR_OUT_OF_BOUNDS);
+    CHECK(cbin_reader_append(&reader, data, 70) == CBIN_ERR_OUT_OF_MEMORY);
+    memcpy(tail, data + 60, space);
+    CHECK(!cbin_reader_ring_commit(&reader, space));
+
+    // Once half of the free space is behind the bytes they are moved down.
+    CHECK(!cbin_read(&reader, out, 30));
+    CHECK(!memcmp(out, data + 30, 30));
+    cbin_reader_ring_space(&reader, &space);
+    CHECK(space == 60);
+    CHECK(!cbin_reader_append(&reader, data, 60));
+    uint8_t rest[100];
+    CHECK(!cbin_read(&reader, rest, 100));
+    CHECK(!memcmp(rest, data + 60, 40));
+    CHECK(!memcmp(rest + 40, data, 60));
+    cbin_reader_destroy(&reader);
+    return 0;
+}
+
+// Length-prefixed messages arrive in random pieces. A message that is not
+// complete yet is rolled back to its checkpoint and parsed again once more
+// bytes came in.
+static int test_stream(size_t capacity) {
+    static uint8_t input[MESSAGE_COUNT * (MESSAGE_MAX + 2)];
+    size_t size = 0;
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        size_t length = next_random() % (MESSAGE_MAX + 1);
+        input[size++] = (uint8_t)length;
+        input[size++] = (uint8_t)i;
+        for (size_t j = 0; j < length; j++)
+            input[size++] = (uint8_t)(i + j);
+    }
+
+    cbin_reader_t reader;
+    CHECK(!cbin_reader_init_ring(&reader, capacity));
+    size_t fed = 0;
+    size_t parsed = 0;
+    size_t rollbacks = 0;
+    while (parsed < MESSAGE_COUNT) {
+        size_t space;
+        uint8_t *tail = (uint8_t *)cbin_reader_ring_space(&reader, &space);
+        size_t piece = next_random() % 16;
+        if (piece > space)
+            piece = space;
+        if (piece > size - fed)
+            piece = size - fed;
+        memcpy(tail, input + fed, piece);
+        CHECK(!cbin_reader_ring_commit(&reader, piece));
+        fed += piece;
+
+        for (;;) {
+            CHECK(!cbin_reader_checkpoint(&reader));
+            uint8_t length = 0, id = 0;
+            uint8_t payload[MESSAGE_MAX];
+            cbin_read_u8(&reader, &length);
+            cbin_read_u8(&reader, &id);
+            cbin_read(&reader, payload, length);
+            if (cbin_reader_error(&reader)) {
+                CHECK(cbin_reader_error(&reader) == CBIN_ERR_OUT_OF_BOUNDS);
+                CHECK(!cbin_reader_rollback(&reader));
+                CHECK(!cbin_reader_commit(&reader));
+                rollbacks++;
+                break;
+            }
+            CHECK(!cbin_reader_commit(&reader));
+            CHECK(id == (uint8_t)parsed);
+            for (size_t j = 0; j < length; j++)
+                CHECK(payload[j] == (uint8_t)(parsed + j));
+            parsed++;
+        }
+    }
+    CHECK(fed == size);
+    CHECK(rollbacks > 0);
+    cbin_reader_destroy(&reader);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    failed |= test_heap_space();
+    failed |= test_stream(MESSAGE_MAX + 2);
+    failed |= test_stream(100);
+    failed |= test_stream(64 << 10);
+    return failed;
+}
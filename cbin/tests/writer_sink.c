@@ -0,0 +1,115 @@
+// Seeking and flushing of writers initialized with cbin_writer_init_sink.
+#include <cbin/writer.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);    \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+#define BUFFER_SIZE 64
+
+typedef struct output_s {
+    uint8_t data[4096];
+    size_t size;
+    size_t calls;
+} output_t;
+
+static cbin_err_t output_sink(void *user_data, const void *data, size_t size) {
+    output_t *output = (output_t *)user_data;
+    if (output->size + size > sizeof(output->data))
+        return CBIN_ERR_IO;
+    memcpy(output->data + output->size, data, size);
+    output->size += size;
+    output->calls++;
+    return CBIN_ERR_OK;
+}
+
+// A placeholder written first is patched by seeking back to it, as long as
+// nothing has been flushed yet.
+static int test_patch_in_window(void) {
+    output_t output = {0};
+    cbin_writer_t writer;
+    CHECK(!cbin_writer_init_sink(&writer, BUFFER_SIZE, output_sink, &output));
+    CHECK(!cbin_write_u32_le(&writer, 0));
+    for (uint8_t i = 0; i < 40; i++)
+        CHECK(!cbin_write_u8(&writer, i));
+    CHECK(!cbin_writer_seek(&writer, 0));
+    CHECK(!cbin_write_u32_le(&writer, 0xA1B2C3D4));
+    // The bytes after the patch are kept, not truncated.
+    CHECK(cbin_writer_position(&writer) == 4);
+    CHECK(!cbin_writer_seek(&writer, 44));
+    for (uint8_t i = 0; i < 100; i++)
+        CHECK(!cbin_write_u8(&writer, (uint8_t)(40 + i)));
+    CHECK(!cbin_writer_flush(&writer));
+    cbin_writer_destroy(&writer);
+
+    CHECK(output.size == 144);
+    CHECK(output.data[0] == 0xD4 && output.data[3] == 0xA1);
+    for (size_t i = 0; i < 140; i++)
+        CHECK(output.data[4 + i] == i);
+    return 0;
+}
+
+// Flushed bytes are gone: seeking before them fails and leaves the writer in
+// error until the error is discarded.
+static int test_seek_before_flushed(void) {
+    output_t output = {0};
+    cbin_writer_t writer;
+    CHECK(!cbin_writer_init_sink(&writer, BUFFER_SIZE, output_sink, &output));
+    for (uint8_t i = 0; i < 100; i++)
+        CHECK(!cbin_write_u8(&writer, i));
+    CHECK(output.size > 0);
+    size_t flushed = output.size;
+    CHECK(cbin_writer_seek(&writer, flushed - 1) == CBIN_ERR_OUT_OF_BOUNDS);
+    CHECK(cbin_writer_error(&writer) == CBIN_ERR_OUT_OF_BOUNDS);
+    CHECK(cbin_write_u8(&writer, 0) == CBIN_ERR_OUT_OF_BOUNDS);
+    cbin_writer_discard_error(&writer);
+    // The first byte that was not flushed can still be sought to.
+    CHECK(!cbin_writer_seek(&writer, flushed));
+    CHECK(!cbin_writer_seek(&writer, 100));
+    CHECK(!cbin_writer_flush(&writer));
+    cbin_writer_destroy(&writer);
+
+    CHECK(output.size == 100);
+    for (size_t i = 0; i < 100; i++)
+        CHECK(output.data[i] == i);
+    return 0;
+}
+
+// A write larger than the buffer goes to the sink directly, after the
+// bytes buffered before it.
+static int test_direct_write(void) {
+    output_t output = {0};
+    uint8_t large[BUFFER_SIZE * 8];
+    for (size_t i = 0; i < sizeof(large); i++)
+        large[i] = (uint8_t)(i * 7);
+    cbin_writer_t writer;
+    CHECK(!cbin_writer_init_sink(&writer, BUFFER_SIZE, output_sink, &output));
+    CHECK(!cbin_write_u32_le(&writer, 0x01020304));
+    CHECK(!cbin_write(&writer, large, sizeof(large)));
+    CHECK(output.size == 4 + sizeof(large));
+    CHECK(output.calls == 2);
+    CHECK(cbin_writer_position(&writer) == 4 + sizeof(large));
+    CHECK(!cbin_write_u8(&writer, 0xEE));
+    CHECK(!cbin_writer_flush(&writer));
+    cbin_writer_destroy(&writer);
+
+    CHECK(output.size == 5 + sizeof(large));
+    CHECK(output.data[0] == 0x04 && output.data[3] == 0x01);
+    CHECK(!memcmp(output.data + 4, large, sizeof(large)));
+    CHECK(output.data[4 + sizeof(large)] == 0xEE);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    failed |= test_patch_in_window();
+    failed |= test_seek_before_flushed();
+    failed |= test_direct_write();
+    return failed;
+}